@@ -0,0 +1,477 @@
+/* Micro-benchmarks of the hot paths in the bundled libtickit.
+ *
+ * Built and run by
+ *   $ ./Build bench
+ *
+ * Any arguments given to the bench program itself select just those cases
+ * whose name contains one of them. Every case reports the time taken per
+ * operation, and the number of bytes it sent to the terminal per operation,
+ * as counted by a terminal output function.
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include "tickit.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define MIN_SECONDS 0.25
+
+#define RB_LINES 50
+#define RB_COLS  200
+
+#define N_PENS 8
+
+#define N_SMALLRECTS 1000
+
+static size_t out_bytes;
+
+static void count_output(TickitTerm *tt, const char *bytes, size_t len, void *user)
+{
+  (void)tt;
+  (void)bytes;
+  (void)user;
+
+  out_bytes += len;
+}
+
+static TickitTerm *new_term(const char *termtype)
+{
+  TickitTerm *tt = tickit_term_new_for_termtype(termtype);
+  if(!tt)
+    return NULL;
+
+  tickit_term_set_output_func(tt, count_output, NULL);
+  tickit_term_set_output_buffer(tt, 4096);
+  tickit_term_set_size(tt, RB_LINES, RB_COLS);
+
+  return tt;
+}
+
+static TickitPen *pens[N_PENS];
+
+static void init_pens(void)
+{
+  for(int i = 0; i < N_PENS; i++) {
+    pens[i] = tickit_pen_new();
+    tickit_pen_set_colour_attr(pens[i], TICKIT_PEN_FG, i);
+    tickit_pen_set_colour_attr(pens[i], TICKIT_PEN_BG, (i * 3) % 8);
+    tickit_pen_set_bool_attr(pens[i], TICKIT_PEN_BOLD, i & 1);
+    tickit_pen_set_bool_attr(pens[i], TICKIT_PEN_UNDER, i & 2);
+  }
+}
+
+/*
+ * RenderBuffer fills, flushed to an xterm
+ */
+
+static TickitTerm *xterm;
+static TickitRenderBuffer *rb;
+
+static char ascii_line[RB_COLS + 1];
+
+static void setup_render(void)
+{
+  xterm = new_term("xterm");
+  rb = tickit_renderbuffer_new(RB_LINES, RB_COLS);
+
+  for(int i = 0; i < RB_COLS; i++)
+    ascii_line[i] = 'A' + (i % 26);
+  ascii_line[RB_COLS] = 0;
+}
+
+static void teardown_render(void)
+{
+  tickit_renderbuffer_destroy(rb);
+  tickit_term_destroy(xterm);
+}
+
+static void run_render_text(void)
+{
+  for(int line = 0; line < RB_LINES; line++)
+    tickit_renderbuffer_text_at(rb, line, 0, ascii_line, pens[line % N_PENS]);
+
+  tickit_renderbuffer_flush_to_term(rb, xterm);
+  tickit_term_flush(xterm);
+}
+
+// A narrow window onto long lines, as a log viewer draws
+#define LONG_LINE_BYTES 4096
+
+static char long_line[LONG_LINE_BYTES + 1];
+
+static void setup_render_long(void)
+{
+  setup_render();
+
+  for(int i = 0; i < LONG_LINE_BYTES; i++)
+    long_line[i] = 'a' + (i % 26);
+  long_line[LONG_LINE_BYTES] = 0;
+}
+
+static void run_render_long_clipped(void)
+{
+  TickitRect clip;
+  tickit_rect_init_sized(&clip, 0, 0, RB_LINES, 20);
+  tickit_renderbuffer_clip(rb, &clip);
+
+  for(int line = 0; line < RB_LINES; line++)
+    tickit_renderbuffer_textn_at_clipped(rb, line, 0, long_line, LONG_LINE_BYTES, pens[line % N_PENS]);
+
+  tickit_renderbuffer_flush_to_term(rb, xterm);
+  tickit_term_flush(xterm);
+}
+
+static void run_render_erase(void)
+{
+  for(int line = 0; line < RB_LINES; line++)
+    for(int col = 0; col < RB_COLS; col += 20)
+      tickit_renderbuffer_erase_at(rb, line, col, 20, pens[(line + col / 20) % N_PENS]);
+
+  tickit_renderbuffer_flush_to_term(rb, xterm);
+  tickit_term_flush(xterm);
+}
+
+static void run_render_hline(void)
+{
+  for(int line = 0; line < RB_LINES; line += 2)
+    tickit_renderbuffer_hline_at(rb, line, 0, RB_COLS - 1, TICKIT_LINE_SINGLE,
+        pens[line % N_PENS], TICKIT_LINECAP_BOTH);
+  for(int col = 0; col < RB_COLS; col += 10)
+    tickit_renderbuffer_vline_at(rb, 0, RB_LINES - 1, col, TICKIT_LINE_SINGLE,
+        pens[col % N_PENS], TICKIT_LINECAP_BOTH);
+
+  tickit_renderbuffer_flush_to_term(rb, xterm);
+  tickit_term_flush(xterm);
+}
+
+// The whole buffer drawn as a grid of tiles, one after another or on threads
+#define TILE_LINES 10
+#define TILE_COLS  50
+#define N_TILES ((RB_LINES / TILE_LINES) * (RB_COLS / TILE_COLS))
+
+static TickitRect tilerects[N_TILES];
+
+static void setup_render_tiles(void)
+{
+  setup_render();
+
+  for(int i = 0; i < N_TILES; i++)
+    tickit_rect_init_sized(&tilerects[i],
+        (i / (RB_COLS / TILE_COLS)) * TILE_LINES, (i % (RB_COLS / TILE_COLS)) * TILE_COLS,
+        TILE_LINES, TILE_COLS);
+}
+
+static void draw_tile(TickitRenderBuffer *tile, const TickitRect *rect, void *data)
+{
+  (void)data;
+
+  for(int line = rect->top; line < tickit_rect_bottom(rect); line++) {
+    tickit_renderbuffer_text_at(tile, line, rect->left, ascii_line + rect->left, pens[line % N_PENS]);
+    tickit_renderbuffer_erase_at(tile, line, rect->left + 30, 10, pens[(line + 1) % N_PENS]);
+  }
+  tickit_renderbuffer_hline_at(tile, rect->top, rect->left, tickit_rect_right(rect) - 1,
+      TICKIT_LINE_SINGLE, NULL, TICKIT_LINECAP_BOTH);
+}
+
+static void flush_tiles(void)
+{
+  tickit_renderbuffer_flush_to_term(rb, xterm);
+  tickit_term_flush(xterm);
+}
+
+static void run_render_tiles_serial(void)
+{
+  for(int i = 0; i < N_TILES; i++) {
+    tickit_renderbuffer_save(rb);
+    tickit_renderbuffer_clip(rb, &tilerects[i]);
+    draw_tile(rb, &tilerects[i], NULL);
+    tickit_renderbuffer_restore(rb);
+  }
+
+  flush_tiles();
+}
+
+static void run_render_tiled_1(void)
+{
+  tickit_renderbuffer_render_tiled(rb, tilerects, N_TILES, draw_tile, NULL, 1);
+  flush_tiles();
+}
+
+static void run_render_tiled_4(void)
+{
+  tickit_renderbuffer_render_tiled(rb, tilerects, N_TILES, draw_tile, NULL, 4);
+  flush_tiles();
+}
+
+// One frame shown on several terminals; mirrors all of the same type are
+// sent what the first is, so the frame is encoded only once
+#define N_MIRRORS 4
+
+static TickitTerm *mirrors[N_MIRRORS];
+
+static void setup_render_mirrors(void)
+{
+  setup_render();
+
+  mirrors[0] = xterm;
+  for(int i = 1; i < N_MIRRORS; i++)
+    mirrors[i] = new_term("xterm");
+}
+
+static void teardown_render_mirrors(void)
+{
+  for(int i = 1; i < N_MIRRORS; i++)
+    tickit_term_destroy(mirrors[i]);
+
+  teardown_render();
+}
+
+static void draw_text(void)
+{
+  for(int line = 0; line < RB_LINES; line++)
+    tickit_renderbuffer_text_at(rb, line, 0, ascii_line, pens[line % N_PENS]);
+}
+
+static void run_render_flush_each(void)
+{
+  for(int i = 0; i < N_MIRRORS; i++) {
+    draw_text();
+    tickit_renderbuffer_flush_to_term(rb, mirrors[i]);
+    tickit_term_flush(mirrors[i]);
+  }
+}
+
+static void run_render_flush_terms(void)
+{
+  draw_text();
+  tickit_renderbuffer_flush_to_terms(rb, mirrors, N_MIRRORS);
+  for(int i = 0; i < N_MIRRORS; i++)
+    tickit_term_flush(mirrors[i]);
+}
+
+/*
+ * String counting
+ */
+
+#define CORPUS_BYTES 4096
+
+static char corpus[CORPUS_BYTES + 8];
+static size_t corpus_len;
+
+static void setup_ascii(void)
+{
+  static const char *words = "the quick brown fox jumps over the lazy dog ";
+  size_t wlen = strlen(words);
+
+  for(corpus_len = 0; corpus_len < CORPUS_BYTES; corpus_len++)
+    corpus[corpus_len] = words[corpus_len % wlen];
+  corpus[corpus_len] = 0;
+}
+
+static void setup_cjk(void)
+{
+  // Mostly wide ideographs, with some kana and the occasional ASCII space
+  static const long codepoints[] = {
+    0x65E5, 0x672C, 0x8A9E, 0x306E, 0x6587, 0x7AE0, 0x3067, 0x3059, 0x20,
+  };
+  int n = sizeof(codepoints) / sizeof(codepoints[0]);
+
+  corpus_len = 0;
+  for(int i = 0; corpus_len + 4 < CORPUS_BYTES; i++)
+    corpus_len += tickit_string_putchar(corpus + corpus_len, CORPUS_BYTES - corpus_len,
+        codepoints[i % n]);
+  corpus[corpus_len] = 0;
+}
+
+static void run_ncountmore(void)
+{
+  TickitStringPos pos, limit;
+  tickit_stringpos_zero(&pos);
+  tickit_stringpos_limit_none(&limit);
+
+  // Count in steps, as RenderBuffer does when splitting spans
+  for(int cols = 40; ; cols += 40) {
+    limit.columns = cols;
+    tickit_string_ncountmore(corpus, corpus_len, &pos, &limit);
+    if(pos.bytes >= corpus_len)
+      break;
+  }
+}
+
+/*
+ * RectSet
+ */
+
+static TickitRect smallrects[N_SMALLRECTS];
+
+static void setup_rectset(void)
+{
+  srand(1);
+  for(int i = 0; i < N_SMALLRECTS; i++)
+    tickit_rect_init_sized(&smallrects[i], rand() % 100, rand() % 300, 1 + rand() % 3, 1 + rand() % 8);
+}
+
+static void run_rectset_add(void)
+{
+  TickitRectSet *trs = tickit_rectset_new();
+
+  for(int i = 0; i < N_SMALLRECTS; i++)
+    tickit_rectset_add(trs, &smallrects[i]);
+
+  tickit_rectset_destroy(trs);
+}
+
+static void run_rectset_subtract(void)
+{
+  TickitRectSet *trs = tickit_rectset_new();
+
+  TickitRect all;
+  tickit_rect_init_sized(&all, 0, 0, 100, 300);
+  tickit_rectset_add(trs, &all);
+
+  for(int i = 0; i < N_SMALLRECTS; i++)
+    tickit_rectset_subtract(trs, &smallrects[i]);
+
+  tickit_rectset_destroy(trs);
+}
+
+/*
+ * Terminal driver encoders
+ */
+
+static TickitTerm *drvterm;
+
+static void setup_xterm_driver(void)
+{
+  drvterm = new_term("xterm");
+}
+
+static void setup_ti_driver(void)
+{
+  // Any non-xterm type is handled by the terminfo driver
+  drvterm = new_term("screen");
+  if(!drvterm)
+    drvterm = new_term("vt100");
+}
+
+static void teardown_driver(void)
+{
+  tickit_term_destroy(drvterm);
+}
+
+static void run_chpen(void)
+{
+  for(int i = 0; i < 100; i++)
+    tickit_term_setpen(drvterm, pens[i % N_PENS]);
+  tickit_term_flush(drvterm);
+}
+
+static void run_goto(void)
+{
+  for(int i = 0; i < 100; i++)
+    tickit_term_goto(drvterm, (i * 7) % RB_LINES, (i * 13) % RB_COLS);
+  tickit_term_flush(drvterm);
+}
+
+struct Case {
+  const char *name;
+  void (*setup)(void);
+  void (*run)(void);
+  void (*teardown)(void);
+  int per_run; // operations done by each call of run
+};
+
+static const struct Case cases[] = {
+  { "render_text_flush",    setup_render,       run_render_text,      teardown_render, 1 },
+  { "render_long_clipped",  setup_render_long,  run_render_long_clipped, teardown_render, 1 },
+  { "render_erase_flush",   setup_render,       run_render_erase,     teardown_render, 1 },
+  { "render_hline_flush",   setup_render,       run_render_hline,     teardown_render, 1 },
+  { "render_tiles_serial",  setup_render_tiles, run_render_tiles_serial, teardown_render, 1 },
+  { "render_tiled_1thread", setup_render_tiles, run_render_tiled_1,   teardown_render, 1 },
+  { "render_tiled_4thread", setup_render_tiles, run_render_tiled_4,   teardown_render, 1 },
+  { "render_flush_each",    setup_render_mirrors, run_render_flush_each,  teardown_render_mirrors, N_MIRRORS },
+  { "render_flush_to_terms", setup_render_mirrors, run_render_flush_terms, teardown_render_mirrors, N_MIRRORS },
+  { "string_ncount_ascii",  setup_ascii,        run_ncountmore,       NULL,            1 },
+  { "string_ncount_cjk",    setup_cjk,          run_ncountmore,       NULL,            1 },
+  { "rectset_add",          setup_rectset,      run_rectset_add,      NULL,            N_SMALLRECTS },
+  { "rectset_subtract",     setup_rectset,      run_rectset_subtract, NULL,            N_SMALLRECTS },
+  { "xterm_chpen",          setup_xterm_driver, run_chpen,            teardown_driver, 100 },
+  { "xterm_goto_abs",       setup_xterm_driver, run_goto,             teardown_driver, 100 },
+  { "terminfo_chpen",       setup_ti_driver,    run_chpen,            teardown_driver, 100 },
+  { "terminfo_goto_abs",    setup_ti_driver,    run_goto,             teardown_driver, 100 },
+};
+
+static double now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int selected(const char *name, int argc, char *argv[])
+{
+  if(argc < 2)
+    return 1;
+
+  for(int i = 1; i < argc; i++)
+    if(strstr(name, argv[i]))
+      return 1;
+
+  return 0;
+}
+
+int main(int argc, char *argv[])
+{
+  init_pens();
+
+  printf("%-22s %10s %12s %12s\n", "case", "ops", "ns/op", "bytes/op");
+
+  for(size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+    const struct Case *cs = &cases[c];
+    if(!selected(cs->name, argc, argv))
+      continue;
+
+    xterm = drvterm = NULL;
+    if(cs->setup)
+      (*cs->setup)();
+
+    if((cs->setup == setup_xterm_driver || cs->setup == setup_ti_driver) && !drvterm) {
+      printf("%-22s %10s\n", cs->name, "skipped");
+      continue;
+    }
+
+    // Warm up, and discard any output from terminal startup
+    (*cs->run)();
+
+    long runs = 1;
+    double elapsed;
+    while(1) {
+      out_bytes = 0;
+
+      double start = now();
+      for(long i = 0; i < runs; i++)
+        (*cs->run)();
+      elapsed = now() - start;
+
+      if(elapsed >= MIN_SECONDS)
+        break;
+      runs *= 2;
+    }
+
+    long ops = runs * cs->per_run;
+    printf("%-22s %10ld %12.1f %12.1f\n", cs->name, ops,
+        elapsed * 1e9 / ops, (double)out_bytes / ops);
+
+    if(cs->teardown)
+      (*cs->teardown)();
+  }
+
+  for(int i = 0; i < N_PENS; i++)
+    tickit_pen_destroy(pens[i]);
+
+  return 0;
+}
@@ -40,6 +40,18 @@ void tickit_mockterm_resize(TickitMockTerm *mt, int newlines, int newcols);
 size_t tickit_mockterm_get_display_text(TickitMockTerm *mt, char *buffer, size_t len, int line, int col, int width);
 TickitPen *tickit_mockterm_get_display_pen(TickitMockTerm *mt, int line, int col);
 
+/* Pens are interned; each distinct pen has a small integer index that stays
+ * valid for the life of the mockterm. get_display_pens fills in the index of
+ * width cells at once, and returns the number of interned pens.
+ */
+int tickit_mockterm_get_display_pens(TickitMockTerm *mt, int line, int col, int width, int penidx[]);
+TickitPen *tickit_mockterm_get_pen(TickitMockTerm *mt, int penidx);
+
+/* limit < 0 logs everything (the default), 0 disables the log, and any other
+ * value keeps just the most recent entries. Also clears the log.
+ */
+void tickit_mockterm_set_loglimit(TickitMockTerm *mt, int limit);
+
 int tickit_mockterm_loglen(TickitMockTerm *mt);
 TickitMockTermLogEntry *tickit_mockterm_peeklog(TickitMockTerm *mt, int i);
 void tickit_mockterm_clearlog(TickitMockTerm *mt);
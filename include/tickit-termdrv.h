@@ -43,7 +43,11 @@ struct TickitTermDriver {
 void *tickit_termdrv_get_tmpbuffer(TickitTermDriver *ttd, size_t len);
 void tickit_termdrv_write_str(TickitTermDriver *ttd, const char *str, size_t len);
 void tickit_termdrv_write_strf(TickitTermDriver *ttd, const char *fmt, ...);
+/* Writes n copies of the character c */
+void tickit_termdrv_write_chrfill(TickitTermDriver *ttd, char c, int n);
 TickitPen *tickit_termdrv_current_pen(TickitTermDriver *ttd);
+/* Sets -1 for either coordinate not known */
+void tickit_termdrv_current_cursor(TickitTermDriver *ttd, int *line, int *col);
 
 /*
  * Function to construct a new TickitTerm directly from a TickitTermDriver
@@ -56,6 +60,17 @@ TickitTerm *tickit_term_new_for_driver(TickitTermDriver *ttd);
  */
 TickitTermDriver *tickit_term_get_driver(TickitTerm *tt);
 
+/*
+ * For testing the terminfo driver's compiled strings. If termtype is given,
+ * src is the short name of one of its string capabilities; otherwise it is
+ * the string itself. Expands it with params both as the driver would and by
+ * unibi_run(), each into a buffer of size bytes. Returns -1 if there is no
+ * unibilium, terminal type or capability, or either output does not fit;
+ * otherwise whether the string was compiled
+ */
+int tickit_termdrv_ti_test_expand(const char *termtype, const char *src, const int params[9],
+    char *out, size_t *outlen, char *ref, size_t *reflen, size_t size);
+
 #endif
 
 #ifdef __cplusplus
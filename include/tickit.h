@@ -19,8 +19,10 @@ extern "C" {
 typedef enum {
   TICKIT_EV_RESIZE = 0x01, // Term = lines, cols
   TICKIT_EV_KEY    = 0x02, // Term = type(TickitKeyEventType), str
-  TICKIT_EV_MOUSE  = 0x04, // Term = type(TickitMouseEventType), button, line, col
+  TICKIT_EV_MOUSE  = 0x04, // Term = type(TickitMouseEventType), button, line, col, count
   TICKIT_EV_CHANGE = 0x08, // Pen = {none}
+  TICKIT_EV_TIMER  = 0x10, // Loop = {none}
+  TICKIT_EV_IO     = 0x20, // Loop = fd, cond
 
   TICKIT_EV_UNBIND = 0x80000000, // event handler is being unbound
 } TickitEventType;
@@ -55,6 +57,7 @@ typedef struct {
   int         button;      // MOUSE
   int         line, col;   // MOUSE
   int         mod;         // KEY, MOUSE
+  int         count;       // MOUSE wheel steps
 } TickitEvent;
 
 /*
@@ -164,6 +167,7 @@ size_t tickit_rectset_rects(const TickitRectSet *trs);
 size_t tickit_rectset_get_rects(const TickitRectSet *trs, TickitRect rects[], size_t n);
 
 void tickit_rectset_add(TickitRectSet *trs, const TickitRect *rect);
+void tickit_rectset_add_many(TickitRectSet *trs, const TickitRect rects[], size_t n);
 void tickit_rectset_subtract(TickitRectSet *trs, const TickitRect *rect);
 
 int tickit_rectset_intersects(const TickitRectSet *trs, const TickitRect *rect);
@@ -190,6 +194,31 @@ void tickit_term_set_output_buffer(TickitTerm *tt, size_t len);
 void tickit_term_await_started(TickitTerm *tt, const struct timeval *timeout);
 void tickit_term_flush(TickitTerm *tt);
 
+// Running totals since the terminal was created
+typedef struct {
+  unsigned long bytes;       // bytes handed to the output function or fd
+  unsigned long writes;      // write() and writev() calls made on the fd
+  unsigned long flushes;     // flushes of the output buffer
+  unsigned long setpens;     // pen changes that needed any SGR output
+  unsigned long gotos;
+  unsigned long scrollrects;
+} TickitTermStats;
+
+void tickit_term_get_stats(const TickitTerm *tt, TickitTermStats *stats);
+
+/* True if the same calls on a and b would output the same bytes; they have
+ * the same terminal type, size, colours, pen and cursor position */
+int  tickit_term_output_equiv(const TickitTerm *a, const TickitTerm *b);
+/* Until stopped, all output of tt is also written to each of the mirrors,
+ * which should be output-equivalent to it. Stopping updates their pen and
+ * cursor position to match */
+void tickit_term_start_mirror(TickitTerm *tt, TickitTerm *mirrors[], size_t n);
+void tickit_term_stop_mirror(TickitTerm *tt);
+
+/* Output a non-blocking fd would not yet accept is queued until it is writable */
+size_t tickit_term_output_pending(const TickitTerm *tt);
+void   tickit_term_output_writable(TickitTerm *tt);
+
 /* fd is allowed to be unset (-1); works abstractly */
 void tickit_term_set_input_fd(TickitTerm *tt, int fd);
 int  tickit_term_get_input_fd(const TickitTerm *tt);
@@ -197,6 +226,11 @@ int  tickit_term_get_input_fd(const TickitTerm *tt);
 int  tickit_term_get_utf8(const TickitTerm *tt);
 void tickit_term_set_utf8(TickitTerm *tt, int utf8);
 
+/* Deliver a run of drags, or of wheel steps, within one batch of input as a
+ * single event */
+int  tickit_term_get_mouse_coalesce(const TickitTerm *tt);
+void tickit_term_set_mouse_coalesce(TickitTerm *tt, int coalesce);
+
 void tickit_term_input_push_bytes(TickitTerm *tt, const char *bytes, size_t len);
 void tickit_term_input_readable(TickitTerm *tt);
 int  tickit_term_input_check_timeout(TickitTerm *tt);
@@ -237,6 +271,8 @@ typedef enum {
   TICKIT_TERMCTL_ICONTITLE_TEXT,
   TICKIT_TERMCTL_KEYPAD_APP,
   TICKIT_TERMCTL_COLORS, // read-only
+  TICKIT_TERMCTL_SYNC_OUTPUT,
+  TICKIT_TERMCTL_BCE, // read-only
 } TickitTermCtl;
 
 typedef enum {
@@ -312,6 +348,10 @@ static inline void tickit_stringpos_limit_columns(TickitStringPos *pos, int colu
   pos->columns = columns;
 }
 
+/* East Asian Ambiguous width characters count as 1 column, or 2 if set so */
+void tickit_string_set_ambiguous_width(int width);
+int  tickit_string_get_ambiguous_width(void);
+
 int    tickit_string_mbswidth(const char *str);
 int    tickit_string_byte2col(const char *str, size_t byte);
 size_t tickit_string_col2byte(const char *str, int col);
@@ -325,6 +365,17 @@ typedef struct TickitRenderBuffer TickitRenderBuffer;
 TickitRenderBuffer *tickit_renderbuffer_new(int lines, int cols);
 void tickit_renderbuffer_destroy(TickitRenderBuffer *rb);
 
+// Running totals since the buffer was created
+typedef struct {
+  unsigned long spans;         // spans of cells created by drawing
+  unsigned long pen_merges;    // drawing pens merged with the state pen
+  unsigned long text_bytes;    // bytes of text stored
+  unsigned long cells_flushed; // cells sent to a terminal
+} TickitRenderBufferStats;
+
+void tickit_renderbuffer_get_stats(const TickitRenderBuffer *rb, TickitRenderBufferStats *stats);
+
+void tickit_renderbuffer_resize(TickitRenderBuffer *rb, int lines, int cols);
 void tickit_renderbuffer_get_size(const TickitRenderBuffer *rb, int *lines, int *cols);
 
 void tickit_renderbuffer_translate(TickitRenderBuffer *rb, int downward, int rightward);
@@ -349,6 +400,11 @@ void tickit_renderbuffer_skip(TickitRenderBuffer *rb, int len);
 void tickit_renderbuffer_skip_to(TickitRenderBuffer *rb, int col);
 int tickit_renderbuffer_text_at(TickitRenderBuffer *rb, int line, int col, char *text, TickitPen *pen);
 int tickit_renderbuffer_text(TickitRenderBuffer *rb, char *text, TickitPen *pen);
+int tickit_renderbuffer_textn_at(TickitRenderBuffer *rb, int line, int col, const char *text, size_t len, TickitPen *pen);
+int tickit_renderbuffer_textn(TickitRenderBuffer *rb, const char *text, size_t len, TickitPen *pen);
+/* As textn_at, but only measures the text as far as the right edge of the
+ * clip region; returns the number of columns up to that edge */
+int tickit_renderbuffer_textn_at_clipped(TickitRenderBuffer *rb, int line, int col, const char *text, size_t len, TickitPen *pen);
 void tickit_renderbuffer_erase_at(TickitRenderBuffer *rb, int line, int col, int len, TickitPen *pen);
 void tickit_renderbuffer_erase(TickitRenderBuffer *rb, int len, TickitPen *pen);
 void tickit_renderbuffer_erase_to(TickitRenderBuffer *rb, int col, TickitPen *pen);
@@ -374,7 +430,32 @@ void tickit_renderbuffer_hline_at(TickitRenderBuffer *rb, int line, int startcol
 void tickit_renderbuffer_vline_at(TickitRenderBuffer *rb, int startline, int endline, int col,
     TickitLineStyle style, TickitPen *pen, TickitLineCaps caps);
 
+// Draws the content of src within src_rect as if it were drawn directly to dst,
+// with its top-left corner at the given position in dst
+void tickit_renderbuffer_blit(TickitRenderBuffer *dst, TickitRenderBuffer *src, const TickitRect *src_rect,
+    int dst_line, int dst_col);
+
+// Calls fn once for each rect, to draw it into a private tile buffer in rb's
+// coordinates, using up to nthreads threads at once. The tiles are then blitted
+// into rb in the order given. fn may be called concurrently, so must not modify
+// anything it shares with other tiles, including any pens it draws with. rb
+// keeps its threads and tile buffers for later calls, until it is destroyed
+typedef void TickitRenderBufferTileFn(TickitRenderBuffer *tile, const TickitRect *rect, void *data);
+void tickit_renderbuffer_render_tiled(TickitRenderBuffer *rb, const TickitRect rects[], size_t n,
+    TickitRenderBufferTileFn *fn, void *data, int nthreads);
+
 void tickit_renderbuffer_flush_to_term(TickitRenderBuffer *rb, TickitTerm *tt);
+// Flushes once to each set of output-equivalent terminals, copying the output
+// to the rest of the set. In retained mode they must all display what the
+// buffer last flushed
+void tickit_renderbuffer_flush_to_terms(TickitRenderBuffer *rb, TickitTerm *terms[], size_t n);
+
+// Retained mode remembers what was last flushed, so later flushes only send
+// cells that have changed. Invalidation takes absolute (untranslated) rects
+void tickit_renderbuffer_set_retained(TickitRenderBuffer *rb, int retained);
+int tickit_renderbuffer_is_retained(const TickitRenderBuffer *rb);
+void tickit_renderbuffer_invalidate(TickitRenderBuffer *rb);
+void tickit_renderbuffer_invalidaterect(TickitRenderBuffer *rb, TickitRect *rect);
 
 // This API is still somewhat experimental
 
@@ -403,6 +484,90 @@ struct TickitRenderBufferSpanInfo {
 // returns the text length or -1 on error
 size_t tickit_renderbuffer_get_span(TickitRenderBuffer *rb, int line, int startcol, struct TickitRenderBufferSpanInfo *info, char *buffer, size_t len);
 
+/*
+ * TickitWindow
+ */
+
+typedef struct TickitWindow TickitWindow;
+
+typedef void TickitWindowExposeFn(TickitWindow *win, TickitRenderBuffer *rb, const TickitRect *rect, void *data);
+
+// A window keeps its parent even while not among its children, so it must be
+// destroyed before the parent is
+TickitWindow *tickit_window_new(TickitWindow *parent, int top, int left, int lines, int cols);
+void tickit_window_destroy(TickitWindow *win);
+
+TickitWindow *tickit_window_parent(const TickitWindow *win);
+TickitWindow *tickit_window_root(const TickitWindow *win);
+
+// Children are kept in z-order, front-most first. index -1 inserts at the back.
+// Inserting a child makes win its parent
+size_t tickit_window_children(const TickitWindow *win);
+size_t tickit_window_get_children(const TickitWindow *win, TickitWindow *children[], size_t n);
+int  tickit_window_insert_child(TickitWindow *win, TickitWindow *child, int index);
+void tickit_window_remove_child(TickitWindow *win, TickitWindow *child);
+
+// Geometry is relative to the parent
+void tickit_window_get_geometry(const TickitWindow *win, TickitRect *rect);
+void tickit_window_set_geometry(TickitWindow *win, const TickitRect *rect);
+
+int  tickit_window_is_visible(const TickitWindow *win);
+void tickit_window_set_visible(TickitWindow *win, int visible);
+
+// The pen is not owned, and must outlive the window or be replaced
+void tickit_window_set_pen(TickitWindow *win, TickitPen *pen);
+void tickit_window_set_on_expose(TickitWindow *win, TickitWindowExposeFn *fn, void *data);
+
+// Invokes on_expose of every window within rect (in win's coordinates),
+// clipped, translated and masked by the windows in front of it
+void tickit_window_render_rect(TickitWindow *win, TickitRenderBuffer *rb, const TickitRect *rect);
+
+// Returns whether the cell at (line,col) of win shows through every window in
+// front of it, and sets *len to how many columns on from there stay that way,
+// or -1 if it lies outside and nothing further along will show. What each
+// window's children cover is cached until they are moved, shown or hidden
+int tickit_window_get_span_visibility(TickitWindow *win, int line, int col, int *len);
+
+/*
+ * TickitLoop
+ */
+
+typedef struct TickitLoop TickitLoop;
+
+typedef enum {
+  TICKIT_IO_IN  = 0x01,
+  TICKIT_IO_OUT = 0x02,
+  TICKIT_IO_HUP = 0x04,
+} TickitIOCondition;
+
+// As with event bindings, ev may include TICKIT_EV_UNBIND to also be invoked
+// with that when the timer or watch goes away. A timer is gone once it fires,
+// so it is invoked just once then, with both
+typedef void TickitLoopTimerFn(TickitLoop *loop, TickitEventType ev, void *data);
+typedef void TickitLoopIOFn(TickitLoop *loop, TickitEventType ev, int fd, TickitIOCondition cond, void *data);
+
+TickitLoop *tickit_loop_new(void);
+void tickit_loop_destroy(TickitLoop *loop);
+
+int  tickit_loop_timer_at(TickitLoop *loop, const struct timeval *at, TickitEventType ev, TickitLoopTimerFn *fn, void *data);
+int  tickit_loop_timer_after(TickitLoop *loop, int msec, TickitEventType ev, TickitLoopTimerFn *fn, void *data);
+void tickit_loop_cancel_timer(TickitLoop *loop, int id);
+size_t tickit_loop_timers(const TickitLoop *loop);
+// returns false if there are no timers
+int  tickit_loop_next_timer(const TickitLoop *loop, struct timeval *at);
+
+int  tickit_loop_watch_io(TickitLoop *loop, int fd, TickitIOCondition cond, TickitEventType ev, TickitLoopIOFn *fn, void *data);
+void tickit_loop_unwatch_io(TickitLoop *loop, int id);
+
+// The loop reads each term's input, writes its queued output as the fd will
+// take it, and handles its key timeouts. Terms are not owned
+void tickit_loop_add_term(TickitLoop *loop, TickitTerm *tt);
+void tickit_loop_remove_term(TickitLoop *loop, TickitTerm *tt);
+
+// Waits up to msec (or indefinitely if -1) for IO or the next timer, then
+// dispatches whatever is ready and fires the timers that are due
+void tickit_loop_run_once(TickitLoop *loop, int msec);
+
 #endif
 
 #ifdef __cplusplus
@@ -29,9 +29,6 @@ use Tickit::Window;
 
 use Tickit::Debug;
 
-use Struct::Dumb;
-struct TimeQueue => [qw( time code )];
-
 =head1 NAME
 
 C<Tickit> - Terminal Interface Construction KIT
@@ -128,12 +125,15 @@ sub new
 
    my $self = bless {
       todo_queue => [],
-      timer_queue => [],
       redraw_queue => [],
+      loop => Tickit::_Loop->new,
    }, $class;
 
    unless( $term ) {
       my $writer = $self->_make_writer( $out );
+      # Without a writer the term writes to $out itself, so it may make it
+      # non-blocking
+      $self->{direct_out} = !$writer;
 
       $term = Tickit::Term->find_for_term(
          writer        => $writer,
@@ -147,6 +147,8 @@ sub new
    $self->{term_in}  = $in;
    $self->{term_out} = $out;
 
+   $self->{loop}->add_term( $term );
+
    my $rootwin = $self->{rootwin} = Tickit::Window->new( $self, $term->lines, $term->cols );
 
    $self->bind_key( 'C-c' => $self->can( "stop" ) );
@@ -190,9 +192,11 @@ sub _make_writer
    my $self = shift;
    my ( $out ) = @_;
 
+   # By default the term writes directly to the output handle's file
+   # descriptor, queueing anything it won't yet accept
    $out->autoflush( 1 );
 
-   return $out;
+   return undef;
 }
 
 =head2 $tickit->later( $code )
@@ -219,6 +223,15 @@ sub later
    push @{ $self->{todo_queue} }, $code;
 }
 
+# Runs $code as a 'later' once the term has written all of its pending output
+sub _later_writable
+{
+   my $self = shift;
+   my ( $code ) = @_;
+
+   push @{ $self->{redraw_queue} }, $code;
+}
+
 =head2 $tickit->timer( $mode, $amount, $code )
 
 Runs the given CODE reference at some fixed point in time in the future.
@@ -248,8 +261,8 @@ sub timer
       croak "Mode should be 'at' or 'after'";
    }
 
-   # TODO: bin-search insert position then splice
-   @{ $self->{timer_queue} } = sort { $a->time <=> $b->time } @{ $self->{timer_queue} }, TimeQueue( $at => $code );
+   $self->{loop}->timer( $at, $code );
+   return;
 }
 
 =head2 $term = $tickit->term
@@ -424,6 +437,14 @@ sub setup_term
    $term->setctl_int( cursorvis => 0 );
    $term->setctl_int( mouse     => TERM_MOUSEMODE_DRAG );
    $term->clear;
+   $self->rootwin->_invalidate_retained;
+
+   # Don't stall the whole program when the terminal can't keep up; output
+   # that won't fit is queued, and redrawing is put off until it has drained
+   if( $self->{direct_out} and $self->{term_out}->blocking ) {
+      $self->{term_out}->blocking( 0 );
+      $self->{restore_blocking}++;
+   }
 
    if( my $widget = $self->{root_widget} ) {
       $widget->set_window( $self->rootwin );
@@ -451,6 +472,9 @@ sub teardown_term
    $term->setctl_int( cursorvis => 1 );
    $term->setctl_int( mouse     => 0 );
 
+   # Let the remaining output drain before handing the handle back
+   $self->{term_out}->blocking( 1 ) if delete $self->{restore_blocking};
+
    $term->flush;
 }
 
@@ -465,19 +489,20 @@ sub _tick
 {
    my $self = shift;
 
-   my $timer_queue = $self->{timer_queue};
+   my $term = $self->{term};
+   my $redraw_queue = $self->{redraw_queue};
 
+   # Don't wait for input if deferred redraws can already go ahead
    my $timeout;
-   if( @$timer_queue ) {
-      $timeout = $self->{timer_queue}[0]->time - time;
-   }
+   $timeout = 0 if @$redraw_queue and !$term->output_pending;
 
-   $self->{term}->input_wait( $timeout );
+   # Waits for terminal input or the next timer, whichever is first. This
+   # also writes more pending output as the terminal accepts it, and then
+   # fires any timers that are due
+   $self->{loop}->run_once( $timeout );
 
-   my $now = time;
-   while( @$timer_queue and $timer_queue->[0]->time <= $now ) {
-      shift( @$timer_queue )->code->();
-   }
+   push @{ $self->{todo_queue} }, splice @$redraw_queue
+      if @$redraw_queue and !$term->output_pending;
 
    $self->_flush_later if @{ $self->{todo_queue} };
 }
@@ -146,6 +146,23 @@ static SV *pen_get_attr(TickitPen *pen, TickitPenAttr attr)
   }
 }
 
+static SV *newSVpenattrs(TickitPen *pen)
+{
+  HV *penattrs = newHV();
+  TickitPenAttr attr;
+
+  for(attr = 0; attr < TICKIT_N_PEN_ATTRS; attr++) {
+    const char *attrname;
+    if(!tickit_pen_nondefault_attr(pen, attr))
+      continue;
+
+    attrname = tickit_pen_attrname(attr);
+    hv_store(penattrs, attrname, strlen(attrname), pen_get_attr(pen, attr), 0);
+  }
+
+  return newRV_noinc((SV *)penattrs);
+}
+
 static void pen_set_attr(TickitPen *pen, TickitPenAttr attr, SV *val)
 {
   switch(tickit_pen_attrtype(attr)) {
@@ -253,6 +270,307 @@ typedef TickitRectSet *Tickit__RectSet;
 
 typedef TickitRenderBuffer *Tickit__RenderBuffer;
 
+/* A display list given to apply_ops is an ARRAY of ops, each itself an ARRAY
+ * of an op name and the same arguments as the method of that name. It is
+ * first decoded into an array of struct RBOp, which can then be performed
+ * without touching any Perl data, and so on any thread
+ */
+enum RBOpType {
+  RBOP_SAVE, RBOP_SAVEPEN, RBOP_RESTORE, RBOP_CLEAR, RBOP_TRANSLATE, RBOP_CLIP,
+  RBOP_MASK, RBOP_GOTO, RBOP_SETPEN, RBOP_SKIP_AT, RBOP_SKIP, RBOP_SKIP_TO,
+  RBOP_TEXT_AT, RBOP_TEXT, RBOP_ERASE_AT, RBOP_ERASE, RBOP_ERASE_TO,
+  RBOP_ERASERECT, RBOP_CHAR_AT, RBOP_CHAR, RBOP_HLINE_AT, RBOP_VLINE_AT,
+};
+
+/* The position of each op's pen, rect and string argument, or -1 */
+static const struct {
+  const char   *name;
+  enum RBOpType type;
+  int           minargs, maxargs;
+  int           penarg, rectarg, strarg;
+  int           needpos; /* fails without a virtual cursor position */
+} rbops[] = {
+  { "save",      RBOP_SAVE,      0, 0, -1, -1, -1, 0 },
+  { "savepen",   RBOP_SAVEPEN,   0, 0, -1, -1, -1, 0 },
+  { "restore",   RBOP_RESTORE,   0, 0, -1, -1, -1, 0 },
+  { "clear",     RBOP_CLEAR,     0, 1,  0, -1, -1, 0 },
+  { "translate", RBOP_TRANSLATE, 2, 2, -1, -1, -1, 0 },
+  { "clip",      RBOP_CLIP,      1, 1, -1,  0, -1, 0 },
+  { "mask",      RBOP_MASK,      1, 1, -1,  0, -1, 0 },
+  { "goto",      RBOP_GOTO,      2, 2, -1, -1, -1, 0 },
+  { "setpen",    RBOP_SETPEN,    1, 1,  0, -1, -1, 0 },
+  { "skip_at",   RBOP_SKIP_AT,   3, 3, -1, -1, -1, 0 },
+  { "skip",      RBOP_SKIP,      1, 1, -1, -1, -1, 1 },
+  { "skip_to",   RBOP_SKIP_TO,   1, 1, -1, -1, -1, 1 },
+  { "text_at",   RBOP_TEXT_AT,   3, 4,  3, -1,  2, 0 },
+  { "text",      RBOP_TEXT,      1, 2,  1, -1,  0, 1 },
+  { "erase_at",  RBOP_ERASE_AT,  3, 4,  3, -1, -1, 0 },
+  { "erase",     RBOP_ERASE,     1, 2,  1, -1, -1, 1 },
+  { "erase_to",  RBOP_ERASE_TO,  1, 2,  1, -1, -1, 1 },
+  { "eraserect", RBOP_ERASERECT, 1, 2,  1,  0, -1, 0 },
+  { "char_at",   RBOP_CHAR_AT,   3, 4,  3, -1, -1, 0 },
+  { "char",      RBOP_CHAR,      1, 2,  1, -1, -1, 0 },
+  { "hline_at",  RBOP_HLINE_AT,  4, 6,  4, -1, -1, 0 },
+  { "vline_at",  RBOP_VLINE_AT,  4, 6,  4, -1, -1, 0 },
+};
+
+struct RBOp {
+  int          t;     /* index into rbops[] */
+  IV           iv[6]; /* the integer arguments, by position; 0 if not given */
+  TickitPen   *pen;   /* borrowed from a Tickit::Pen in the list */
+  TickitRect   rect;
+  const char  *str;   /* borrowed from an SV in the list */
+  STRLEN       len;
+  unsigned int ungoto : 1;
+};
+
+static TickitPen *rbop_pen(pTHX_ SV *sv, HV *penstash, int idx)
+{
+  if(!sv || !SvOK(sv))
+    return NULL;
+
+  /* Most pens are plain Tickit::Pen objects; avoid an isa() walk for those */
+  if(SvROK(sv) && SvOBJECT(SvRV(sv)) &&
+      (SvSTASH(SvRV(sv)) == penstash || sv_derived_from(sv, "Tickit::Pen")))
+    return (INT2PTR(Tickit__Pen, SvIV(SvRV(sv))))->pen;
+
+  croak("apply_ops: op %d pen is not of type Tickit::Pen", idx);
+}
+
+static TickitRect *rbop_rect(pTHX_ SV *sv, int idx)
+{
+  if(sv && SvROK(sv) && sv_derived_from(sv, "Tickit::Rect"))
+    return INT2PTR(TickitRect *, SvIV(SvRV(sv)));
+
+  croak("apply_ops: op %d rect is not of type Tickit::Rect", idx);
+}
+
+/* Returns a buffer freed with the caller's scope, valid while the list and
+ * its pens are
+ */
+static struct RBOp *rbops_decode(pTHX_ AV *ops, int *np)
+{
+  HV *penstash = gv_stashpvs("Tickit::Pen", 0);
+  int n = av_len(ops) + 1;
+
+  struct RBOp *decoded;
+  Newx(decoded, n ? n : 1, struct RBOp);
+  SAVEFREEPV(decoded);
+
+  for(int idx = 0; idx < n; idx++) {
+    SV **opp = av_fetch(ops, idx, 0);
+    if(!opp || !SvROK(*opp) || SvTYPE(SvRV(*opp)) != SVt_PVAV)
+      croak("apply_ops: op %d is not an ARRAY reference", idx);
+
+    AV *op = (AV *)SvRV(*opp);
+    int nargs = av_len(op);
+    SV **svp = AvARRAY(op);
+    if(SvRMAGICAL(op) || nargs < 0 || !svp[0])
+      croak("apply_ops: op %d is not a plain non-empty ARRAY", idx);
+
+    const char *name = SvPV_nolen(svp[0]);
+    int t;
+    for(t = 0; t < (int)(sizeof(rbops)/sizeof(rbops[0])); t++)
+      if(strEQ(rbops[t].name, name))
+        break;
+    if(t == sizeof(rbops)/sizeof(rbops[0]))
+      croak("apply_ops: op %d has unrecognised name '%s'", idx, name);
+
+    if(nargs < rbops[t].minargs || nargs > rbops[t].maxargs)
+      croak("apply_ops: op %d (%s) takes %d to %d arguments, not %d",
+          idx, name, rbops[t].minargs, rbops[t].maxargs, nargs);
+
+    /* Arguments, with any not given as NULL */
+    SV *arg[6] = { NULL };
+    for(int i = 0; i < nargs; i++)
+      arg[i] = svp[i+1] ? svp[i+1] : &PL_sv_undef;
+
+    struct RBOp *o = &decoded[idx];
+    o->t      = t;
+    o->pen    = NULL;
+    o->str    = NULL;
+    o->len    = 0;
+    o->ungoto = rbops[t].type == RBOP_GOTO &&
+        (!SvIsNumeric(arg[0]) || !SvIsNumeric(arg[1]));
+
+    for(int i = 0; i < 6 && !o->ungoto; i++)
+      o->iv[i] = (arg[i] && i != rbops[t].penarg && i != rbops[t].rectarg &&
+          i != rbops[t].strarg) ? SvIV(arg[i]) : 0;
+
+    if(rbops[t].penarg >= 0)
+      o->pen = rbop_pen(aTHX_ arg[rbops[t].penarg], penstash, idx);
+    if(rbops[t].rectarg >= 0)
+      o->rect = *rbop_rect(aTHX_ arg[rbops[t].rectarg], idx);
+    if(rbops[t].strarg >= 0)
+      o->str = SvPVutf8(arg[rbops[t].strarg], o->len);
+  }
+
+  *np = n;
+  return decoded;
+}
+
+/* Returns the index of an op that needed a virtual cursor position but had
+ * none, having stopped there, or -1 once they have all been performed
+ */
+static int rbops_run(TickitRenderBuffer *rb, const struct RBOp *ops, int n)
+{
+  for(int idx = 0; idx < n; idx++) {
+    const struct RBOp *o = &ops[idx];
+    const IV *iv = o->iv;
+
+    if(rbops[o->t].needpos && !tickit_renderbuffer_has_cursorpos(rb))
+      return idx;
+
+    switch(rbops[o->t].type) {
+      case RBOP_SAVE:
+        tickit_renderbuffer_save(rb);
+        break;
+      case RBOP_SAVEPEN:
+        tickit_renderbuffer_savepen(rb);
+        break;
+      case RBOP_RESTORE:
+        tickit_renderbuffer_restore(rb);
+        break;
+      case RBOP_CLEAR:
+        tickit_renderbuffer_clear(rb, o->pen);
+        break;
+      case RBOP_TRANSLATE:
+        tickit_renderbuffer_translate(rb, iv[0], iv[1]);
+        break;
+      case RBOP_CLIP:
+        tickit_renderbuffer_clip(rb, (TickitRect *)&o->rect);
+        break;
+      case RBOP_MASK:
+        tickit_renderbuffer_mask(rb, (TickitRect *)&o->rect);
+        break;
+      case RBOP_GOTO:
+        if(o->ungoto)
+          tickit_renderbuffer_ungoto(rb);
+        else
+          tickit_renderbuffer_goto(rb, iv[0], iv[1]);
+        break;
+      case RBOP_SETPEN:
+        tickit_renderbuffer_setpen(rb, o->pen);
+        break;
+      case RBOP_SKIP_AT:
+        tickit_renderbuffer_skip_at(rb, iv[0], iv[1], iv[2]);
+        break;
+      case RBOP_SKIP:
+        tickit_renderbuffer_skip(rb, iv[0]);
+        break;
+      case RBOP_SKIP_TO:
+        tickit_renderbuffer_skip_to(rb, iv[0]);
+        break;
+      case RBOP_TEXT_AT:
+        /* Nobody sees the width, so measure only what is visible */
+        tickit_renderbuffer_textn_at_clipped(rb, iv[0], iv[1], o->str, o->len, o->pen);
+        break;
+      case RBOP_TEXT:
+        tickit_renderbuffer_textn(rb, o->str, o->len, o->pen);
+        break;
+      case RBOP_ERASE_AT:
+        tickit_renderbuffer_erase_at(rb, iv[0], iv[1], iv[2], o->pen);
+        break;
+      case RBOP_ERASE:
+        tickit_renderbuffer_erase(rb, iv[0], o->pen);
+        break;
+      case RBOP_ERASE_TO:
+        tickit_renderbuffer_erase_to(rb, iv[0], o->pen);
+        break;
+      case RBOP_ERASERECT:
+        tickit_renderbuffer_eraserect(rb, (TickitRect *)&o->rect, o->pen);
+        break;
+      case RBOP_CHAR_AT:
+        tickit_renderbuffer_char_at(rb, iv[0], iv[1], iv[2], o->pen);
+        break;
+      case RBOP_CHAR:
+        tickit_renderbuffer_char(rb, iv[0], o->pen);
+        break;
+      case RBOP_HLINE_AT:
+        tickit_renderbuffer_hline_at(rb, iv[0], iv[1], iv[2], iv[3], o->pen, iv[5]);
+        break;
+      case RBOP_VLINE_AT:
+        tickit_renderbuffer_vline_at(rb, iv[0], iv[1], iv[2], iv[3], o->pen, iv[5]);
+        break;
+    }
+  }
+
+  return -1;
+}
+
+static void rbops_croak_nopos(pTHX_ const struct RBOp *op)
+{
+  croak("Cannot ->%s without a virtual cursor position", rbops[op->t].name);
+}
+
+/* render_tiled gives each tile its own list, performed on whichever thread
+ * draws that tile
+ */
+struct RBTile {
+  const struct RBOp *ops;
+  int                n;
+  int                failed; /* as returned by rbops_run() */
+};
+
+struct RBTiled {
+  const TickitRect *rects;
+  struct RBTile    *tiles;
+};
+
+static void rb_tile_fn(TickitRenderBuffer *tile, const TickitRect *rect, void *data)
+{
+  struct RBTiled *tiled = data;
+  struct RBTile *t = &tiled->tiles[rect - tiled->rects];
+
+  t->failed = rbops_run(tile, t->ops, t->n);
+}
+
+/*******************
+ * Tickit::_Window *
+ *******************/
+
+/* The native half of a Tickit::Window, which owns it */
+typedef struct Tickit___Window {
+  TickitWindow *win;
+  SV           *self;   /* the Tickit::Window's referent; not counted */
+  SV           *parent; /* the parent Tickit::_Window's referent */
+  SV           *pen;
+} *Tickit___Window;
+
+static SV *window_expose_rb;    /* the Tickit::RenderBuffer during render_rect */
+static SV *window_expose_error; /* the first exception thrown by a handler */
+
+/* An exception must not unwind through the C walk, which would leave the
+ * RenderBuffer with its save stack, clip and translation mid-walk. The first
+ * one is kept instead, the remaining handlers skipped, and render_rect throws
+ * it again once the walk has returned */
+static void window_expose_fn(TickitWindow *win, TickitRenderBuffer *rb, const TickitRect *rect, void *data)
+{
+  Tickit___Window self = data;
+  dSP;
+
+  if(window_expose_error)
+    return;
+
+  ENTER;
+  SAVETMPS;
+
+  PUSHMARK(SP);
+  EXTEND(SP, 3);
+  mPUSHs(newRV_inc(self->self));
+  PUSHs(window_expose_rb);
+  mPUSHrect((TickitRect *)rect);
+  PUTBACK;
+
+  call_method("_handle_expose", G_VOID|G_DISCARD|G_EVAL);
+
+  if(SvTRUE(ERRSV))
+    window_expose_error = newSVsv(ERRSV);
+
+  FREETMPS;
+  LEAVE;
+}
+
 /****************
  * Tickit::Term *
  ****************/
@@ -273,6 +591,9 @@ static TickitTermCtl term_name2ctl(const char *name)
     case 'a':
       return streq(name+1, "ltscreen") ? TICKIT_TERMCTL_ALTSCREEN
                                        : -1;
+    case 'b':
+      return streq(name+1, "ce") ? TICKIT_TERMCTL_BCE
+                                 : -1;
     case 'c':
       return streq(name+1, "olors")      ? TICKIT_TERMCTL_COLORS
            : streq(name+1, "ursorblink") ? TICKIT_TERMCTL_CURSORBLINK
@@ -289,6 +610,9 @@ static TickitTermCtl term_name2ctl(const char *name)
     case 'm':
       return streq(name+1, "ouse") ? TICKIT_TERMCTL_MOUSE
                                        : -1;
+    case 's':
+      return streq(name+1, "ync_output") ? TICKIT_TERMCTL_SYNC_OUTPUT
+                                         : -1;
     case 't':
       return streq(name+1, "itle_text") ? TICKIT_TERMCTL_TITLE_TEXT
                                         : -1;
@@ -316,6 +640,8 @@ static void term_userevent_fn(TickitTerm *tt, TickitEventType ev, TickitEvent *a
         hv_store(argshash, "line",   4, newSViv(args->line),   0);
         hv_store(argshash, "col",    3, newSViv(args->col),    0);
         hv_store(argshash, "mod",    3, newSViv(args->mod), 0);
+        if(args->type == TICKIT_MOUSEEV_WHEEL)
+          hv_store(argshash, "count",  5, newSViv(args->count), 0);
         break;
 
       case TICKIT_EV_RESIZE:
@@ -395,6 +721,41 @@ static SV *newSVterm(TickitTerm *tt, char *package)
   return ret;
 }
 
+/*****************
+ * Tickit::_Loop *
+ *****************/
+
+typedef struct Tickit___Loop {
+  TickitLoop *loop;
+  AV         *terms; /* keeps the Tickit::Terms it watches alive */
+} *Tickit___Loop;
+
+static void loop_timer_fn(TickitLoop *loop, TickitEventType ev, void *data)
+{
+  SV *code = data;
+
+  if(ev & TICKIT_EV_TIMER) {
+    dSP;
+
+    ENTER;
+    SAVETMPS;
+
+    /* Freed along with the temporaries, even if the code dies */
+    if(ev & TICKIT_EV_UNBIND)
+      sv_2mortal(code);
+
+    PUSHMARK(SP);
+    PUTBACK;
+
+    call_sv(code, G_VOID|G_DISCARD);
+
+    FREETMPS;
+    LEAVE;
+  }
+  else if(ev & TICKIT_EV_UNBIND)
+    SvREFCNT_dec(code);
+}
+
 /*********************
  * Tickit::StringPos *
  *********************/
@@ -434,6 +795,8 @@ static void setup_constants(void)
   DO_CONSTANT(TICKIT_TERMCTL_MOUSE)
   DO_CONSTANT(TICKIT_TERMCTL_TITLE_TEXT)
   DO_CONSTANT(TICKIT_TERMCTL_COLORS)
+  DO_CONSTANT(TICKIT_TERMCTL_SYNC_OUTPUT)
+  DO_CONSTANT(TICKIT_TERMCTL_BCE)
 
   DO_CONSTANT(TICKIT_TERM_CURSORSHAPE_BLOCK)
   DO_CONSTANT(TICKIT_TERM_CURSORSHAPE_UNDER)
@@ -868,6 +1231,25 @@ add(self,rect)
   CODE:
     tickit_rectset_add(self, rect);
 
+void
+add_many(self,...)
+  Tickit::RectSet self
+  INIT:
+    TickitRect *rects;
+    int i;
+  CODE:
+    Newx(rects, items - 1, TickitRect);
+    for(i = 1; i < items; i++) {
+      if(!SvROK(ST(i)) || !sv_derived_from(ST(i), "Tickit::Rect")) {
+        Safefree(rects);
+        croak("Expected a Tickit::Rect");
+      }
+      rects[i-1] = *INT2PTR(TickitRect *, SvIV(SvRV(ST(i))));
+    }
+
+    tickit_rectset_add_many(self, rects, items - 1);
+    Safefree(rects);
+
 void
 subtract(self,rect)
   Tickit::RectSet self
@@ -915,6 +1297,31 @@ DESTROY(self)
   CODE:
     tickit_renderbuffer_destroy(self);
 
+void
+resize(self,lines,cols)
+  Tickit::RenderBuffer self
+  int lines
+  int cols
+  CODE:
+    tickit_renderbuffer_resize(self, lines, cols);
+
+SV *
+stats(self)
+  Tickit::RenderBuffer self
+  INIT:
+    TickitRenderBufferStats stats;
+    HV *ret;
+  CODE:
+    tickit_renderbuffer_get_stats(self, &stats);
+    ret = newHV();
+    hv_stores(ret, "spans",         newSVuv(stats.spans));
+    hv_stores(ret, "pen_merges",    newSVuv(stats.pen_merges));
+    hv_stores(ret, "text_bytes",    newSVuv(stats.text_bytes));
+    hv_stores(ret, "cells_flushed", newSVuv(stats.cells_flushed));
+    RETVAL = newRV_noinc((SV *)ret);
+  OUTPUT:
+    RETVAL
+
 int
 lines(self)
   Tickit::RenderBuffer self
@@ -1152,8 +1559,16 @@ text_at(self,line,col,text,pen=NULL)
   int col
   SV *text
   Tickit::Pen pen
+  INIT:
+    const char *s;
+    STRLEN len;
   CODE:
-    RETVAL = tickit_renderbuffer_text_at(self, line, col, SvPVutf8_nolen(text), pen ? pen->pen : NULL);
+    s = SvPVutf8(text, len);
+    /* Nobody is looking at the width; measure no more than is visible */
+    if(GIMME_V == G_VOID)
+      RETVAL = tickit_renderbuffer_textn_at_clipped(self, line, col, s, len, pen ? pen->pen : NULL);
+    else
+      RETVAL = tickit_renderbuffer_textn_at(self, line, col, s, len, pen ? pen->pen : NULL);
   OUTPUT:
     RETVAL
 
@@ -1162,11 +1577,15 @@ text(self,text,pen=NULL)
   Tickit::RenderBuffer self
   SV *text
   Tickit::Pen pen
+  INIT:
+    const char *s;
+    STRLEN len;
   CODE:
     if(!tickit_renderbuffer_has_cursorpos(self))
       croak("Cannot ->text without a virtual cursor position");
 
-    RETVAL = tickit_renderbuffer_text(self, SvPVutf8_nolen(text), pen ? pen->pen : NULL);
+    s = SvPVutf8(text, len);
+    RETVAL = tickit_renderbuffer_textn(self, s, len, pen ? pen->pen : NULL);
   OUTPUT:
     RETVAL
 
@@ -1254,6 +1673,27 @@ vline_at(self,startline,endline,col,style,pen=NULL,caps=0)
     tickit_renderbuffer_vline_at(self, startline, endline, col, style,
       pen ? pen->pen : NULL, caps);
 
+void
+apply_ops(self,ops)
+  Tickit::RenderBuffer self
+  AV *ops
+  CODE:
+    int n;
+    struct RBOp *decoded = rbops_decode(aTHX_ ops, &n);
+    int failed = rbops_run(self, decoded, n);
+    if(failed >= 0)
+      rbops_croak_nopos(aTHX_ &decoded[failed]);
+
+void
+blit(self,src,rect,line,col)
+  Tickit::RenderBuffer self
+  Tickit::RenderBuffer src
+  Tickit::Rect rect
+  int line
+  int col
+  CODE:
+    tickit_renderbuffer_blit(self, src, rect, line, col);
+
 void
 flush_to_term(self,term)
   Tickit::RenderBuffer self
@@ -1261,6 +1701,95 @@ flush_to_term(self,term)
   CODE:
     tickit_renderbuffer_flush_to_term(self, term->tt);
 
+void
+flush_to_terms(self,...)
+  Tickit::RenderBuffer self
+  INIT:
+    TickitTerm **terms;
+    int i;
+  CODE:
+    Newx(terms, items - 1, TickitTerm *);
+    SAVEFREEPV(terms);
+
+    for(i = 1; i < items; i++) {
+      if(!SvROK(ST(i)) || !sv_derived_from(ST(i), "Tickit::Term"))
+        croak("Expected a Tickit::Term for argument %d", i);
+      terms[i-1] = (INT2PTR(Tickit__Term, SvIV(SvRV(ST(i)))))->tt;
+    }
+
+    tickit_renderbuffer_flush_to_terms(self, terms, items - 1);
+
+void
+render_tiled(self,nthreads,...)
+  Tickit::RenderBuffer self
+  int nthreads
+  INIT:
+    TickitRect *rects;
+    struct RBTile *tiles;
+    struct RBTiled tiled;
+    int i, n = 0;
+  CODE:
+    Newx(rects, items - 1, TickitRect);
+    SAVEFREEPV(rects);
+    Newx(tiles, items - 1, struct RBTile);
+    SAVEFREEPV(tiles);
+
+    for(i = 2; i < items; i++) {
+      AV *tile;
+      SV **svp;
+      if(!SvROK(ST(i)) || SvTYPE(SvRV(ST(i))) != SVt_PVAV ||
+          av_len(tile = (AV *)SvRV(ST(i))) != 1)
+        croak("Expected a [ rect, ops ] pair for argument %d", i);
+
+      svp = av_fetch(tile, 0, 0);
+      if(!svp || !SvROK(*svp) || !sv_derived_from(*svp, "Tickit::Rect"))
+        croak("Expected a Tickit::Rect for the rect of argument %d", i);
+      rects[n] = *INT2PTR(TickitRect *, SvIV(SvRV(*svp)));
+
+      svp = av_fetch(tile, 1, 0);
+      if(!svp || !SvROK(*svp) || SvTYPE(SvRV(*svp)) != SVt_PVAV)
+        croak("Expected an ARRAY of ops for argument %d", i);
+      tiles[n].ops    = rbops_decode(aTHX_ (AV *)SvRV(*svp), &tiles[n].n);
+      tiles[n].failed = -1;
+
+      /* An empty tile could draw nothing */
+      if(rects[n].lines > 0 && rects[n].cols > 0)
+        n++;
+    }
+
+    tiled.rects = rects;
+    tiled.tiles = tiles;
+    tickit_renderbuffer_render_tiled(self, rects, n, rb_tile_fn, &tiled, nthreads);
+
+    for(i = 0; i < n; i++)
+      if(tiles[i].failed >= 0)
+        rbops_croak_nopos(aTHX_ &tiles[i].ops[tiles[i].failed]);
+
+void
+set_retained(self,retained)
+  Tickit::RenderBuffer self
+  int retained
+  CODE:
+    tickit_renderbuffer_set_retained(self, retained);
+
+int
+is_retained(self)
+  Tickit::RenderBuffer self
+  CODE:
+    RETVAL = tickit_renderbuffer_is_retained(self);
+  OUTPUT:
+    RETVAL
+
+void
+invalidate(self,rect=NULL)
+  Tickit::RenderBuffer self
+  Tickit::Rect rect
+  CODE:
+    if(rect)
+      tickit_renderbuffer_invalidaterect(self, rect);
+    else
+      tickit_renderbuffer_invalidate(self);
+
 MODULE = Tickit             PACKAGE = Tickit::StringPos
 
 SV *
@@ -1360,6 +1889,223 @@ columns(self)
   OUTPUT:
     RETVAL
 
+MODULE = Tickit             PACKAGE = Tickit::_Window
+
+Tickit::_Window
+new(package,window,parent_sv=&PL_sv_undef)
+  char *package
+  SV   *window
+  SV   *parent_sv
+  INIT:
+    Tickit___Window parent = NULL;
+  CODE:
+    if(SvOK(parent_sv)) {
+      if(!SvROK(parent_sv) || !sv_derived_from(parent_sv, "Tickit::_Window"))
+        croak("Expected a Tickit::_Window");
+      parent = INT2PTR(Tickit___Window, SvIV(SvRV(parent_sv)));
+    }
+
+    Newx(RETVAL, 1, struct Tickit___Window);
+    RETVAL->win    = tickit_window_new(parent ? parent->win : NULL, 0, 0, 1, 1);
+    RETVAL->self   = SvRV(window);
+    RETVAL->parent = parent ? SvREFCNT_inc(SvRV(parent_sv)) : NULL;
+    RETVAL->pen    = NULL;
+  OUTPUT:
+    RETVAL
+
+void
+DESTROY(self)
+  Tickit::_Window self
+  CODE:
+    /* Objects die in no particular order during global destruction, so the
+     * parent may already be gone */
+    if(PL_dirty)
+      return;
+    tickit_window_destroy(self->win);
+    if(self->parent)
+      SvREFCNT_dec(self->parent);
+    if(self->pen)
+      SvREFCNT_dec(self->pen);
+    Safefree(self);
+
+void
+set_geometry(self,top,left,lines,cols)
+  Tickit::_Window self
+  int             top
+  int             left
+  int             lines
+  int             cols
+  INIT:
+    TickitRect rect;
+  CODE:
+    tickit_rect_init_sized(&rect, top, left, lines, cols);
+    tickit_window_set_geometry(self->win, &rect);
+
+void
+set_visible(self,visible)
+  Tickit::_Window self
+  int             visible
+  CODE:
+    tickit_window_set_visible(self->win, visible);
+
+void
+set_pen(self,pen)
+  Tickit::_Window self
+  Tickit::Pen     pen
+  CODE:
+    if(self->pen)
+      SvREFCNT_dec(self->pen);
+    self->pen = pen ? newSVsv(ST(1)) : NULL;
+    tickit_window_set_pen(self->win, pen ? pen->pen : NULL);
+
+void
+set_has_expose(self,has_expose)
+  Tickit::_Window self
+  int             has_expose
+  CODE:
+    tickit_window_set_on_expose(self->win, has_expose ? window_expose_fn : NULL, self);
+
+void
+set_children(self,...)
+  Tickit::_Window self
+  INIT:
+    int i;
+  CODE:
+    while(tickit_window_children(self->win)) {
+      TickitWindow *child;
+      tickit_window_get_children(self->win, &child, 1);
+      tickit_window_remove_child(self->win, child);
+    }
+
+    for(i = 1; i < items; i++) {
+      if(!SvROK(ST(i)) || !sv_derived_from(ST(i), "Tickit::_Window"))
+        croak("Expected a Tickit::_Window");
+      tickit_window_insert_child(self->win, (INT2PTR(Tickit___Window, SvIV(SvRV(ST(i)))))->win, -1);
+    }
+
+void
+get_span_visibility(self,line,col)
+  Tickit::_Window self
+  int             line
+  int             col
+  INIT:
+    int vis, len;
+  PPCODE:
+    vis = tickit_window_get_span_visibility(self->win, line, col, &len);
+    EXTEND(SP, 2);
+    mPUSHi(vis);
+    if(len == -1)
+      PUSHs(&PL_sv_undef);
+    else
+      mPUSHi(len);
+    XSRETURN(2);
+
+void
+render_rect(self,rb,rect)
+  Tickit::_Window      self
+  Tickit::RenderBuffer rb
+  Tickit::Rect         rect
+  INIT:
+    SV *prev_rb, *prev_error, *error;
+  CODE:
+    prev_rb = window_expose_rb;
+    prev_error = window_expose_error;
+    window_expose_rb = ST(1);
+    window_expose_error = NULL;
+
+    tickit_window_render_rect(self->win, rb, rect);
+
+    error = window_expose_error;
+    window_expose_rb = prev_rb;
+    window_expose_error = prev_error;
+
+    if(error) {
+      /* Whatever the frame drew so far is incomplete */
+      tickit_renderbuffer_reset(rb);
+      sv_setsv(ERRSV, sv_2mortal(error));
+      croak(NULL);
+    }
+
+MODULE = Tickit             PACKAGE = Tickit::_Loop
+
+Tickit::_Loop
+new(package)
+  char *package
+  CODE:
+    Newx(RETVAL, 1, struct Tickit___Loop);
+    RETVAL->loop  = tickit_loop_new();
+    RETVAL->terms = newAV();
+  OUTPUT:
+    RETVAL
+
+void
+DESTROY(self)
+  Tickit::_Loop self
+  CODE:
+    tickit_loop_destroy(self->loop);
+    SvREFCNT_dec(self->terms);
+    Safefree(self);
+
+void
+add_term(self,term)
+  Tickit::_Loop self
+  Tickit::Term  term
+  CODE:
+    tickit_loop_add_term(self->loop, term->tt);
+    av_push(self->terms, newSVsv(ST(1)));
+
+int
+timer(self,at,code)
+  Tickit::_Loop self
+  NV            at
+  CV           *code
+  INIT:
+    struct timeval tv;
+  CODE:
+    tv.tv_sec  = (long)at;
+    tv.tv_usec = 1E6 * (at - tv.tv_sec);
+    RETVAL = tickit_loop_timer_at(self->loop, &tv, TICKIT_EV_TIMER|TICKIT_EV_UNBIND, loop_timer_fn, SvREFCNT_inc(code));
+  OUTPUT:
+    RETVAL
+
+void
+cancel_timer(self,id)
+  Tickit::_Loop self
+  int           id
+  CODE:
+    tickit_loop_cancel_timer(self->loop, id);
+
+int
+timers(self)
+  Tickit::_Loop self
+  CODE:
+    RETVAL = tickit_loop_timers(self->loop);
+  OUTPUT:
+    RETVAL
+
+SV *
+next_timer(self)
+  Tickit::_Loop self
+  INIT:
+    struct timeval tv;
+  CODE:
+    RETVAL = newSV(0);
+    if(tickit_loop_next_timer(self->loop, &tv))
+      sv_setnv(RETVAL, tv.tv_sec + tv.tv_usec / 1E6);
+  OUTPUT:
+    RETVAL
+
+void
+run_once(self,timeout=&PL_sv_undef)
+  Tickit::_Loop self
+  SV           *timeout
+  INIT:
+    int msec = -1;
+  CODE:
+    if(SvIsNumeric(timeout))
+      msec = SvNV(timeout) > 0 ? (int)(SvNV(timeout) * 1000 + 0.999) : 0;
+    tickit_loop_run_once(self->loop, msec);
+
 MODULE = Tickit             PACKAGE = Tickit::Term
 
 SV *
@@ -1482,6 +2228,39 @@ set_output_buffer(self,len)
   CODE:
     tickit_term_set_output_buffer(self->tt, len);
 
+SV *
+stats(self)
+  Tickit::Term  self
+  INIT:
+    TickitTermStats stats;
+    HV *ret;
+  CODE:
+    tickit_term_get_stats(self->tt, &stats);
+    ret = newHV();
+    hv_stores(ret, "bytes",       newSVuv(stats.bytes));
+    hv_stores(ret, "writes",      newSVuv(stats.writes));
+    hv_stores(ret, "flushes",     newSVuv(stats.flushes));
+    hv_stores(ret, "setpens",     newSVuv(stats.setpens));
+    hv_stores(ret, "gotos",       newSVuv(stats.gotos));
+    hv_stores(ret, "scrollrects", newSVuv(stats.scrollrects));
+    RETVAL = newRV_noinc((SV *)ret);
+  OUTPUT:
+    RETVAL
+
+size_t
+output_pending(self)
+  Tickit::Term  self
+  CODE:
+    RETVAL = tickit_term_output_pending(self->tt);
+  OUTPUT:
+    RETVAL
+
+void
+output_writable(self)
+  Tickit::Term  self
+  CODE:
+    tickit_term_output_writable(self->tt);
+
 void
 set_utf8(self,utf8)
   Tickit::Term  self
@@ -1489,6 +2268,21 @@ set_utf8(self,utf8)
   CODE:
     tickit_term_set_utf8(self->tt, utf8);
 
+bool
+get_mouse_coalesce(self)
+  Tickit::Term  self
+  CODE:
+    RETVAL = tickit_term_get_mouse_coalesce(self->tt);
+  OUTPUT:
+    RETVAL
+
+void
+set_mouse_coalesce(self,coalesce)
+  Tickit::Term  self
+  int           coalesce
+  CODE:
+    tickit_term_set_mouse_coalesce(self->tt, coalesce);
+
 void
 get_size(self)
   Tickit::Term  self
@@ -1770,6 +2564,28 @@ setctl_str(self,ctl,value)
   OUTPUT:
     RETVAL
 
+void
+_ti_test_expand(termtype,src,...)
+  SV   *termtype
+  char *src
+  INIT:
+    int params[9] = { 0 };
+    char out[256], ref[256];
+    size_t outlen, reflen;
+    int i, compiled;
+  PPCODE:
+    for(i = 2; i < items && i < 11; i++)
+      params[i-2] = SvIV(ST(i));
+    compiled = tickit_termdrv_ti_test_expand(SvOK(termtype) ? SvPV_nolen(termtype) : NULL, src,
+        params, out, &outlen, ref, &reflen, sizeof(out));
+    if(compiled == -1)
+      XSRETURN_EMPTY;
+    EXTEND(SP, 3);
+    mPUSHi(compiled);
+    mPUSHp(out, outlen);
+    mPUSHp(ref, reflen);
+    XSRETURN(3);
+
 MODULE = Tickit::Test::MockTerm    PACKAGE = Tickit::Test::MockTerm
 
 SV *
@@ -1890,26 +2706,58 @@ get_display_pen(self,line,col)
   Tickit::Term self
   int line
   int col
-  INIT:
-    TickitPen *pen;
-    HV *penattrs;
-    TickitPenAttr attr;
   CODE:
-    pen = tickit_mockterm_get_display_pen((TickitMockTerm *)self->tt, line, col);
+    RETVAL = newSVpenattrs(tickit_mockterm_get_display_pen((TickitMockTerm *)self->tt, line, col));
+  OUTPUT:
+    RETVAL
 
-    penattrs = newHV();
-    for(attr = 0; attr < TICKIT_N_PEN_ATTRS; attr++) {
-      const char *attrname;
-      if(!tickit_pen_nondefault_attr(pen, attr))
-        continue;
+void
+get_display_pens(self,line,col,width)
+  Tickit::Term self
+  int line
+  int col
+  int width
+  INIT:
+    TickitMockTerm *mt;
+    int *penidx;
+    int npens;
+    SV **pens;
+    int lines, cols;
+    int i;
+  PPCODE:
+    mt = (TickitMockTerm *)self->tt;
+    tickit_term_get_size(self->tt, &lines, &cols);
+    if(line < 0 || line >= lines || col < 0 || width < 0 || col + width > cols)
+      croak("Display area out of range");
 
-      attrname = tickit_pen_attrname(attr);
-      hv_store(penattrs, attrname, strlen(attrname), pen_get_attr(pen, attr), 0);
+    Newx(penidx, width, int);
+    npens = tickit_mockterm_get_display_pens(mt, line, col, width, penidx);
+
+    /* Cells sharing a pen share one attribute hash */
+    Newxz(pens, npens, SV *);
+
+    EXTEND(SP, width);
+    for(i = 0; i < width; i++) {
+      SV **pen = &pens[penidx[i]];
+      if(!*pen)
+        *pen = newSVpenattrs(tickit_mockterm_get_pen(mt, penidx[i]));
+      PUSHs(sv_2mortal(newSVsv(*pen)));
     }
 
-    RETVAL = newRV_noinc((SV *)penattrs);
-  OUTPUT:
-    RETVAL
+    for(i = 0; i < npens; i++)
+      if(pens[i])
+        SvREFCNT_dec(pens[i]);
+    Safefree(pens);
+    Safefree(penidx);
+
+    XSRETURN(width);
+
+void
+set_log_limit(self,limit)
+  Tickit::Term self
+  int limit
+  CODE:
+    tickit_mockterm_set_loglimit((TickitMockTerm *)self->tt, limit);
 
 void
 resize(self,newlines,newcols)
@@ -2008,6 +2856,19 @@ int textwidth(str)
   OUTPUT:
     RETVAL
 
+int ambiguous_width()
+  CODE:
+    RETVAL = tickit_string_get_ambiguous_width();
+  OUTPUT:
+    RETVAL
+
+void set_ambiguous_width(width)
+    int width
+  CODE:
+    if(width != 1 && width != 2)
+      croak("Expected ambiguous width to be 1 or 2");
+    tickit_string_set_ambiguous_width(width);
+
 void chars2cols(str,...)
     SV *str;
   INIT:
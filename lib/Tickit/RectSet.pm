@@ -49,7 +49,8 @@ Returns a new C<Tickit::RectSet> instance, initially empty.
 =head2 @rects = $rectset->rects
 
 Returns a list of the covered regions, in order first top to bottom, then left
-to right.
+to right. The list is canonical; any two sets covering the same area return the
+same list.
 
 =cut
 
@@ -59,6 +60,14 @@ Adds the region covered by C<$rect> to the stored region list.
 
 =cut
 
+=head2 $rectset->add_many( @rects )
+
+Adds the regions covered by all of the given rects at once. This gives the
+same result as calling C<add> on each in turn, but is cheaper when there are
+many of them.
+
+=cut
+
 =head2 $rectset->subtract( $rect )
 
 Removes any covered region that intersects with C<$rect> from the stored
@@ -183,6 +183,10 @@ Takes the following named arguments:
 
 The size of the buffer area.
 
+=item retained => BOOL
+
+If true, enables retained mode; see C<set_retained>.
+
 =back
 
 =cut
@@ -195,7 +199,10 @@ sub new
    my $lines = $args{lines};
    my $cols  = $args{cols};
 
-   return $class->_xs_new( $lines, $cols );
+   my $self = $class->_xs_new( $lines, $cols );
+   $self->set_retained( 1 ) if $args{retained};
+
+   return $self;
 }
 
 =head1 METHODS
@@ -210,6 +217,41 @@ Returns the size of the buffer area
 
 =cut
 
+=head2 $rb->resize( $lines, $cols )
+
+Changes the size of the buffer area, and resets it as by C<reset>. The cell
+storage is reused where it is large enough. In retained mode the remembered
+terminal content is forgotten, as it cannot be meaningful at a new size.
+
+=cut
+
+=head2 $stats = $rb->stats
+
+Returns a new HASH reference of counters of the work this buffer has done
+since it was constructed.
+
+=over 4
+
+=item spans => INT
+
+Spans of cells created by drawing operations
+
+=item pen_merges => INT
+
+Drawing pens merged with the current state pen
+
+=item text_bytes => INT
+
+Bytes of text stored by C<text> operations
+
+=item cells_flushed => INT
+
+Cells sent to a terminal by C<flush_to_term>
+
+=back
+
+=cut
+
 =head2 $line = $rb->line
 
 =head2 $col = $rb->col
@@ -279,7 +321,9 @@ offset by the given amount.
 
 Removes any pending changes and reverts the C<RenderBuffer> to its default
 empty state. Undefines the virtual cursor position, resets the clipping
-rectangle, and clears the stack of saved state.
+rectangle, and clears the stack of saved state. Only those lines that were
+drawn to since the previous reset need clearing, so a buffer can cheaply be
+reused for successive frames.
 
 =cut
 
@@ -346,7 +390,9 @@ Sets the range of cells starting at the given position, to render the given
 text in the given pen.
 
 Returns the number of columns wide the actual C<$text> is (which may be more
-than was actually printed).
+than was actually printed). When called in void context the text is only
+measured as far as the right edge of the clipping region, so drawing a small
+part of a long string costs no more than the part that is visible.
 
 =cut
 
@@ -523,6 +569,59 @@ efficient than many single-column wide C<text_at> calls.
 
 =cut
 
+=head2 $rb->apply_ops( \@ops )
+
+Performs a list of drawing operations in a single call. Each element of
+C<@ops> is an ARRAY reference giving the name of a method followed by its
+arguments, exactly as they would be passed to that method:
+
+ $rb->apply_ops( [
+    [ save    => ],
+    [ setpen  => $pen ],
+    [ text_at => 0, 0, "Name" ],
+    [ erase_at => 0, 4, 6 ],
+    [ restore => ],
+ ] );
+
+The methods that may be named are C<save>, C<savepen>, C<restore>, C<clear>,
+C<translate>, C<clip>, C<mask>, C<goto>, C<setpen>, C<skip_at>, C<skip>,
+C<skip_to>, C<text_at>, C<text>, C<erase_at>, C<erase>, C<erase_to>,
+C<eraserect>, C<char_at>, C<char>, C<hline_at> and C<vline_at>. As no return
+values are collected, C<text_at> measures its text only as far as the edge of
+the clipping region, as it does in void context.
+
+Because no method is resolved and no arguments are unpacked in Perl for each
+operation, this is considerably cheaper than making the same calls
+individually when drawing many small pieces. The list is not altered, so a
+widget whose content has not changed may keep the list it built for a
+previous render and simply apply it again.
+
+An unrecognised operation, wrong number of arguments or argument of the wrong
+type throws an exception naming the index of the operation, before any of the
+list has been performed. An operation that needs a virtual cursor position but
+finds none throws the same exception as the method does, once the operations
+before it have been performed.
+
+=cut
+
+=head2 $rb->render_tiled( $nthreads, [ $rect, \@ops ], ... )
+
+Performs several lists of drawing operations, as for C<apply_ops>, each
+clipped to its own C<Tickit::Rect>, using up to C<$nthreads> threads to draw
+them at once. Each list is drawn into a private buffer covering just its
+rectangle, in the same coordinates as C<$rb>, starting with no pen or
+translation of its own. Once all are drawn, each is copied into C<$rb> in the
+order given, as by C<blit>, so rectangles may overlap.
+
+Because a tile is copied as C<blit> copies, a cell it skips shows whatever was
+beneath it rather than being reset to skipped.
+
+The lists are all checked before any drawing begins, throwing the same
+exceptions as C<apply_ops>. The threads are started the first time they are
+needed, and kept by the buffer for later calls.
+
+=cut
+
 =head2 $cell = $rb->get_cell( $line, $col )
 
 Returns a structure containing the content stored in the given cell. The
@@ -581,6 +680,20 @@ sub get_cell
    }
 }
 
+=head2 $rb->blit( $src, $rect, $line, $col )
+
+Copies the content of another C<Tickit::RenderBuffer> within the given
+L<Tickit::Rect> into this one, with the top-left corner of the rectangle
+placed at the given position. The copied cells behave exactly as if they had
+been drawn directly by the drawing methods; they are subject to this buffer's
+translation, clipping and masking, and their pens are merged with this
+buffer's current pen. Skipped cells in the source leave this buffer's
+existing content alone. The source buffer is unchanged, and must not be the
+same buffer.
+
+This allows a rendering to be drawn once into a private buffer, and then
+cheaply composed into the real one as many times as required.
+
 =head2 $rb->flush_to_window( $win )
 
 Renders the stored content to the given L<Tickit::Window>. After this, the
@@ -596,6 +709,26 @@ renderbuffer and use the C<flush_to_term> method.
 Renders the stored content to the given L<Tickit::Term>. After this, the
 buffer will be cleared and reset back to initial state.
 
+If the whole terminal is to be erased with a single pen, and the terminal
+reports that erasing uses the current background colour (see
+C<TERMCTL_BCE> in L<Tickit::Term>), it is sent as one C<clear> rather than
+erasing every line separately.
+
+=cut
+
+=head2 $rb->flush_to_terms( @terms )
+
+Renders the stored content to every one of the given L<Tickit::Term>
+instances, then resets the buffer as for C<flush_to_term>. Terminals of the
+same type, size, colour depth, pen and cursor position would all be sent the
+same bytes. For each such set, the output is generated once and copied to
+the other terminals in the set. The terminals still need flushing
+individually afterwards.
+
+In retained mode, all of the terminals must currently display what this
+buffer last flushed to them, as each set is sent the same changes. Scrolling
+of unchanged lines is not used when there is more than one set.
+
 =cut
 
 my $warned_flush_to_window;
@@ -651,6 +784,36 @@ sub flush_to_window
 Renders the stored content to the given L<Tickit::Term>. After this, the
 buffer will be cleared and reset back to initial state.
 
+In retained mode, only those cells whose content or pen differ from what the
+buffer last flushed to the terminal are sent. Additionally, if a block of
+whole lines that are drawn entirely in this frame already appears on the
+terminal at a different vertical position, it is moved there using the
+terminal's C<scrollrect> operation rather than being drawn again.
+
+=cut
+
+=head2 $rb->set_retained( $retained )
+
+=head2 $retained = $rb->is_retained
+
+Enables or disables retained mode. While enabled, the buffer remembers what it
+believes the terminal currently displays, so that C<flush_to_term> only needs
+to send the differences. This assumes the buffer is always flushed to the same
+terminal, and that nothing else draws to it; see C<invalidate>.
+
+=cut
+
+=head2 $rb->invalidate
+
+=head2 $rb->invalidate( $rect )
+
+Forgets the retained terminal content, either entirely, or within the given
+L<Tickit::Rect>, so it will be drawn afresh by the next C<flush_to_term>.
+This should be called after anything else has drawn to the terminal (such as
+a C<clear> or C<scrollrect> operation). The rectangle is given in terminal
+coordinates, and is not affected by C<translate> or C<clip>. Has no effect if
+retained mode is not enabled.
+
 =cut
 
 ## Tickit::Debug wrapping support
@@ -12,6 +12,7 @@ use 5.010;
 our $VERSION = '0.49';
 
 use Carp;
+use Scalar::Util qw( weaken refaddr );
 
 use Tickit::Pen;
 use Tickit::Style::Parser;
@@ -26,6 +27,23 @@ our @EXPORTS = qw(
 # {$type}->{$class} = $tagset
 my %TAGSETS_BY_TYPE_CLASS;
 
+# {$type}->{$class} = [ [ $tagmask, $style ], ... ]
+my %COMPILED_BY_TYPE_CLASS;
+
+# {$type}->{$classkey}->{$tagmask} = { values => \%values, pens => \%pens }
+my %RESOLVED;
+
+# Style tags are numbered as they are first seen, and a set of them is kept as
+# a bit string, so that a widget's tag state is a cheap hash key and testing a
+# keyset against it is a single string AND
+my %TAG_BITS;
+my $NEXT_TAG_BIT = 0;
+
+# {refaddr $widget} = $widget, weakened; every widget that may have resolved a
+# style, so it can be told when that style changes
+my %WIDGETS;
+my $WIDGETS_PRUNE_AT = 64;
+
 # {$type}->{$key} = 1
 my %RESHAPE_KEYS;
 my %RESHAPE_TEXTWIDTH_KEYS;
@@ -238,6 +256,111 @@ sub _ref_tagset
    return $TAGSETS_BY_TYPE_CLASS{$type}{$class} ||= Tickit::Style::_Tagset->new;
 }
 
+sub _tag_bit
+{
+   my ( $tag ) = @_;
+   return $TAG_BITS{$tag} //= $NEXT_TAG_BIT++;
+}
+
+sub _tags_to_mask
+{
+   my ( $tags ) = @_;
+
+   my $mask = "";
+   vec( $mask, _tag_bit( $_ ), 1 ) = 1 for grep { $tags->{$_} } keys %$tags;
+   return $mask;
+}
+
+# Returns a new mask with the given tag set or cleared. Trailing zero bytes are
+# trimmed, so that each set of tags has exactly one mask
+sub _mask_set_tag
+{
+   my ( $mask, $tag, $value ) = @_;
+
+   vec( $mask, _tag_bit( $tag ), 1 ) = $value ? 1 : 0;
+   $mask =~ s/\0+\z//;
+   return $mask;
+}
+
+# A compiled tagset gives the tag mask each keyset depends on, still in
+# most-tags-first order
+sub _compile_tagset
+{
+   my ( $tagset ) = @_;
+   return [ map { [ _tags_to_mask( $_->tags ), $_->style ] } $tagset->keysets ];
+}
+
+# Adds to %$values every key from the keysets that apply on $mask, unless
+# already present
+sub _resolve_compiled
+{
+   my ( $compiled, $mask, $values ) = @_;
+
+   foreach my $keyset ( @$compiled ) {
+      my ( $needs, $style ) = @$keyset;
+      ( $needs & $mask ) eq $needs or next;
+
+      exists $values->{$_} or $values->{$_} = $style->{$_} for keys %$style;
+   }
+}
+
+# The resolved style for a widget type and list of classes with a given tag
+# mask, shared between all the widgets in that state. Its pens are immutable,
+# so they are safe to share too
+sub _resolved
+{
+   my ( $type, $classes, $classkey, $mask ) = @_;
+
+   return $RESOLVED{$type}{$classkey}{$mask} ||= do {
+      my %values;
+      foreach my $class ( @$classes, undef ) {
+         my $compiled = $COMPILED_BY_TYPE_CLASS{$type}{$class // ""} ||=
+            _compile_tagset( _ref_tagset( $type, $class ) );
+         _resolve_compiled( $compiled, $mask, \%values );
+      }
+
+      +{ values => \%values, pens => {} };
+   };
+}
+
+sub _register_widget
+{
+   my ( $widget ) = @_;
+
+   # Widgets don't unregister themselves, so sweep out the dead ones whenever
+   # the set has doubled in size
+   if( keys %WIDGETS >= $WIDGETS_PRUNE_AT ) {
+      defined $WIDGETS{$_} or delete $WIDGETS{$_} for keys %WIDGETS;
+      $WIDGETS_PRUNE_AT = 2 * keys %WIDGETS;
+      $WIDGETS_PRUNE_AT = 64 if $WIDGETS_PRUNE_AT < 64;
+   }
+
+   weaken( $WIDGETS{refaddr $widget} = $widget );
+}
+
+# Recompiles every tagset now, and drops the resolved tables; those are built
+# again only as each state is used, since building them all would mean every
+# combination of tags
+sub _recompile
+{
+   undef %RESOLVED;
+   undef %COMPILED_BY_TYPE_CLASS;
+
+   foreach my $type ( keys %TAGSETS_BY_TYPE_CLASS ) {
+      my $tagsets = $TAGSETS_BY_TYPE_CLASS{$type};
+      $COMPILED_BY_TYPE_CLASS{$type}{$_} = _compile_tagset( $tagsets->{$_} ) for keys %$tagsets;
+   }
+}
+
+# Lets every existing widget apply any change the recompiled style makes to it
+sub _restyle_widgets
+{
+   foreach my $key ( keys %WIDGETS ) {
+      my $widget = $WIDGETS{$key} or delete $WIDGETS{$key}, next;
+      $widget->_style_restyle;
+   }
+}
+
 =head1 FUNCTIONS
 
 =cut
@@ -272,6 +395,9 @@ sub style_definition
 
    my $type = $class->_widget_style_type;
    _ref_tagset( $type, undef )->merge_with_tags( \%tags, \%definition );
+
+   _recompile();
+   _restyle_widgets();
 }
 
 =head2 style_reshape_keys( @keys )
@@ -357,9 +483,13 @@ sub _load_style
       $tagset->merge_with_tags( $def->tags, $def->style );
    }
 
+   _recompile();
+
    foreach my $code ( @ON_STYLE_LOAD ) {
       $code->();
    }
+
+   _restyle_widgets();
 }
 
 =head1 ADDITIONAL FUNCTIONS/METHODS
@@ -373,7 +503,9 @@ These functions are not exported, but may be called directly.
 Loads definitions from a stylesheet given in a string.
 
 Definitions will be merged with existing definitions in memory, with new
-values overwriting existing values.
+values overwriting existing values. Widgets that already exist take on any
+changed values at once, setting their pens and reshaping or redrawing just as
+for a change of style tag.
 
 =cut
 
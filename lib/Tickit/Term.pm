@@ -157,7 +157,60 @@ seconds.
 
 =head2 $term->flush
 
-Flushes the output buffer to the terminal
+Flushes the output buffer to the terminal. If the output handle is
+non-blocking and will not accept all of it, the remainder is kept in a queue
+to be written once the handle is writable.
+
+=cut
+
+=head2 $bytes = $term->output_pending
+
+Returns the number of bytes of output queued because the (non-blocking)
+output handle would not yet accept them. While this is non-zero the output
+handle should be watched for writability, and C<output_writable> invoked when
+it becomes so.
+
+=cut
+
+=head2 $term->output_writable
+
+Informs the term that the output handle may be writable. Attempts to write
+more of the queued output.
+
+=cut
+
+=head2 $stats = $term->stats
+
+Returns a new HASH reference of counters of the work this term has done since
+it was constructed, useful for measuring the cost of output.
+
+=over 4
+
+=item bytes => INT
+
+Bytes of output written to the output handle or passed to the output function
+
+=item writes => INT
+
+Number of calls to write the output handle
+
+=item flushes => INT
+
+Number of flushes of a non-empty output buffer
+
+=item setpens => INT
+
+Number of C<chpen> or C<setpen> calls that changed any attribute
+
+=item gotos => INT
+
+Number of successful C<goto> calls
+
+=item scrollrects => INT
+
+Number of successful C<scrollrect> calls
+
+=back
 
 =cut
 
@@ -189,6 +242,7 @@ integer or string event name, C<press>, C<drag>, C<release> or C<wheel>),
 C<button> (an integer for non-wheel events, or a dualvar for wheel events
 giving the wheel direction as C<up> or C<down>), C<line> and C<col> as
 integers, and C<mod> (an integer bitmask indicating the modifier state).
+Wheel events also contain C<count>, the number of steps the wheel moved.
 
 =item resize
 
@@ -393,6 +447,18 @@ Enables mouse tracking mode. C<$vaule> should be one of
 C<TERM_MOUSEMODE_CLICK>, C<TERM_MOUSEMODE_DRAG>, C<TERM_MOUSEMODE_MOVE> or
 C<TERM_MOUSEMODE_OFF>.
 
+=item TERMCTL_SYNC_OUTPUT
+
+Enables synchronized output mode, where the terminal holds back updating the
+display until it is disabled again. Terminals that don't report supporting
+DEC mode 2026 are not sent it, though the value is still remembered.
+
+=item TERMCTL_BCE
+
+(read-only) True if the terminal performs back-colour-erase; that is, if
+erasing cells fills them with the current background colour. Drivers that
+don't know do not answer it.
+
 =back
 
 =head2 $success = $term->setctl_str( $ctl, $value )
@@ -415,6 +481,17 @@ Sets the terminal window icon text, title, or both.
 
 =cut
 
+=head2 $coalesce = $term->get_mouse_coalesce
+
+=head2 $term->set_mouse_coalesce( $coalesce )
+
+Query or set whether mouse input is coalesced. When enabled, a run of C<drag>
+events of the same button, or of C<wheel> events in the same direction, within
+one batch of input is delivered as a single event; the last position of the
+drag, or a wheel event whose C<count> gives the total number of steps. Any
+other input first delivers the event held back, so presses and releases
+always stay in order. Disabled by default.
+
 =head2 $term->input_push_bytes( $bytes )
 
 Feeds more bytes of input. May result in C<on_key> or C<on_mouse> events.
@@ -433,7 +510,9 @@ bytes of input. May result in C<on_key> or C<on_mouse> events.
 Block until some input is available, and process it. Returns after one round
 of input has been processed. May result in C<on_key> or C<on_mouse> events. If
 C<$timeout> is defined, it will wait a period of time no longer than this time
-before returning, even if no input events were received.
+before returning, even if no input events were received. While output is
+pending it also waits for the output handle to become writable, and writes
+more of it.
 
 =cut
 
@@ -114,6 +114,13 @@ though can be overridden by passing named arguments.
 
  $term = mk_term lines => 30, cols => 100;
 
+Tests that only check the display, such as load tests which render many
+frames, can limit the method log to save memory and time. A C<log_limit> of
+zero disables it, and any other value keeps only that many of the most recent
+entries.
+
+ $term = mk_term log_limit => 0;
+
 =cut
 
 sub mk_term
@@ -259,6 +266,7 @@ sub pressmouse
       line   => $line,
       col    => $col,
       mod    => $mod||0,
+      ( $ev eq "wheel" ? ( count => 1 ) : () ),
    } );
 }
 
@@ -485,11 +493,12 @@ sub is_display
             }
 
             my $want_pen = _pen2string( $chunk->[1] );
+            my @got_pens = $term->get_display_pens( $line, $col, textwidth $want_text );
             my $idx = 0;
             while( $idx < textwidth $want_text ) {
                if( substrwidth( $want_text, $idx, 1 ) eq " " ) {
                   my $want_bg = $chunk->[1]->{bg} // "undef";
-                  my $got_bg = $term->get_display_pen( $line, $col )->{bg} // "undef";
+                  my $got_bg = $got_pens[$idx]->{bg} // "undef";
                   if( $got_bg ne $want_bg ) {
                      my $ok = $tb->ok( 0, $name );
                      $tb->diag( "Display differs on line $line at column $col" );
@@ -499,7 +508,7 @@ sub is_display
                   }
                }
                else {
-                  my $got_pen = _pen2string( $term->get_display_pen( $line, $col ) );
+                  my $got_pen = _pen2string( $got_pens[$idx] );
                   if( $got_pen ne $want_pen ) {
                      my $ok = $tb->ok( 0, $name );
                      $tb->diag( "Display differs on line $line at column $col" );
@@ -12,7 +12,10 @@ sub new
    my $class = shift;
    my %args = @_;
 
-   return $class->_new_mocking( $args{lines} || 25, $args{cols} || 80 );
+   my $self = $class->_new_mocking( $args{lines} || 25, $args{cols} || 80 );
+   $self->set_log_limit( $args{log_limit} ) if defined $args{log_limit};
+
+   return $self;
 }
 
 # TODO: this needs to live in .xs code now
@@ -19,6 +19,9 @@ our @EXPORT_OK = qw(
 
    textwidth
 
+   ambiguous_width
+   set_ambiguous_width
+
    chars2cols
    cols2chars
 
@@ -66,6 +69,20 @@ Returns the number of screen columns consumed by the given (Unicode) string.
 
 # Provided by XS
 
+=head2 $width = ambiguous_width
+
+=head2 set_ambiguous_width( $width )
+
+Returns or sets the number of columns counted for characters of East Asian
+Ambiguous width, such as many Greek, Cyrillic and box-drawing characters.
+These count as 1 by default, as most terminals display them; terminals set up
+for CJK locales may instead draw them as 2. The setting applies to all string
+counting, both here and in the C library.
+
+=cut
+
+# Provided by XS
+
 =head2 @cols = chars2cols( $text, @chars )
 
 Given a list of increasing character positions, returns a list of column
@@ -12,9 +12,10 @@ our $VERSION = '0.49';
 
 use Carp;
 use Scalar::Util qw( weaken );
-use List::MoreUtils qw( all );
 
 use Tickit::Pen;
+use Tickit::Rect;
+use Tickit::RenderBuffer;
 use Tickit::Style;
 use Tickit::Utils qw( textwidth );
 
@@ -26,6 +27,8 @@ use constant KEYPRESSES_FROM_STYLE => 0;
 
 use constant CAN_FOCUS => 0;
 
+use constant CACHE_RENDER => 0;
+
 =head1 NAME
 
 C<Tickit::Widget> - abstract base class for on-screen widgets
@@ -136,8 +139,11 @@ sub new
 
    my $self = bless {
       classes => delete $args{classes} // [ delete $args{class} ],
+      style_tagmask => "",
    }, $class;
 
+   $self->{style_classkey} = join "|", map { $_ // "" } @{ $self->{classes} };
+
    if( $class->WIDGET_PEN_FROM_STYLE ) {
       $args{$_} and $args{style}{$_} = delete $args{$_} for @Tickit::Pen::ALL_ATTRS;
    }
@@ -153,6 +159,8 @@ sub new
       }
    }
 
+   Tickit::Style::_register_widget( $self );
+
    if( $class->WIDGET_PEN_FROM_STYLE ) {
       $self->set_pen( $self->get_style_pen->as_mutable );
    }
@@ -238,15 +246,43 @@ sub set_style_tag
    $values{$keys[$_]}[0] = $old_values[$_] for 0 .. $#keys;
 
    $self->{style_tag}{$tag} = !!$value;
+   $self->{style_tagmask} = Tickit::Style::_mask_set_tag( $self->{style_tagmask}, $tag, $value );
+   undef $self->{style_resolved};
 
    $self->_style_changed_values( \%values );
 }
 
-sub _style_tags
+# The widget keeps hold of the shared table it resolved, until either its tags
+# change or Tickit::Style tells it that the style was reloaded
+sub _style_resolved
+{
+   my $self = shift;
+   return $self->{style_resolved} ||= Tickit::Style::_resolved( $self->_widget_style_type,
+      $self->{classes}, $self->{style_classkey}, $self->{style_tagmask} );
+}
+
+# Called by Tickit::Style after loading a stylesheet or definition
+sub _style_restyle
 {
    my $self = shift;
-   my $tags = $self->{style_tag};
-   return join "|", sort grep { $tags->{$_} } keys %$tags;
+
+   my $old = $self->{style_resolved} or return; # never looked; nothing to change
+   my $new = Tickit::Style::_resolved( $self->_widget_style_type,
+      $self->{classes}, $self->{style_classkey}, $self->{style_tagmask} );
+
+   my %values;
+   $values{$_} ||= [] for keys %{ $old->{values} }, keys %{ $new->{values} };
+
+   my @keys = keys %values;
+
+   my @old_values = $self->get_style_values( @keys );
+   $values{$keys[$_]}[0] = $old_values[$_] for 0 .. $#keys;
+
+   $self->{style_resolved} = $new;
+   # These merged the direct-applied style over the old table
+   undef $self->{style_pen_cache};
+
+   $self->_style_changed_values( \%values );
 }
 
 =head2 @values = $widget->get_style_values( @keys )
@@ -264,50 +300,25 @@ sub get_style_values
    my $self = shift;
    my @keys = @_;
 
-   my $type = $self->_widget_style_type;
-
-   my @set = ( 0 ) x @keys;
-   my @values = ( undef ) x @keys;
-
-   my $tags = $self->{style_tag};
-   my $cache = $self->{style_cache}{$self->_style_tags} ||= {};
-
-   foreach my $i ( 0 .. $#keys ) {
-      next unless exists $cache->{$keys[$i]};
-
-      $set[$i] = 1;
-      $values[$i] = $cache->{$keys[$i]};
-   }
-
-   my @classes = ( $self->style_classes, undef );
-   my $tagset = $self->{style_direct};
-
-   while( !all { $_ } @set and @classes ) {
-      # First time around this uses the direct style, if set. Thereafter uses
-      # the style classes in order, finally the unclassed base.
-      defined $tagset or $tagset = Tickit::Style::_ref_tagset( $type, shift @classes );
-
-      KEYSET: foreach my $keyset ( $tagset->keysets ) {
-         $tags->{$_} or next KEYSET for keys %{ $keyset->tags };
-
-         my $style = $keyset->style;
-
-         foreach ( 0 .. $#keys ) {
-            exists $style->{$keys[$_]} or next;
-            $set[$_] and next;
-
-            $values[$_] = $style->{$keys[$_]};
-            $set[$_] = 1;
-         }
-      }
+   my $resolved = $self->_style_resolved->{values};
+
+   my @values;
+   if( my $tagset = $self->{style_direct} ) {
+      # The direct-applied style is this widget's alone, so it is resolved
+      # separately and takes precedence over the shared resolved style
+      my $mask = $self->{style_tagmask};
+      my $direct = $self->{style_cache}{$mask} ||= do {
+         my %values;
+         Tickit::Style::_resolve_compiled(
+            $self->{style_direct_compiled} ||= Tickit::Style::_compile_tagset( $tagset ),
+            $mask, \%values );
+         \%values;
+      };
 
-      undef $tagset;
+      @values = map { exists $direct->{$_} ? $direct->{$_} : $resolved->{$_} } @keys;
    }
-
-   foreach my $i ( 0 .. $#keys ) {
-      next if exists $cache->{$keys[$i]};
-
-      $cache->{$keys[$i]} = $values[$i];
+   else {
+      @values = @{$resolved}{@keys};
    }
 
    return @values if wantarray;
@@ -352,7 +363,11 @@ sub get_style_pen
    my $class = ref $self;
    my ( $prefix ) = @_;
 
-   return $self->{style_pen_cache}{$self->_style_tags}{$prefix//""} ||= do {
+   my $pens = $self->{style_direct}
+      ? ( $self->{style_pen_cache}{$self->{style_tagmask}} ||= {} )
+      : $self->_style_resolved->{pens};
+
+   return $pens->{$prefix//""} ||= do {
       my @keys = map { defined $prefix ? "${prefix}_$_" : $_ } @Tickit::Pen::ALL_ATTRS;
 
       my %attrs;
@@ -429,9 +444,10 @@ sub _style_changed_values
    my @keys = keys %$values;
 
    if( $invalidate_caches ) {
-      foreach my $keyset ( values %{ $self->{style_cache} } ) {
-         delete $keyset->{$_} for @keys;
-      }
+      # The direct-applied style changed; everything resolved from it is stale
+      undef $self->{style_direct_compiled};
+      undef $self->{style_cache};
+      undef $self->{style_pen_cache};
    }
 
    my @new_values = $self->get_style_values( @keys );
@@ -457,12 +473,6 @@ sub _style_changed_values
          $changed_pens{$1}++;
    }
 
-   if( $invalidate_caches ) {
-      foreach my $penset ( values %{ $self->{style_pen_cache} } ) {
-         delete $penset->{$_} for keys %changed_pens;
-      }
-   }
-
    if( $changed_pens{""} and $self->WIDGET_PEN_FROM_STYLE ) {
       $self->set_pen( $self->get_style_pen->as_mutable );
    }
@@ -568,7 +578,12 @@ sub window_gained
 
       $rb->setpen( $self->pen );
 
-      $self->render_to_rb( $rb, $rect );
+      if( $self->CACHE_RENDER ) {
+         $self->_render_cached( $win, $rb, $rect );
+      }
+      else {
+         $self->render_to_rb( $rb, $rect );
+      }
    });
 
    $window->set_on_focus( sub {
@@ -640,6 +655,40 @@ sub window_lost
    $window->set_on_focus( undef );
    $window->set_on_key( undef );
    $window->set_on_mouse( undef );
+
+   undef $self->{render_cache};
+}
+
+# Renders the whole window into a private buffer the first time it is needed
+# after a redraw, then satisfies every exposure by copying from that
+sub _render_cached
+{
+   my $self = shift;
+   my ( $win, $rb, $rect ) = @_;
+
+   my $cache = $self->{render_cache} ||= Tickit::RenderBuffer->new(
+      lines => $win->lines,
+      cols  => $win->cols,
+   );
+
+   if( $cache->lines != $win->lines or $cache->cols != $win->cols ) {
+      $cache->resize( $win->lines, $win->cols );
+      undef $self->{render_cache_valid};
+   }
+
+   if( !$self->{render_cache_valid} ) {
+      $cache->reset;
+      $cache->setpen( $self->pen );
+      $self->render_to_rb( $cache, Tickit::Rect->new(
+         top   => 0,
+         left  => 0,
+         lines => $win->lines,
+         cols  => $win->cols,
+      ) );
+      $self->{render_cache_valid} = 1;
+   }
+
+   $rb->blit( $cache, $rect, $rect->top, $rect->left );
 }
 
 =head2 $window = $widget->window
@@ -773,6 +822,8 @@ sub redraw
 {
    my $self = shift;
 
+   undef $self->{render_cache_valid};
+
    $self->window or return;
    $self->window->expose;
 }
@@ -943,6 +994,21 @@ Optional, normally false. If this constant method returns a true value, the
 widget is allowed to take focus using the C<take_focus> method. It will also
 take focus automatically if it receives a mouse button 1 press event.
 
+=head2 $widget->CACHE_RENDER
+
+Optional, normally false. If this constant method returns a true value, the
+widget's C<render_to_rb> method is invoked to draw the entire window into a
+private L<Tickit::RenderBuffer>, which is then kept. Exposures of the window,
+such as those caused by a sibling changing or a floating window moving over
+it, are satisfied by copying from this buffer using its C<blit> method,
+without invoking C<render_to_rb> again. The cached rendering is discarded
+when the widget's C<redraw> method is called, when the widget's pen or style
+changes, or when the window changes size.
+
+This suits widgets whose rendering is expensive. A widget using it must call
+C<redraw>, rather than just exposing its window, whenever its content
+changes.
+
 =head2 $widget->KEYPRESSES_FROM_STYLE
 
 Optional, normally false. If this constant method returns a true value, the
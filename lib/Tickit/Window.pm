@@ -15,6 +15,7 @@ use Carp;
 
 use Scalar::Util qw( weaken refaddr blessed );
 use List::Util qw( first );
+use Time::HiRes qw( time );
 
 use Tickit::Pen;
 use Tickit::Rect;
@@ -120,6 +121,7 @@ sub new
       damage  => Tickit::RectSet->new,
    }, $class;
    $self->_init;
+   $self->{cwin}->set_geometry( 0, 0, $lines, $cols );
 
    weaken( $self->{tickit} );
 
@@ -134,6 +136,29 @@ sub _init
    $self->{pen}     = Tickit::Pen->new;
    $self->{expose_after_scroll} = 1;
    $self->{cursor_visible} = 1;
+
+   # The native window mirrors the tree so exposure can be walked in C
+   $self->{cwin} = Tickit::_Window->new( $self, $self->{parent} ? $self->{parent}{cwin} : undef );
+   $self->{cwin}->set_pen( $self->{pen} );
+   # Under debugging every window is called back, so the walk can be logged
+   $self->{cwin}->set_has_expose( 1 ) if DEBUG;
+}
+
+# During global destruction windows and their native halves are destroyed in no
+# particular order, so there may be nothing left to tell
+sub _in_global_destruct
+{
+   return ( ${^GLOBAL_PHASE} // "" ) eq "DESTRUCT";
+}
+
+sub _sync_children
+{
+   my $self = shift;
+
+   return if _in_global_destruct;
+   my $cwin = $self->{cwin} or return;
+
+   $cwin->set_children( grep { defined } map { $_->{cwin} } $self->subwindows );
 }
 
 # We need to ensure all geomety changes happen before any redrawing
@@ -169,28 +194,60 @@ sub _on_later
       }
    }
 
+   if( $self->{needs_expose} and $self->term->output_pending ) {
+      # The terminal hasn't yet taken all of the previous frame; drawing
+      # another now would only queue up behind it
+      $self->{later_queued}++;
+      $self->tickit->_later_writable( sub { $self->_on_later } );
+      return;
+   }
+
+   if( $self->{needs_expose} and my $rate = $self->{max_frame_rate} ) {
+      my $next_frame_at = ( $self->{last_frame_at} // 0 ) + 1 / $rate;
+      if( time < $next_frame_at ) {
+         # Too soon after the previous frame; leave the damage to accumulate
+         # until the next frame is due
+         $self->{later_queued}++;
+         $self->tickit->timer( at => $next_frame_at, sub { $self->_on_later } );
+         return;
+      }
+   }
+
    if( $self->{needs_expose} ) {
       undef $self->{needs_expose};
       my @rects = $self->{damage}->rects;
       $self->{damage}->clear;
 
+      my $start = time;
+      $self->{last_frame_at} = $start if $self->{max_frame_rate};
+
+      # Have the terminal show the whole frame at once, if it can
+      $self->term->setctl_int( sync_output => 1 );
       $self->term->setctl_int( cursorvis => 0 );
 
-      my $rb = Tickit::RenderBuffer->new(
-         lines => $self->lines,
-         cols  => $self->cols,
-      );
+      my $rb = $self->_render_buffer;
+
+      unless( eval { $self->{cwin}->render_rect( $rb, $_ ) for @rects; 1 } ) {
+         my $e = $@;
+         # Nothing of this frame was sent; leave the terminal drawing again,
+         # and try the whole frame once more on the next iteration
+         $self->term->setctl_int( sync_output => 0 );
+         $self->{damage}->add_many( @rects );
+         $self->{needs_expose} = 1;
+         $self->_needs_later;
+         die $e;
+      }
 
-      foreach my $rect ( @rects ) {
-         $rb->save;
-         $rb->clip( $rect );
+      my $rendered = time;
 
-         $self->_do_expose( $rect, $rb );
+      $rb->flush_to_term( $self->term );
 
-         $rb->restore;
-      }
+      $self->term->setctl_int( sync_output => 0 );
 
-      $rb->flush_to_term( $self->term );
+      my $stats = $self->{frame_stats} ||= { frames => 0, render_time => 0, flush_time => 0 };
+      $stats->{frames}++;
+      $stats->{render_time} += $rendered - $start;
+      $stats->{flush_time}  += time - $rendered;
 
       $self->{needs_restore}++;
    }
@@ -229,6 +286,7 @@ sub _close
 
    defined and $_->_close for @{ $self->{child_windows} };
    undef $self->{child_windows};
+   $self->{cwin}->set_children if $self->{cwin} and !_in_global_destruct;
    @{ $self->{pending_geom_changes} } = ();
 }
 
@@ -276,6 +334,8 @@ sub _do_change_children
          undef $self->{focused_child};
       }
    }
+
+   $self->_sync_children;
 }
 
 sub _change_children
@@ -331,6 +391,7 @@ sub make_hidden_sub
 
    my $sub = $self->make_sub( @_ );
    $sub->{visible} = 0;
+   $sub->{cwin}->set_visible( 0 );
 
    return $sub;
 }
@@ -466,6 +527,8 @@ sub _reorder_child
       splice @$children, $idx + $where, 0, ( $child );
    }
 
+   $self->_sync_children;
+
    $self->expose( $child->rect );
 }
 
@@ -558,6 +621,7 @@ sub show
 {
    my $self = shift;
    $self->{visible} = 1;
+   $self->{cwin}->set_visible( 1 );
 
    if( my $parent = $self->parent ) {
       if( !$parent->{focused_child} and $self->{focused_child} || $self->is_focused ) {
@@ -580,6 +644,7 @@ sub hide
 {
    my $self = shift;
    $self->{visible} = 0;
+   $self->{cwin}->set_visible( 0 );
 
    if( my $parent = $self->parent ) {
       if( $parent->{focused_child} and $parent->{focused_child} == $self ) {
@@ -653,6 +718,7 @@ sub change_geometry
       $self->{cols} = $cols;
       $self->{top} = $top;
       $self->{left} = $left;
+      $self->{cwin}->set_geometry( $top, $left, $lines, $cols );
 
       $self->{on_geom_changed}->( $self ) if $self->{on_geom_changed};
    }
@@ -812,7 +878,7 @@ A mouse button was released after being pressed
 =item wheel
 
 The mouse wheel was moved. C<button> will indicate the wheel direction as a
-string C<up> or C<down>.
+string C<up> or C<down>, and C<count> how many steps it moved.
 
 =back
 
@@ -911,44 +977,28 @@ sub set_on_expose
    }
 
    ( $self->{on_expose} ) = @_;
+   $self->{cwin}->set_has_expose( DEBUG || defined $self->{on_expose} ) if $self->{cwin};
 }
 
-our $INDENT = "";
-sub _do_expose
+# Invoked by the native window walk, after any children within the rect
+sub _handle_expose
 {
    my $self = shift;
-   my ( $rect, $rb ) = @_;
-
-   $rb->setpen( $self->pen );
-
-   Tickit::Debug->log( Wx => "${INDENT}Expose %s %s", $self->sprintf, $rect->sprintf ) if DEBUG;
-   local $INDENT = "| $INDENT";
-
-   foreach my $win ( $self->subwindows ) {
-      next unless $win->is_visible;
+   my ( $rb, $rect ) = @_;
 
-      if( my $winrect = $rect->intersect( $win->rect ) ) {
-         $rb->save;
-
-         $rb->clip( $winrect );
-         $rb->translate( $win->top, $win->left );
-         $win->_do_expose( $winrect->translate( -$win->top, -$win->left ), $rb );
-
-         $rb->restore;
+   if( DEBUG ) {
+      my $indent = "";
+      for( my $win = $self->parent; $win; $win = $win->parent ) {
+         $indent .= "| ";
       }
-
-      $rb->mask( $win->rect );
+      Tickit::Debug->log( Wx => "${indent}Expose %s %s", $self->sprintf, $rect->sprintf );
    }
 
-   if( my $on_expose = $self->{on_expose} ) {
-      $rb->save;
-
-      local $self->{exposure_rb} = $rb;
+   my $on_expose = $self->{on_expose} or return;
 
-      $on_expose->( $self, $rb, $rect );
+   local $self->{exposure_rb} = $rb;
 
-      $rb->restore;
-   }
+   $on_expose->( $self, $rb, $rect );
 }
 
 =head2 $win->expose( $rect )
@@ -1063,6 +1113,103 @@ sub set_expose_after_scroll
    ( $self->{expose_after_scroll} ) = @_;
 }
 
+=head2 $win->set_retained_render( $retained )
+
+If set true on the root window, it keeps a single retained-mode
+L<Tickit::RenderBuffer> across exposures, so that each redraw only sends to
+the terminal those cells that actually changed since the previous one. This
+relies on the window knowing about everything drawn to the terminal; the
+legacy direct drawing methods, C<scrollrect> and C<clear> already account for
+themselves, but other code that writes to the terminal directly should not be
+mixed with retained rendering.
+
+=cut
+
+sub set_retained_render
+{
+   my $self = shift;
+   my ( $retained ) = @_;
+
+   croak "Can only ->set_retained_render on the root window" if $self->parent;
+
+   $self->{retained_render} = !!$retained;
+   $self->{rb}->set_retained( $self->{retained_render} ) if $self->{rb};
+}
+
+=head2 $win->set_max_frame_rate( $rate )
+
+If set on the root window, limits how many times per second it redraws.
+Exposures that arrive sooner than this after the previous redraw are gathered
+up and drawn together once the next frame is due. If undefined or zero, the
+window redraws as soon as anything is exposed.
+
+=cut
+
+sub set_max_frame_rate
+{
+   my $self = shift;
+   my ( $rate ) = @_;
+
+   croak "Can only ->set_max_frame_rate on the root window" if $self->parent;
+
+   $self->{max_frame_rate} = $rate;
+}
+
+=head2 $stats = $win->frame_stats
+
+Returns a new HASH reference of counters of the frames the root window has
+drawn so far. C<render_time> and C<flush_time> are the total seconds spent
+rendering damaged areas into the buffer, and flushing the buffer to the
+terminal.
+
+=over 4
+
+=item frames => INT
+
+=item render_time => NUM
+
+=item flush_time => NUM
+
+=back
+
+=cut
+
+sub frame_stats
+{
+   my $self = shift;
+
+   croak "Can only ->frame_stats on the root window" if $self->parent;
+
+   return { frames => 0, render_time => 0, flush_time => 0, %{ $self->{frame_stats} || {} } };
+}
+
+# The root window keeps one buffer for its whole lifetime; flushing it leaves
+# it reset for the next frame, and it is only reallocated when the terminal
+# changes size
+sub _render_buffer
+{
+   my $self = shift;
+
+   my $rb = $self->{rb} ||= Tickit::RenderBuffer->new(
+      lines    => $self->lines,
+      cols     => $self->cols,
+      retained => $self->{retained_render},
+   );
+
+   $rb->resize( $self->lines, $self->cols )
+      if $rb->lines != $self->lines or $rb->cols != $self->cols;
+
+   return $rb;
+}
+
+# Called with area in root coordinates, or no argument for the whole window
+sub _invalidate_retained
+{
+   my $self = shift;
+   my $rb = $self->root->{rb} or return;
+   $rb->invalidate( @_ );
+}
+
 =head2 $top = $win->top
 
 =head2 $bottom = $win->bottom
@@ -1212,6 +1359,7 @@ sub set_pen
    my $self = shift;
    ( $self->{pen} ) = @_;
    defined $self->{pen} or $self->{pen} = Tickit::Pen->new;
+   $self->{cwin}->set_pen( $self->{pen} );
 }
 
 =head2 $val = $win->getpenattr( $attr )
@@ -1268,63 +1416,14 @@ sub get_effective_penattr
    return undef;
 }
 
+# Each window caches what its children cover, so this costs one search per
+# ancestor rather than a scan of all their siblings
 sub _get_span_visibility
 {
    my $win = shift;
    my ( $line, $col ) = @_;
 
-   my ( $vis, $len ) = ( 1, $win->cols - $col );
-
-   my $prev;
-   while( $win ) {
-      # Off top, bottom or right: invisible and always going to be
-      if( $line < 0 or $line >= $win->lines or $col >= $win->cols ) {
-         return ( 0, undef );
-      }
-
-      # Off left: invisible for at least as far as it's off by
-      if( $col < 0 ) {
-         $len = -$col if $vis or -$col > $len;
-         $vis = 0;
-      }
-      # Within the window - visible for at most the width of the window
-      elsif( $vis ) {
-         my $remains = $win->cols - $col;
-         $len = $remains if $len > $remains;
-      }
-
-      $win->_reap_dead_children;
-      foreach my $child ( @{ $win->{child_windows} } ) {
-         last if $prev and $child == $prev;
-         next unless $child->{visible};
-         next if $child->top > $line or $child->bottom <= $line;
-
-         next if $col >= $child->right;
-
-         if( $child->left <= $col ) {
-            my $child_cols_hidden = $child->right - $col;
-            if( $vis ) {
-               $len = $child_cols_hidden;
-               $vis = 0;
-            }
-            else {
-               $len = $child_cols_hidden if $child_cols_hidden > $len;
-            }
-         }
-         elsif( $vis ) {
-            my $remaining_visible = $child->left - $col;
-            $len = $remaining_visible if $remaining_visible < $len;
-         }
-      }
-
-      $line += $win->top;
-      $col  += $win->left;
-
-      $prev = $win;
-      $win = $win->parent;
-   }
-
-   return ( $vis, $len );
+   return $win->{cwin}->get_span_visibility( $line, $col );
 }
 
 =head2 $win->goto( $line, $col )
@@ -1461,6 +1560,12 @@ sub print
          $term->setpen( $pen );
          $term->print( $chunk );
 
+         $self->_invalidate_retained( Tickit::Rect->new(
+               top  => ( $abs_top  //= $self->abs_top  ) + $line,
+               left => ( $abs_left //= $self->abs_left ) + $self->{output_column} + $prev_col,
+               lines => 1, cols => $pos->columns - $prev_col,
+         ) ) if $pos->columns > $prev_col;
+
          $need_flush = 1;
       }
       else {
@@ -1549,6 +1654,12 @@ sub erasech
          $term->setpen( $pen );
          $term->erasech( $len, $moveend );
 
+         $self->_invalidate_retained( Tickit::Rect->new(
+               top  => ( $abs_top  //= $self->abs_top  ) + $line,
+               left => ( $abs_left //= $self->abs_left ) + $self->{output_column},
+               lines => 1, cols => $len,
+         ) );
+
          $need_flush = 1;
       }
       else {
@@ -1677,17 +1788,17 @@ sub _scrollrectset
 
       # Move damage
       my $damageset = $win->{damage};
-      my @damage = $damageset->rects;
-      $damageset->clear;
-      foreach my $r ( @damage ) {
-         $damageset->add( $r ), next if $r->bottom < $rect->top or $r->top > $rect->bottom or
-                                        $r->right < $rect->left or $r->left > $rect->right;
+      my @damage;
+      foreach my $r ( $damageset->rects ) {
+         push( @damage, $r ), next if $r->bottom < $rect->top or $r->top > $rect->bottom or
+                                     $r->right < $rect->left or $r->left > $rect->right;
          my $inside = $r->intersect( $rect );
-         my @outside = $r->subtract( $rect );
 
-         $damageset->add( $_ ) for @outside;
-         $damageset->add( $inside->translate( -$downward, -$rightward ) ) if $inside;
+         push @damage, $r->subtract( $rect );
+         push @damage, $inside->translate( -$downward, -$rightward ) if $inside;
       }
+      $damageset->clear;
+      $damageset->add_many( @damage );
 
       Tickit::Debug->log( Wsr => "Term scrollrect %s by %+d,%+d",
          sub { Tickit::Rect->new( top => $top, left => $left, lines => $lines, cols => $cols )->sprintf }, $rightward, $downward ) if DEBUG;
@@ -1695,6 +1806,8 @@ sub _scrollrectset
       $done_pen or
          $term->setpen( bg => $pen->getattr( 'bg' ) ), $done_pen++;
 
+      $win->_invalidate_retained( $rect );
+
       if( not $term->scrollrect( $top, $left, $lines, $cols, $downward, $rightward ) ) {
          $ret = 0;
          if( $expose_after_scroll ) {
@@ -2025,6 +2138,8 @@ sub clear
       $term->setpen( $self->get_effective_pen );
       $term->clear;
 
+      $self->_invalidate_retained;
+
       $self->_needs_flush;
    }
 }
@@ -2093,6 +2208,12 @@ The button number for non-wheel mouse events, or the mouse wheel direction as
 a string (one fo C<up> or C<down>). Note that for C<release> type events, the
 mouse button may not be reliable; not all terminals can report it.
 
+=head2 $ev->count
+
+The number of steps for mouse wheel events. This is more than one if the
+terminal has coalesced several of them; see
+L<Tickit::Term/set_mouse_coalesce>.
+
 =head2 $ev->mod
 
 A bitmask of modifier state. Valid for both keyboard and mouse events.
@@ -2107,7 +2228,7 @@ sub new
    bless { @_ }, $class;
 }
 
-foreach my $key (qw( type str mod button line col )) {
+foreach my $key (qw( type str mod button line col count )) {
    no strict 'refs';
    *$key = sub { exists $_[0]{$key} ? $_[0]{$key} : croak "Event has no '$key' field" }
 }
@@ -2,66 +2,194 @@
 
 #include <stdlib.h>
 
+/* Each hook is linked into the list of all hooks, and into the bucket of each
+ * event bit it is bound to. A hook unbound while its handler is running stays
+ * linked, so the dispatch in progress can carry on past it, and is freed once
+ * the handler returns.
+ */
 struct TickitEventHook {
-  struct TickitEventHook *next;
+  struct TickitEventHook *all_prev, *all_next;
+  struct TickitEventHook *prev[TICKIT_HOOKLIST_BUCKETS];
+  struct TickitEventHook *next[TICKIT_HOOKLIST_BUCKETS];
+
   TickitEventType         ev;
   TickitEventFn          *fn;
   void                   *data;
   int                     id;
+
+  int                     running; /* how many of its handler calls are in progress */
+  unsigned int            dead : 1;
 };
 
-void tickit_hooklist_run_event(struct TickitEventHook *hooks, void *owner, TickitEventType ev, TickitEvent *args)
+#define BUCKET_EVENTS ((1 << TICKIT_HOOKLIST_BUCKETS) - 1)
+
+void tickit_hooklist_init(struct TickitHooklist *hooks)
 {
-  for(struct TickitEventHook *hook = hooks; hook; hook = hook->next)
-    if(hook->ev & ev)
-      (*hook->fn)(owner, ev, args, hook->data);
+  hooks->all = hooks->all_last = NULL;
+
+  for(int b = 0; b < TICKIT_HOOKLIST_BUCKETS; b++)
+    hooks->head[b] = hooks->tail[b] = NULL;
+
+  hooks->next_id = 1;
 }
 
-int tickit_hooklist_bind_event(struct TickitEventHook **hooklist, void *owner, TickitEventType ev, TickitEventFn *fn, void *data)
+static void unlink_hook(struct TickitHooklist *hooks, struct TickitEventHook *hook)
 {
-  int max_id = 0;
+  if(hook->all_prev)
+    hook->all_prev->all_next = hook->all_next;
+  else
+    hooks->all = hook->all_next;
+
+  if(hook->all_next)
+    hook->all_next->all_prev = hook->all_prev;
+  else
+    hooks->all_last = hook->all_prev;
 
-  /* Find the end of a linked list, and find the highest ID in use while we're
-   * at it
-   */
-  struct TickitEventHook **newhook = hooklist;
-  for(; *newhook; newhook = &(*newhook)->next)
-    if((*newhook)->id > max_id)
-      max_id = (*newhook)->id;
+  for(int b = 0; b < TICKIT_HOOKLIST_BUCKETS; b++) {
+    if(!(hook->ev & (1 << b)))
+      continue;
 
-  *newhook = malloc(sizeof(struct TickitEventHook)); // TODO: malloc failure
+    if(hook->prev[b])
+      hook->prev[b]->next[b] = hook->next[b];
+    else
+      hooks->head[b] = hook->next[b];
+
+    if(hook->next[b])
+      hook->next[b]->prev[b] = hook->prev[b];
+    else
+      hooks->tail[b] = hook->prev[b];
+  }
+}
 
-  (*newhook)->next = NULL;
-  (*newhook)->ev = ev;
-  (*newhook)->fn = fn;
-  (*newhook)->data = data;
+static void invoke(struct TickitEventHook *hook, void *owner, TickitEventType ev, TickitEvent *args)
+{
+  hook->running++;
+  (*hook->fn)(owner, ev, args, hook->data);
+  hook->running--;
+}
 
-  return (*newhook)->id = max_id + 1;
+/* Called after a hook's handler returns, with the next hook already found */
+static void reap(struct TickitHooklist *hooks, struct TickitEventHook *hook)
+{
+  if(hook->dead && !hook->running) {
+    unlink_hook(hooks, hook);
+    free(hook);
+  }
 }
 
-void tickit_hooklist_unbind_event_id(struct TickitEventHook **hooklist, void *owner, int id)
+void tickit_hooklist_run_event(struct TickitHooklist *hooks, void *owner, TickitEventType ev, TickitEvent *args)
 {
-  struct TickitEventHook **link = hooklist;
-  for(struct TickitEventHook *hook = *hooklist; hook;) {
-    if(hook->id == id) {
-      *link = hook->next;
-      if(hook->ev & TICKIT_EV_UNBIND)
-        (*hook->fn)(owner, TICKIT_EV_UNBIND, NULL, hook->data);
-      free(hook);
-      hook = *link;
+  /* Nearly always a single event bit, which needs only its own bucket */
+  if((ev & BUCKET_EVENTS) && !(ev & (ev - 1))) {
+    int b = 0;
+    while(!(ev & (1 << b)))
+      b++;
+
+    for(struct TickitEventHook *hook = hooks->head[b]; hook; ) {
+      if(hook->dead) {
+        hook = hook->next[b];
+        continue;
+      }
+
+      invoke(hook, owner, ev, args);
+
+      struct TickitEventHook *next = hook->next[b];
+      reap(hooks, hook);
+      hook = next;
+    }
+    return;
+  }
+
+  for(struct TickitEventHook *hook = hooks->all; hook; ) {
+    if(hook->dead || !(hook->ev & ev)) {
+      hook = hook->all_next;
+      continue;
     }
+
+    invoke(hook, owner, ev, args);
+
+    struct TickitEventHook *next = hook->all_next;
+    reap(hooks, hook);
+    hook = next;
+  }
+}
+
+int tickit_hooklist_has_event(const struct TickitHooklist *hooks, TickitEventType ev)
+{
+  for(int b = 0; b < TICKIT_HOOKLIST_BUCKETS; b++)
+    if((ev & (1 << b)) && hooks->head[b])
+      return 1;
+
+  if(ev & ~(BUCKET_EVENTS|TICKIT_EV_UNBIND))
+    for(struct TickitEventHook *hook = hooks->all; hook; hook = hook->all_next)
+      if(!hook->dead && (hook->ev & ev))
+        return 1;
+
+  return 0;
+}
+
+int tickit_hooklist_bind_event(struct TickitHooklist *hooks, void *owner, TickitEventType ev, TickitEventFn *fn, void *data)
+{
+  struct TickitEventHook *hook = malloc(sizeof(struct TickitEventHook)); // TODO: malloc failure
+
+  hook->ev = ev;
+  hook->fn = fn;
+  hook->data = data;
+  hook->id = hooks->next_id++;
+  hook->running = 0;
+  hook->dead = 0;
+
+  hook->all_prev = hooks->all_last;
+  hook->all_next = NULL;
+  if(hooks->all_last)
+    hooks->all_last->all_next = hook;
+  else
+    hooks->all = hook;
+  hooks->all_last = hook;
+
+  for(int b = 0; b < TICKIT_HOOKLIST_BUCKETS; b++) {
+    hook->prev[b] = hook->next[b] = NULL;
+    if(!(ev & (1 << b)))
+      continue;
+
+    hook->prev[b] = hooks->tail[b];
+    if(hooks->tail[b])
+      hooks->tail[b]->next[b] = hook;
     else
-      hook = hook->next;
+      hooks->head[b] = hook;
+    hooks->tail[b] = hook;
   }
+
+  return hook->id;
 }
 
-void tickit_hooklist_unbind_and_destroy(struct TickitEventHook *hooks, void *owner)
+void tickit_hooklist_unbind_event_id(struct TickitHooklist *hooks, void *owner, int id)
 {
-  for(struct TickitEventHook *hook = hooks; hook;) {
-    struct TickitEventHook *next = hook->next;
-    if(hook->ev & TICKIT_EV_UNBIND)
+  struct TickitEventHook *hook = hooks->all;
+  while(hook && (hook->id != id || hook->dead))
+    hook = hook->all_next;
+
+  if(!hook)
+    return;
+
+  hook->dead = 1;
+
+  if(hook->ev & TICKIT_EV_UNBIND)
+    (*hook->fn)(owner, TICKIT_EV_UNBIND, NULL, hook->data);
+
+  /* If its handler is running, the dispatch frees it once that returns */
+  reap(hooks, hook);
+}
+
+void tickit_hooklist_unbind_and_destroy(struct TickitHooklist *hooks, void *owner)
+{
+  for(struct TickitEventHook *hook = hooks->all; hook;) {
+    struct TickitEventHook *next = hook->all_next;
+    if((hook->ev & TICKIT_EV_UNBIND) && !hook->dead)
       (*hook->fn)(owner, TICKIT_EV_UNBIND, NULL, hook->data);
     free(hook);
     hook = next;
   }
+
+  tickit_hooklist_init(hooks);
 }
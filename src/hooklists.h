@@ -1,15 +1,30 @@
 #include "tickit.h"
 
+/* One bucket per event bit, up to but not including TICKIT_EV_UNBIND */
+#define TICKIT_HOOKLIST_BUCKETS 8
+
 struct TickitEventHook;
 
+struct TickitHooklist {
+  /* Every hook in bind order, and each bucket's hooks in bind order */
+  struct TickitEventHook *all, *all_last;
+  struct TickitEventHook *head[TICKIT_HOOKLIST_BUCKETS];
+  struct TickitEventHook *tail[TICKIT_HOOKLIST_BUCKETS];
+
+  int next_id;
+};
+
 typedef void TickitEventFn(void *owner, TickitEventType ev, TickitEvent *args, void *data);
 
-void tickit_hooklist_run_event(struct TickitEventHook *hooks, void *owner, TickitEventType ev, TickitEvent *args);
+void tickit_hooklist_init(struct TickitHooklist *hooks);
+
+void tickit_hooklist_run_event(struct TickitHooklist *hooks, void *owner, TickitEventType ev, TickitEvent *args);
+int  tickit_hooklist_has_event(const struct TickitHooklist *hooks, TickitEventType ev);
 
-int  tickit_hooklist_bind_event(struct TickitEventHook **hooklist, void *owner, TickitEventType ev, TickitEventFn *fn, void *data);
-void tickit_hooklist_unbind_event_id(struct TickitEventHook **hooklist, void *owner, int id);
+int  tickit_hooklist_bind_event(struct TickitHooklist *hooks, void *owner, TickitEventType ev, TickitEventFn *fn, void *data);
+void tickit_hooklist_unbind_event_id(struct TickitHooklist *hooks, void *owner, int id);
 
-void tickit_hooklist_unbind_and_destroy(struct TickitEventHook *hooks, void *owner);
+void tickit_hooklist_unbind_and_destroy(struct TickitHooklist *hooks, void *owner);
 
 #define DEFINE_HOOKLIST_FUNCS(NAME,OWNER,EVENTFN)                      \
   int tickit_##NAME##_bind_event(OWNER *owner, TickitEventType ev,     \
@@ -27,5 +42,5 @@ void tickit_hooklist_unbind_and_destroy(struct TickitEventHook *hooks, void *own
   static void run_events(OWNER *owner, TickitEventType ev,             \
       TickitEvent *args)                                               \
   {                                                                    \
-    tickit_hooklist_run_event(owner->hooks, owner, ev, args);          \
+    tickit_hooklist_run_event(&owner->hooks, owner, ev, args);         \
   }
@@ -0,0 +1,450 @@
+#include "tickit.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MSEC      1000
+#define SECOND 1000000
+
+struct Timer {
+  struct timeval     at;
+  uint64_t           seq; /* keeps timers due at the same time in order */
+  int                id;
+  TickitEventType    ev;
+  TickitLoopTimerFn *fn;
+  void              *data;
+};
+
+struct Watch {
+  int                id;
+  int                fd;
+  TickitIOCondition  cond;
+  TickitEventType    ev;
+  TickitLoopIOFn    *fn;
+  void              *data;
+};
+
+/* What each pollfd was for, so results can be dispatched even if the
+ * handlers change the watches
+ */
+struct PollOwner {
+  int         watch_id; /* 0 for a term */
+  TickitTerm *tt;
+};
+
+struct TickitLoop {
+  /* A binary min-heap ordered on (at, seq) */
+  struct Timer *timers;
+  size_t        n_timers;
+  size_t        size_timers;
+  uint64_t      next_seq;
+  int           next_timer_id;
+
+  struct Watch *watches;
+  size_t        n_watches;
+  size_t        size_watches;
+  int           next_watch_id;
+
+  TickitTerm  **terms;
+  size_t        n_terms;
+  size_t        size_terms;
+
+  struct pollfd    *pollfds;
+  struct PollOwner *pollowners;
+  size_t            size_pollfds;
+};
+
+TickitLoop *tickit_loop_new(void)
+{
+  TickitLoop *loop = malloc(sizeof(TickitLoop));
+  if(!loop)
+    return NULL;
+
+  loop->timers = NULL;
+  loop->n_timers = 0;
+  loop->size_timers = 0;
+  loop->next_seq = 0;
+  loop->next_timer_id = 1;
+
+  loop->watches = NULL;
+  loop->n_watches = 0;
+  loop->size_watches = 0;
+  loop->next_watch_id = 1;
+
+  loop->terms = NULL;
+  loop->n_terms = 0;
+  loop->size_terms = 0;
+
+  loop->pollfds = NULL;
+  loop->pollowners = NULL;
+  loop->size_pollfds = 0;
+
+  return loop;
+}
+
+void tickit_loop_destroy(TickitLoop *loop)
+{
+  for(size_t i = 0; i < loop->n_timers; i++)
+    if(loop->timers[i].ev & TICKIT_EV_UNBIND)
+      (*loop->timers[i].fn)(loop, TICKIT_EV_UNBIND, loop->timers[i].data);
+
+  for(size_t i = 0; i < loop->n_watches; i++)
+    if(loop->watches[i].ev & TICKIT_EV_UNBIND)
+      (*loop->watches[i].fn)(loop, TICKIT_EV_UNBIND, loop->watches[i].fd, 0, loop->watches[i].data);
+
+  free(loop->timers);
+  free(loop->watches);
+  free(loop->terms);
+  free(loop->pollfds);
+  free(loop->pollowners);
+  free(loop);
+}
+
+static int grow(void **array, size_t *size, size_t want, size_t elemsize)
+{
+  if(want <= *size)
+    return 1;
+
+  size_t newsize = *size ? *size : 4;
+  while(newsize < want)
+    newsize *= 2;
+
+  void *newarray = realloc(*array, newsize * elemsize);
+  if(!newarray)
+    return 0;
+
+  *array = newarray;
+  *size = newsize;
+  return 1;
+}
+
+/*
+ * Timers
+ */
+
+static int timer_before(const struct Timer *a, const struct Timer *b)
+{
+  if(a->at.tv_sec != b->at.tv_sec)
+    return a->at.tv_sec < b->at.tv_sec;
+  if(a->at.tv_usec != b->at.tv_usec)
+    return a->at.tv_usec < b->at.tv_usec;
+  return a->seq < b->seq;
+}
+
+static void sift_up(struct Timer *heap, size_t i)
+{
+  struct Timer t = heap[i];
+  while(i > 0) {
+    size_t parent = (i - 1) / 2;
+    if(!timer_before(&t, heap + parent))
+      break;
+    heap[i] = heap[parent];
+    i = parent;
+  }
+  heap[i] = t;
+}
+
+static void sift_down(struct Timer *heap, size_t n, size_t i)
+{
+  struct Timer t = heap[i];
+  for(;;) {
+    size_t child = 2 * i + 1;
+    if(child >= n)
+      break;
+    if(child + 1 < n && timer_before(heap + child + 1, heap + child))
+      child++;
+    if(!timer_before(heap + child, &t))
+      break;
+    heap[i] = heap[child];
+    i = child;
+  }
+  heap[i] = t;
+}
+
+static void remove_timer_at(TickitLoop *loop, size_t i)
+{
+  loop->n_timers--;
+  if(i == loop->n_timers)
+    return;
+
+  loop->timers[i] = loop->timers[loop->n_timers];
+  if(i > 0 && timer_before(loop->timers + i, loop->timers + (i - 1) / 2))
+    sift_up(loop->timers, i);
+  else
+    sift_down(loop->timers, loop->n_timers, i);
+}
+
+int tickit_loop_timer_at(TickitLoop *loop, const struct timeval *at, TickitEventType ev, TickitLoopTimerFn *fn, void *data)
+{
+  if(!grow((void **)&loop->timers, &loop->size_timers, loop->n_timers + 1, sizeof(loop->timers[0])))
+    return -1;
+
+  struct Timer *t = loop->timers + loop->n_timers;
+  t->at   = *at;
+  t->seq  = loop->next_seq++;
+  t->id   = loop->next_timer_id++;
+  t->ev   = ev;
+  t->fn   = fn;
+  t->data = data;
+
+  int id = t->id;
+  sift_up(loop->timers, loop->n_timers++);
+
+  return id;
+}
+
+int tickit_loop_timer_after(TickitLoop *loop, int msec, TickitEventType ev, TickitLoopTimerFn *fn, void *data)
+{
+  struct timeval at;
+  gettimeofday(&at, NULL);
+
+  if(msec < 0)
+    msec = 0;
+
+  /* at += msec */
+  long usec = at.tv_usec + (long)(msec % 1000) * MSEC;
+  at.tv_sec += msec / 1000 + usec / SECOND;
+  at.tv_usec = usec % SECOND;
+
+  return tickit_loop_timer_at(loop, &at, ev, fn, data);
+}
+
+void tickit_loop_cancel_timer(TickitLoop *loop, int id)
+{
+  for(size_t i = 0; i < loop->n_timers; i++)
+    if(loop->timers[i].id == id) {
+      struct Timer t = loop->timers[i];
+      remove_timer_at(loop, i);
+
+      if(t.ev & TICKIT_EV_UNBIND)
+        (*t.fn)(loop, TICKIT_EV_UNBIND, t.data);
+      return;
+    }
+}
+
+size_t tickit_loop_timers(const TickitLoop *loop)
+{
+  return loop->n_timers;
+}
+
+int tickit_loop_next_timer(const TickitLoop *loop, struct timeval *at)
+{
+  if(!loop->n_timers)
+    return 0;
+
+  *at = loop->timers[0].at;
+  return 1;
+}
+
+/*
+ * IO watches
+ */
+
+int tickit_loop_watch_io(TickitLoop *loop, int fd, TickitIOCondition cond, TickitEventType ev, TickitLoopIOFn *fn, void *data)
+{
+  if(!grow((void **)&loop->watches, &loop->size_watches, loop->n_watches + 1, sizeof(loop->watches[0])))
+    return -1;
+
+  struct Watch *w = loop->watches + loop->n_watches++;
+  w->id   = loop->next_watch_id++;
+  w->fd   = fd;
+  w->cond = cond;
+  w->ev   = ev;
+  w->fn   = fn;
+  w->data = data;
+
+  return w->id;
+}
+
+void tickit_loop_unwatch_io(TickitLoop *loop, int id)
+{
+  for(size_t i = 0; i < loop->n_watches; i++)
+    if(loop->watches[i].id == id) {
+      struct Watch w = loop->watches[i];
+      memmove(loop->watches + i, loop->watches + i + 1, (loop->n_watches - i - 1) * sizeof(loop->watches[0]));
+      loop->n_watches--;
+
+      if(w.ev & TICKIT_EV_UNBIND)
+        (*w.fn)(loop, TICKIT_EV_UNBIND, w.fd, 0, w.data);
+      return;
+    }
+}
+
+static struct Watch *find_watch(TickitLoop *loop, int id)
+{
+  for(size_t i = 0; i < loop->n_watches; i++)
+    if(loop->watches[i].id == id)
+      return loop->watches + i;
+
+  return NULL;
+}
+
+/*
+ * Terms
+ */
+
+void tickit_loop_add_term(TickitLoop *loop, TickitTerm *tt)
+{
+  for(size_t i = 0; i < loop->n_terms; i++)
+    if(loop->terms[i] == tt)
+      return;
+
+  if(!grow((void **)&loop->terms, &loop->size_terms, loop->n_terms + 1, sizeof(loop->terms[0])))
+    return;
+
+  loop->terms[loop->n_terms++] = tt;
+}
+
+void tickit_loop_remove_term(TickitLoop *loop, TickitTerm *tt)
+{
+  for(size_t i = 0; i < loop->n_terms; i++)
+    if(loop->terms[i] == tt) {
+      memmove(loop->terms + i, loop->terms + i + 1, (loop->n_terms - i - 1) * sizeof(loop->terms[0]));
+      loop->n_terms--;
+      return;
+    }
+}
+
+static int has_term(TickitLoop *loop, TickitTerm *tt)
+{
+  for(size_t i = 0; i < loop->n_terms; i++)
+    if(loop->terms[i] == tt)
+      return 1;
+
+  return 0;
+}
+
+/*
+ * Running
+ */
+
+/* msec until at, rounded up so waking never comes early; never negative */
+static int msec_until(const struct timeval *at, const struct timeval *now)
+{
+  long long usec = (long long)(at->tv_sec - now->tv_sec) * SECOND + (at->tv_usec - now->tv_usec);
+  if(usec <= 0)
+    return 0;
+
+  long long msec = (usec + MSEC - 1) / MSEC;
+  return msec > INT32_MAX ? INT32_MAX : (int)msec;
+}
+
+static int add_pollfd(TickitLoop *loop, size_t *n, int fd, short events, int watch_id, TickitTerm *tt)
+{
+  size_t fdsize = loop->size_pollfds, ownersize = loop->size_pollfds;
+  if(!grow((void **)&loop->pollfds, &fdsize, *n + 1, sizeof(loop->pollfds[0])) ||
+     !grow((void **)&loop->pollowners, &ownersize, *n + 1, sizeof(loop->pollowners[0])))
+    return 0;
+  loop->size_pollfds = fdsize;
+
+  loop->pollfds[*n].fd      = fd;
+  loop->pollfds[*n].events  = events;
+  loop->pollfds[*n].revents = 0;
+  loop->pollowners[*n].watch_id = watch_id;
+  loop->pollowners[*n].tt       = tt;
+  (*n)++;
+  return 1;
+}
+
+void tickit_loop_run_once(TickitLoop *loop, int msec)
+{
+  struct timeval now;
+  gettimeofday(&now, NULL);
+
+  if(loop->n_timers) {
+    int until = msec_until(&loop->timers[0].at, &now);
+    if(msec == -1 || until < msec)
+      msec = until;
+  }
+
+  /* Partial key sequences are given up on after the termkey wait time */
+  for(size_t i = 0; i < loop->n_terms; i++) {
+    int until = tickit_term_input_check_timeout(loop->terms[i]);
+    if(until != -1 && (msec == -1 || until < msec))
+      msec = until;
+  }
+
+  size_t n = 0;
+
+  for(size_t i = 0; i < loop->n_watches; i++) {
+    struct Watch *w = loop->watches + i;
+    short events = ((w->cond & TICKIT_IO_IN)  ? POLLIN  : 0) |
+                   ((w->cond & TICKIT_IO_OUT) ? POLLOUT : 0);
+    if(!add_pollfd(loop, &n, w->fd, events, w->id, NULL))
+      return;
+  }
+
+  for(size_t i = 0; i < loop->n_terms; i++) {
+    TickitTerm *tt = loop->terms[i];
+
+    int infd = tickit_term_get_input_fd(tt);
+    if(infd != -1 && !add_pollfd(loop, &n, infd, POLLIN, 0, tt))
+      return;
+
+    /* While there's output the fd would not take, also wait until it will */
+    int outfd = tickit_term_get_output_fd(tt);
+    if(outfd != -1 && tickit_term_output_pending(tt) &&
+       !add_pollfd(loop, &n, outfd, POLLOUT, 0, tt))
+      return;
+  }
+
+  int ret = poll(loop->pollfds, n, msec);
+  if(ret < 0 && errno == EINTR)
+    /* Let the caller handle the signal before anything else */
+    return;
+
+  for(size_t i = 0; ret > 0 && i < n; i++) {
+    short revents = loop->pollfds[i].revents;
+    if(!revents)
+      continue;
+
+    int watch_id   = loop->pollowners[i].watch_id;
+    TickitTerm *tt = loop->pollowners[i].tt;
+
+    if(watch_id) {
+      struct Watch *w = find_watch(loop, watch_id);
+      if(!w)
+        continue;
+
+      TickitIOCondition cond = 0;
+      if(revents & (POLLIN|POLLHUP|POLLERR))
+        cond |= TICKIT_IO_IN;
+      if(revents & (POLLOUT|POLLERR))
+        cond |= TICKIT_IO_OUT;
+      if(revents & POLLHUP)
+        cond |= TICKIT_IO_HUP;
+
+      cond &= w->cond | TICKIT_IO_HUP;
+      if(cond)
+        (*w->fn)(loop, TICKIT_EV_IO, w->fd, cond, w->data);
+    }
+    else if(has_term(loop, tt)) {
+      if(loop->pollfds[i].events & POLLOUT)
+        tickit_term_output_writable(tt);
+      else
+        tickit_term_input_readable(tt);
+    }
+  }
+
+  for(size_t i = 0; i < loop->n_terms; i++)
+    tickit_term_input_check_timeout(loop->terms[i]);
+
+  /* Only those already queued; any a handler adds wait for the next round */
+  uint64_t seq_limit = loop->next_seq;
+
+  gettimeofday(&now, NULL);
+  while(loop->n_timers) {
+    struct Timer t = loop->timers[0];
+    if(t.seq >= seq_limit || msec_until(&t.at, &now) > 0)
+      break;
+
+    remove_timer_at(loop, 0);
+
+    /* The timer is already gone, so it won't fire again if this never
+     * returns */
+    (*t.fn)(loop, TICKIT_EV_TIMER | (t.ev & TICKIT_EV_UNBIND), t.data);
+  }
+}
@@ -12,10 +12,19 @@
   if(var < (min)) var = (min); \
   if(var > (max)) var = (max)
 
+/* Cells live in one flat lines*cols array, so scrolling and resizing move
+ * whole rows at a time. Text short enough to fit is kept inside the cell
+ * itself; only unusually long grapheme clusters need a separate allocation.
+ * Pens are interned, so a cell only holds the index of its pen.
+ */
+#define CELL_INLINE_BYTES 12
+
 typedef struct
 {
-  char      *str;
-  TickitPen *pen;
+  char   small[CELL_INLINE_BYTES];
+  char  *big;  // text if it would not fit in small, else NULL
+  size_t len;  // bytes of text; 0 for the right-hand half of a wide character
+  int    pen;  // index into the interned pens
 } MockTermCell;
 
 typedef struct
@@ -24,87 +33,100 @@ typedef struct
 
   int lines;
   int cols;
-  MockTermCell ***cells;
+  MockTermCell *cells;
+
+  TickitPen **pens;
+  int         npens;
+  int         pensize;
 
   TickitMockTermLogEntry *log;
   size_t            logsize;
-  size_t            logi;
+  size_t            logstart; // oldest entry, once a limited log has wrapped
+  size_t            logi;     // number of entries held
+  int               loglimit; // -1 for unlimited, 0 to disable the log
 
   TickitPen *pen;
+  int penidx;
   int line;
   int col;
   int cursorvis;
   int cursorshape;
+  int sync_output;
 } MockTermDriver;
 
-static void mtd_free_cell(MockTermDriver *mtd, int line, int col)
+static inline MockTermCell *mtd_cell(MockTermDriver *mtd, int line, int col)
 {
-  MockTermCell *cell = mtd->cells[line][col];
-
-  if(cell->str)
-    free(cell->str);
-  if(cell->pen)
-    tickit_pen_destroy(cell->pen);
-
-  free(cell);
+  return mtd->cells + (size_t)line * mtd->cols + col;
 }
 
-static void mtd_free_line(MockTermDriver *mtd, int line)
+static inline const char *mtd_cell_text(const MockTermCell *cell)
 {
-  for(int col = 0; col < mtd->cols; col++)
-    mtd_free_cell(mtd, line, col);
-
-  free(mtd->cells[line]);
+  return cell->big ? cell->big : cell->small;
 }
 
-static void mtd_clear_cells(MockTermDriver *mtd, int line, int startcol, int stopcol)
+static int mtd_intern_pen(MockTermDriver *mtd, const TickitPen *pen)
 {
-  /* This code is also used to initialise brand new cells in the structure, so
-   * it should be careful to vivify them correctly
+  /* Applications use only a handful of distinct pens, so a linear search
+   * beats the bookkeeping of anything cleverer
    */
+  for(int i = 0; i < mtd->npens; i++)
+    if(tickit_pen_equiv(mtd->pens[i], pen))
+      return i;
 
-  MockTermCell **linecells = mtd->cells[line];
-  if(!linecells) {
-    linecells = malloc(mtd->cols * sizeof(MockTermCell *));
-    mtd->cells[line] = linecells;
-
-    for(int col = 0; col < mtd->cols; col++)
-      linecells[col] = NULL;
+  if(mtd->npens == mtd->pensize) {
+    mtd->pensize *= 2;
+    mtd->pens = realloc(mtd->pens, mtd->pensize * sizeof(TickitPen *));
   }
 
-  for(int col = startcol; col < stopcol; col++) {
-    MockTermCell *cell = linecells[col];
-
-    if(!cell) {
-      cell = malloc(sizeof(MockTermCell));
-      linecells[col] = cell;
+  mtd->pens[mtd->npens] = tickit_pen_clone(pen);
+  return mtd->npens++;
+}
 
-      cell->str = NULL;
-      cell->pen = NULL;
-    }
+static void mtd_set_cell(MockTermCell *cell, const char *str, size_t len, int pen)
+{
+  if(cell->big)
+    free(cell->big);
+  cell->big = NULL;
+
+  if(len < CELL_INLINE_BYTES) {
+    if(len)
+      memcpy(cell->small, str, len);
+    cell->small[len] = 0;
+  }
+  else
+    cell->big = strndup(str, len);
 
-    if(cell->str)
-      free(cell->str);
-    if(cell->pen)
-      tickit_pen_destroy(cell->pen);
+  cell->len = len;
+  cell->pen = pen;
+}
 
-    cell->str = strdup(" ");
-    cell->pen = tickit_pen_clone(mtd->pen);
+/* Initialises cells as blank, without looking at what they held before */
+static void mtd_init_cells(MockTermDriver *mtd, MockTermCell *cell, int count)
+{
+  for(; count > 0; cell++, count--) {
+    cell->small[0] = ' ';
+    cell->small[1] = 0;
+    cell->big = NULL;
+    cell->len = 1;
+    cell->pen = mtd->penidx;
   }
 }
 
-static TickitMockTermLogEntry *mtd_nextlog(MockTermDriver *mtd)
+static void mtd_free_cells(MockTermCell *cell, int count)
 {
-  if(mtd->logi == mtd->logsize) {
-    mtd->logsize *= 2;
-    mtd->log = realloc(mtd->log, mtd->logsize * sizeof(TickitMockTermLogEntry));
-  }
+  for(; count > 0; cell++, count--)
+    if(cell->big)
+      free(cell->big);
+}
 
-  TickitMockTermLogEntry *entry = mtd->log + mtd->logi++;
+static void mtd_clear_cells(MockTermDriver *mtd, int line, int startcol, int stopcol)
+{
+  if(stopcol <= startcol)
+    return;
 
-  entry->str = NULL;
-  entry->pen = NULL;
-  return entry;
+  MockTermCell *cell = mtd_cell(mtd, line, startcol);
+  mtd_free_cells(cell, stopcol - startcol);
+  mtd_init_cells(mtd, cell, stopcol - startcol);
 }
 
 static void mtd_free_logentry(TickitMockTermLogEntry *entry)
@@ -118,18 +140,49 @@ static void mtd_free_logentry(TickitMockTermLogEntry *entry)
   entry->pen = NULL;
 }
 
+/* Returns NULL if the log is disabled */
+static TickitMockTermLogEntry *mtd_nextlog(MockTermDriver *mtd)
+{
+  if(!mtd->loglimit)
+    return NULL;
+
+  TickitMockTermLogEntry *entry;
+
+  if(mtd->loglimit > 0 && mtd->logi == mtd->loglimit) {
+    // A full ring; the newest entry replaces the oldest
+    entry = mtd->log + mtd->logstart;
+    mtd_free_logentry(entry);
+    mtd->logstart = (mtd->logstart + 1) % mtd->logsize;
+  }
+  else {
+    if(mtd->logi == mtd->logsize) {
+      mtd->logsize *= 2;
+      mtd->log = realloc(mtd->log, mtd->logsize * sizeof(TickitMockTermLogEntry));
+    }
+
+    entry = mtd->log + (mtd->logstart + mtd->logi++) % mtd->logsize;
+  }
+
+  entry->str = NULL;
+  entry->pen = NULL;
+  return entry;
+}
+
 static void mtd_destroy(TickitTermDriver *ttd)
 {
   MockTermDriver *mtd = (MockTermDriver *)ttd;
 
-  for(int i = 0; i < mtd->logi; i++)
-    mtd_free_logentry(mtd->log + i);
+  for(size_t i = 0; i < mtd->logi; i++)
+    mtd_free_logentry(mtd->log + (mtd->logstart + i) % mtd->logsize);
   free(mtd->log);
 
-  for(int line = 0; line < mtd->lines; line++)
-    mtd_free_line(mtd, line);
+  mtd_free_cells(mtd->cells, mtd->lines * mtd->cols);
   free(mtd->cells);
 
+  for(int i = 0; i < mtd->npens; i++)
+    tickit_pen_destroy(mtd->pens[i]);
+  free(mtd->pens);
+
   tickit_pen_destroy(mtd->pen);
 
   free(mtd);
@@ -140,16 +193,16 @@ static void mtd_print(TickitTermDriver *ttd, const char *str, size_t len)
   MockTermDriver *mtd = (MockTermDriver *)ttd;
 
   TickitMockTermLogEntry *entry = mtd_nextlog(mtd);
-  entry->type = LOG_PRINT;
-  entry->str  = strndup(str, len);
-  entry->val1 = len;
+  if(entry) {
+    entry->type = LOG_PRINT;
+    entry->str  = strndup(str, len);
+    entry->val1 = len;
+  }
 
   TickitStringPos pos;
   tickit_stringpos_zero(&pos);
   pos.columns = mtd->col;
 
-  MockTermCell **linecells = mtd->cells[mtd->line];
-
   TickitStringPos limit;
   tickit_stringpos_limit_columns(&limit, pos.columns);
   limit.bytes = len;
@@ -166,34 +219,16 @@ static void mtd_print(TickitTermDriver *ttd, const char *str, size_t len)
     // Wrap but don't scroll - for now. This shouldn't cause scrolling anyway
     if(start.columns >= mtd->cols) {
       start.columns = 0;
-      if(mtd->line < mtd->lines-1) {
+      if(mtd->line < mtd->lines-1)
         mtd->line++;
-        linecells = mtd->cells[mtd->line];
-      }
     }
 
-    MockTermCell *cell = linecells[start.columns];
-
-    if(cell->str)
-      free(cell->str);
-    if(cell->pen)
-      tickit_pen_destroy(cell->pen);
-
-    cell->str = strndup(str + start.bytes, pos.bytes - start.bytes);
-    cell->pen = tickit_pen_clone(mtd->pen);
+    MockTermCell *cell = mtd_cell(mtd, mtd->line, start.columns);
+    mtd_set_cell(cell, str + start.bytes, pos.bytes - start.bytes, mtd->penidx);
 
     // Empty out the other cells for doublewidth
-    for(start.columns++; start.columns < pos.columns; start.columns++) {
-      cell = linecells[start.columns];
-
-      if(cell->str)
-        free(cell->str);
-      if(cell->pen)
-        tickit_pen_destroy(cell->pen);
-
-      cell->str = NULL; /* empty */
-      cell->pen = tickit_pen_clone(mtd->pen);
-    }
+    for(start.columns++; start.columns < pos.columns && start.columns < mtd->cols; start.columns++)
+      mtd_set_cell(++cell, NULL, 0, mtd->penidx);
   }
 
   mtd->col = pos.columns;
@@ -207,9 +242,11 @@ static int mtd_goto_abs(TickitTermDriver *ttd, int line, int col)
   BOUND(col,  0, mtd->cols-1);
 
   TickitMockTermLogEntry *entry = mtd_nextlog(mtd);
-  entry->type = LOG_GOTO;
-  entry->val1 = line;
-  entry->val2 = col;
+  if(entry) {
+    entry->type = LOG_GOTO;
+    entry->val1 = line;
+    entry->val2 = col;
+  }
 
   mtd->line = line;
   mtd->col  = col;
@@ -245,41 +282,30 @@ static int mtd_scrollrect(TickitTermDriver *ttd, const TickitRect *rect, int dow
     return 0;
 
   if(left == 0 && right == mtd->cols && rightward == 0) {
-    MockTermCell ***cells = mtd->cells;
-
     TickitMockTermLogEntry *entry = mtd_nextlog(mtd);
-    entry->type = LOG_SCROLLRECT;
-    entry->val1 = downward;
-    entry->val2 = rightward;
-    entry->rect = *rect;
-
-    if(downward > 0) {
-      int line;
-      for(line = top; line < top + downward; line++)
-        mtd_free_line(mtd, line);
+    if(entry) {
+      entry->type = LOG_SCROLLRECT;
+      entry->val1 = downward;
+      entry->val2 = rightward;
+      entry->rect = *rect;
+    }
 
-      for(line = top; line < bottom - downward; line++)
-        cells[line] = cells[line + downward];
+    int cols = mtd->cols;
+    int moved = bottom - top - abs(downward);
 
-      for(/* line */; line < bottom; line++) {
-        cells[line] = NULL;
-        mtd_clear_cells(mtd, line, 0, mtd->cols);
-      }
+    if(downward > 0) {
+      mtd_free_cells(mtd_cell(mtd, top, 0), downward * cols);
+      memmove(mtd_cell(mtd, top, 0), mtd_cell(mtd, top + downward, 0),
+          (size_t)moved * cols * sizeof(MockTermCell));
+      mtd_init_cells(mtd, mtd_cell(mtd, bottom - downward, 0), downward * cols);
     }
     else {
       int upward = -downward;
 
-      int line;
-      for(line = bottom-1; line >= bottom - upward; line--)
-        mtd_free_line(mtd, line);
-
-      for(line = bottom-1; line >= top + upward; line--)
-        cells[line] = cells[line - upward];
-
-      for(/* line */;    line >= top; line--) {
-        cells[line] = NULL;
-        mtd_clear_cells(mtd, line, 0, mtd->cols);
-      }
+      mtd_free_cells(mtd_cell(mtd, bottom - upward, 0), upward * cols);
+      memmove(mtd_cell(mtd, top + upward, 0), mtd_cell(mtd, top, 0),
+          (size_t)moved * cols * sizeof(MockTermCell));
+      mtd_init_cells(mtd, mtd_cell(mtd, top, 0), upward * cols);
     }
 
     return 1;
@@ -287,39 +313,29 @@ static int mtd_scrollrect(TickitTermDriver *ttd, const TickitRect *rect, int dow
 
   if(right == mtd->cols && downward == 0) {
     TickitMockTermLogEntry *entry = mtd_nextlog(mtd);
-    entry->type = LOG_SCROLLRECT;
-    entry->val1 = downward;
-    entry->val2 = rightward;
-    entry->rect = *rect;
+    if(entry) {
+      entry->type = LOG_SCROLLRECT;
+      entry->val1 = downward;
+      entry->val2 = rightward;
+      entry->rect = *rect;
+    }
 
-    for(int line = top; line < bottom; line++) {
-      MockTermCell **linecells = mtd->cells[line];
+    int moved = right - left - abs(rightward);
 
+    for(int line = top; line < bottom; line++) {
       if(rightward > 0) {
-        int col;
-        for(col = left; col < left + rightward; col++)
-          mtd_free_cell(mtd, line, col);
-
-        for(col = left; col < right - rightward; col++)
-          linecells[col] = linecells[col + rightward];
-
-        for(/* col */; col < right; col++)
-          linecells[col] = NULL;
-        mtd_clear_cells(mtd, line, right - rightward, right);
+        mtd_free_cells(mtd_cell(mtd, line, left), rightward);
+        memmove(mtd_cell(mtd, line, left), mtd_cell(mtd, line, left + rightward),
+            moved * sizeof(MockTermCell));
+        mtd_init_cells(mtd, mtd_cell(mtd, line, right - rightward), rightward);
       }
       else {
         int leftward = -rightward;
 
-        int col;
-        for(col = right-1; col >= right - leftward; col--)
-          mtd_free_cell(mtd, line, col);
-
-        for(col = right-1; col >= left + leftward; col--)
-          linecells[col] = linecells[col - leftward];
-
-        for(/* col */;    col >= left; col--)
-          linecells[col] = NULL;
-        mtd_clear_cells(mtd, line, left, left + leftward);
+        mtd_free_cells(mtd_cell(mtd, line, right - leftward), leftward);
+        memmove(mtd_cell(mtd, line, left + leftward), mtd_cell(mtd, line, left),
+            moved * sizeof(MockTermCell));
+        mtd_init_cells(mtd, mtd_cell(mtd, line, left), leftward);
       }
     }
 
@@ -334,9 +350,11 @@ static void mtd_erasech(TickitTermDriver *ttd, int count, int moveend)
   MockTermDriver *mtd = (MockTermDriver *)ttd;
 
   TickitMockTermLogEntry *entry = mtd_nextlog(mtd);
-  entry->type = LOG_ERASECH;
-  entry->val1 = count;
-  entry->val2 = moveend;
+  if(entry) {
+    entry->type = LOG_ERASECH;
+    entry->val1 = count;
+    entry->val2 = moveend;
+  }
 
   int right = mtd->col + count;
   BOUND(right, 0, mtd->cols);
@@ -352,10 +370,11 @@ static void mtd_clear(TickitTermDriver *ttd)
   MockTermDriver *mtd = (MockTermDriver *)ttd;
 
   TickitMockTermLogEntry *entry = mtd_nextlog(mtd);
-  entry->type = LOG_CLEAR;
+  if(entry)
+    entry->type = LOG_CLEAR;
 
-  for(int line = 0; line < mtd->lines; line++)
-    mtd_clear_cells(mtd, line, 0, mtd->cols);
+  mtd_free_cells(mtd->cells, mtd->lines * mtd->cols);
+  mtd_init_cells(mtd, mtd->cells, mtd->lines * mtd->cols);
 }
 
 static void mtd_chpen(TickitTermDriver *ttd, const TickitPen *delta, const TickitPen *final)
@@ -363,11 +382,15 @@ static void mtd_chpen(TickitTermDriver *ttd, const TickitPen *delta, const Ticki
   MockTermDriver *mtd = (MockTermDriver *)ttd;
 
   TickitMockTermLogEntry *entry = mtd_nextlog(mtd);
-  entry->type = LOG_SETPEN;
-  entry->pen  = tickit_pen_clone(final);
+  if(entry) {
+    entry->type = LOG_SETPEN;
+    entry->pen  = tickit_pen_clone(final);
+  }
 
   tickit_pen_clear(mtd->pen);
   tickit_pen_copy(mtd->pen, final, 1);
+
+  mtd->penidx = mtd_intern_pen(mtd, mtd->pen);
 }
 
 static int mtd_getctl_int(TickitTermDriver *ttd, TickitTermCtl ctl, int *value)
@@ -379,6 +402,8 @@ static int mtd_getctl_int(TickitTermDriver *ttd, TickitTermCtl ctl, int *value)
       *value = mtd->cursorvis; return 1;
     case TICKIT_TERMCTL_CURSORSHAPE:
       *value = mtd->cursorshape; return 1;
+    case TICKIT_TERMCTL_SYNC_OUTPUT:
+      *value = mtd->sync_output; return 1;
     case TICKIT_TERMCTL_COLORS:
       *value = 256;
       return 1;
@@ -396,6 +421,8 @@ static int mtd_setctl_int(TickitTermDriver *ttd, TickitTermCtl ctl, int value)
       mtd->cursorvis = !!value; break;
     case TICKIT_TERMCTL_CURSORSHAPE:
       mtd->cursorshape = value; break;
+    case TICKIT_TERMCTL_SYNC_OUTPUT:
+      mtd->sync_output = !!value; break;
     case TICKIT_TERMCTL_ALTSCREEN:
     case TICKIT_TERMCTL_MOUSE:
       break;
@@ -426,22 +453,27 @@ TickitMockTerm *tickit_mockterm_new(int lines, int cols)
 
   mtd->logsize = 16; // should be sufficient; or it will grow
   mtd->log = malloc(mtd->logsize * sizeof(TickitMockTermLogEntry));
+  mtd->logstart = 0;
   mtd->logi = 0;
+  mtd->loglimit = -1;
 
   mtd->pen       = tickit_pen_new();
 
+  mtd->pensize = 16;
+  mtd->pens    = malloc(mtd->pensize * sizeof(TickitPen *));
+  mtd->npens   = 0;
+  mtd->penidx  = mtd_intern_pen(mtd, mtd->pen);
+
   mtd->lines       = lines;
   mtd->cols        = cols;
   mtd->line        = -1;
   mtd->col         = -1;
   mtd->cursorvis   = 0;
   mtd->cursorshape = 0;
+  mtd->sync_output = 0;
 
-  mtd->cells = malloc(lines * sizeof(MockTermCell **));
-  for(int line = 0; line < lines; line++) {
-    mtd->cells[line] = NULL;
-    mtd_clear_cells(mtd, line, 0, cols);
-  }
+  mtd->cells = malloc((size_t)lines * cols * sizeof(MockTermCell));
+  mtd_init_cells(mtd, mtd->cells, lines * cols);
 
   TickitMockTerm *mt = (TickitMockTerm *)tickit_term_new_for_driver(&mtd->super);
   if(!mt) {
@@ -463,15 +495,14 @@ size_t tickit_mockterm_get_display_text(TickitMockTerm *mt, char *buffer, size_t
 {
   MockTermDriver *mtd = (MockTermDriver *)tickit_term_get_driver((TickitTerm *)mt);
 
-  MockTermCell **linecells = mtd->cells[line];
+  const MockTermCell *cell = mtd_cell(mtd, line, col);
 
   size_t ret = 0;
-  for(/* col */; width; col++, width--) {
-    MockTermCell *cell = linecells[col];
-    size_t celllen = cell->str ? strlen(cell->str) : 0;
+  for(/* col */; width; cell++, width--) {
+    size_t celllen = cell->len;
 
     if(buffer && celllen && len >= celllen) {
-      strcpy(buffer, cell->str);
+      memcpy(buffer, mtd_cell_text(cell), celllen);
       buffer += celllen;
       len    -= celllen;
       if(len <= 0)
@@ -488,46 +519,58 @@ TickitPen *tickit_mockterm_get_display_pen(TickitMockTerm *mt, int line, int col
 {
   MockTermDriver *mtd = (MockTermDriver *)tickit_term_get_driver((TickitTerm *)mt);
 
-  return mtd->cells[line][col]->pen;
+  return mtd->pens[mtd_cell(mtd, line, col)->pen];
 }
 
-void tickit_mockterm_resize(TickitMockTerm *mt, int newlines, int newcols)
+int tickit_mockterm_get_display_pens(TickitMockTerm *mt, int line, int col, int width, int penidx[])
 {
   MockTermDriver *mtd = (MockTermDriver *)tickit_term_get_driver((TickitTerm *)mt);
 
-  MockTermCell ***newcells = malloc(newlines * sizeof(MockTermCell **));
+  const MockTermCell *cell = mtd_cell(mtd, line, col);
+  for(int i = 0; i < width; i++)
+    penidx[i] = cell[i].pen;
 
-  int oldlines = mtd->lines;
-  int oldcols =  mtd->cols;
+  return mtd->npens;
+}
 
-  int line;
-  for(line = newlines; line < oldlines; line++)
-    mtd_free_line(mtd, line);
+TickitPen *tickit_mockterm_get_pen(TickitMockTerm *mt, int penidx)
+{
+  MockTermDriver *mtd = (MockTermDriver *)tickit_term_get_driver((TickitTerm *)mt);
 
-  for(line = 0; line < newlines && line < oldlines; line++) {
-    MockTermCell **newlinecells;
+  if(penidx >= 0 && penidx < mtd->npens)
+    return mtd->pens[penidx];
 
-    if(newcols == oldcols)
-      newlinecells = mtd->cells[line];
-    else {
-      newlinecells = malloc(newcols * sizeof(MockTermCell *));
+  return NULL;
+}
 
-      int col;
-      for(col = newcols; col < oldcols; col++)
-        mtd_free_cell(mtd, line, col);
+void tickit_mockterm_resize(TickitMockTerm *mt, int newlines, int newcols)
+{
+  MockTermDriver *mtd = (MockTermDriver *)tickit_term_get_driver((TickitTerm *)mt);
 
-      for(col = 0; col < newcols && col < oldcols; col++)
-        newlinecells[col] = mtd->cells[line][col];
-      for(/* col */; col < newcols; col++)
-        newlinecells[col] = NULL;
+  int oldlines = mtd->lines;
+  int oldcols =  mtd->cols;
+
+  MockTermCell *newcells = malloc((size_t)newlines * newcols * sizeof(MockTermCell));
 
-      free(mtd->cells[line]);
+  int keeplines = newlines < oldlines ? newlines : oldlines;
+  int keepcols  = newcols  < oldcols  ? newcols  : oldcols;
+
+  for(int line = 0; line < oldlines; line++) {
+    MockTermCell *oldline = mtd_cell(mtd, line, 0);
+
+    if(line >= keeplines) {
+      mtd_free_cells(oldline, oldcols);
+      continue;
     }
 
-    newcells[line] = newlinecells;
+    MockTermCell *newline = newcells + (size_t)line * newcols;
+    memcpy(newline, oldline, keepcols * sizeof(MockTermCell));
+    mtd_free_cells(oldline + keepcols, oldcols - keepcols);
+    mtd_init_cells(mtd, newline + keepcols, newcols - keepcols);
   }
-  for(/* line */; line < newlines; line++)
-    newcells[line] = NULL;
+
+  if(newlines > keeplines)
+    mtd_init_cells(mtd, newcells + (size_t)keeplines * newcols, (newlines - keeplines) * newcols);
 
   free(mtd->cells);
   mtd->cells = newcells;
@@ -535,19 +578,28 @@ void tickit_mockterm_resize(TickitMockTerm *mt, int newlines, int newcols)
   mtd->lines = newlines;
   mtd->cols  = newcols;
 
-  if(newcols > oldcols)
-    for(line = 0; line < newlines && line < oldlines; line++)
-      mtd_clear_cells(mtd, line, oldcols, newcols);
-
-  for(line = oldlines; line < newlines; line++)
-    mtd_clear_cells(mtd, line, 0, newcols);
-
   tickit_term_set_size((TickitTerm *)mt, newlines, newcols);
 
   BOUND(mtd->line, 0, mtd->lines-1);
   BOUND(mtd->col,  0, mtd->cols-1);
 }
 
+void tickit_mockterm_set_loglimit(TickitMockTerm *mt, int limit)
+{
+  MockTermDriver *mtd = (MockTermDriver *)tickit_term_get_driver((TickitTerm *)mt);
+
+  tickit_mockterm_clearlog(mt);
+
+  mtd->loglimit = limit < 0 ? -1 : limit;
+
+  // A ring is allocated at exactly its final size, so it never grows
+  size_t size = limit > 0 ? (size_t)limit : 16;
+  if(size != mtd->logsize) {
+    mtd->logsize = size;
+    mtd->log = realloc(mtd->log, mtd->logsize * sizeof(TickitMockTermLogEntry));
+  }
+}
+
 int tickit_mockterm_loglen(TickitMockTerm *mt)
 {
   MockTermDriver *mtd = (MockTermDriver *)tickit_term_get_driver((TickitTerm *)mt);
@@ -560,7 +612,7 @@ TickitMockTermLogEntry *tickit_mockterm_peeklog(TickitMockTerm *mt, int i)
   MockTermDriver *mtd = (MockTermDriver *)tickit_term_get_driver((TickitTerm *)mt);
 
   if(i >= 0 && i < mtd->logi)
-    return mtd->log + i;
+    return mtd->log + (mtd->logstart + i) % mtd->logsize;
 
   return NULL;
 }
@@ -569,9 +621,10 @@ void tickit_mockterm_clearlog(TickitMockTerm *mt)
 {
   MockTermDriver *mtd = (MockTermDriver *)tickit_term_get_driver((TickitTerm *)mt);
 
-  for(int i = 0; i < mtd->logi; i++)
-    mtd_free_logentry(mtd->log + i);
+  for(size_t i = 0; i < mtd->logi; i++)
+    mtd_free_logentry(mtd->log + (mtd->logstart + i) % mtd->logsize);
 
+  mtd->logstart = 0;
   mtd->logi = 0;
 }
 
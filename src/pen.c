@@ -33,7 +33,7 @@ struct TickitPen {
                  blink   : 1;
   } valid;
 
-  struct TickitEventHook *hooks;
+  struct TickitHooklist hooks;
 };
 
 DEFINE_HOOKLIST_FUNCS(pen,TickitPen,TickitPenEventFn)
@@ -44,7 +44,7 @@ TickitPen *tickit_pen_new(void)
   if(!pen)
     return NULL;
 
-  pen->hooks = NULL;
+  tickit_hooklist_init(&pen->hooks);
 
   tickit_pen_clear(pen);
 
@@ -99,7 +99,7 @@ TickitPen *tickit_pen_clone(const TickitPen *orig)
 
 void tickit_pen_destroy(TickitPen *pen)
 {
-  tickit_hooklist_unbind_and_destroy(pen->hooks, pen);
+  tickit_hooklist_unbind_and_destroy(&pen->hooks, pen);
   free(pen);
 }
 
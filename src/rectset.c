@@ -1,7 +1,15 @@
 #include "tickit.h"
 
+#include <stdlib.h>
 #include <string.h> // memcpy, memmove
 
+/* The region is kept in canonical banded form, as X11 regions are. It is cut
+ * into horizontal bands; all the rects in a band share its top and bottom,
+ * and are sorted left to right with gaps between them. No two bands that
+ * touch vertically have identical spans. Equal regions therefore always have
+ * the same list of rects, sorted first by top then by left, and because
+ * bands don't overlap both tops and bottoms ascend along the array.
+ */
 struct TickitRectSet {
   TickitRect *rects;
   size_t      count;  /* How many we consider valid */
@@ -53,176 +61,334 @@ size_t tickit_rectset_get_rects(const TickitRectSet *trs, TickitRect rects[], si
   return n;
 }
 
-static int cmprect(const TickitRect *a, const TickitRect *b)
+static int ensure_size(TickitRectSet *trs, size_t count)
 {
-  if(a->top != b->top)
-    return a->top - b->top;
-  return a->left - b->left;
-}
+  if(count <= trs->size)
+    return 1;
 
-static int insert_rect(TickitRectSet *trs, const TickitRect *r)
-{
-  if(trs->count + 1 > trs->size) {
-    TickitRect *newrects = realloc(trs->rects, trs->size * 2 * sizeof(trs->rects[0]));
-    if(!newrects)
-      return 0;
+  size_t size = trs->size ? trs->size : 4;
+  while(size < count)
+    size *= 2;
 
-    trs->rects = newrects;
-    trs->size *= 2;
-  }
+  TickitRect *newrects = realloc(trs->rects, size * sizeof(trs->rects[0]));
+  if(!newrects)
+    return 0;
+
+  trs->rects = newrects;
+  trs->size = size;
+  return 1;
+}
 
-  /* TODO: binary search */
-  int idx;
-  for(idx = 0; idx < trs->count; idx++)
-    if(cmprect(trs->rects + idx, r) > 0)
-      break;
+static int append_rect(TickitRectSet *trs, int top, int left, int bottom, int right)
+{
+  if(!ensure_size(trs, trs->count + 1))
+    return 0;
 
-  memmove(trs->rects + idx + 1, trs->rects + idx, (trs->count - idx) * sizeof(trs->rects[0]));
-  trs->rects[idx] = *r;
+  tickit_rect_init_bounded(trs->rects + trs->count, top, left, bottom, right);
   trs->count++;
   return 1;
 }
 
-static void delete_rect(TickitRectSet *trs, int idx)
+/* Index of the first rect whose band extends below line */
+static size_t find_below(const TickitRectSet *trs, int line)
 {
-  memmove(trs->rects + idx, trs->rects + idx + 1, (trs->count - idx - 1) * sizeof(trs->rects[0]));
-  trs->count--;
+  size_t lo = 0, hi = trs->count;
+  while(lo < hi) {
+    size_t mid = (lo + hi) / 2;
+    if(tickit_rect_bottom(trs->rects + mid) > line)
+      hi = mid;
+    else
+      lo = mid + 1;
+  }
+  return lo;
 }
 
-void tickit_rectset_add(TickitRectSet *trs, const TickitRect *rect)
+/* Index of the first rect whose band starts at or below line */
+static size_t find_from(const TickitRectSet *trs, int line)
 {
-  int top    = rect->top;
-  int bottom = tickit_rect_bottom(rect);
-  int left   = rect->left;
-  int right  = tickit_rect_right(rect);
+  size_t lo = 0, hi = trs->count;
+  while(lo < hi) {
+    size_t mid = (lo + hi) / 2;
+    if(trs->rects[mid].top >= line)
+      hi = mid;
+    else
+      lo = mid + 1;
+  }
+  return lo;
+}
 
-restart:
-  for(int i = 0; i < trs->count; i++) {
-    TickitRect *r = trs->rects + i;
-    int r_bottom = tickit_rect_bottom(r);
-    int r_right  = tickit_rect_right(r);
+static size_t band_end(const TickitRectSet *trs, size_t idx)
+{
+  int top = trs->rects[idx].top;
+  while(idx < trs->count && trs->rects[idx].top == top)
+    idx++;
+  return idx;
+}
 
-    // Because the rects are ordered, there is no point continuing if we're
-    // already past it
-    if(bottom < r->top)
-      break;
+/* If the band starting at idx merely continues the one above it, merge the
+ * two
+ */
+static void coalesce(TickitRectSet *trs, size_t idx)
+{
+  if(idx == 0 || idx >= trs->count)
+    return;
 
-    if(top > r_bottom || left > r_right || right < r->left)
-      continue;
+  size_t prev = idx - 1;
+  while(prev > 0 && trs->rects[prev - 1].top == trs->rects[idx - 1].top)
+    prev--;
+
+  size_t end = band_end(trs, idx);
+  size_t n = idx - prev;
 
-    if(tickit_rect_contains(r, rect))
-      // Already entirely covered, just return
+  if(end - idx != n ||
+     tickit_rect_bottom(trs->rects + prev) != trs->rects[idx].top)
+    return;
+
+  for(size_t i = 0; i < n; i++)
+    if(trs->rects[prev + i].left != trs->rects[idx + i].left ||
+       trs->rects[prev + i].cols != trs->rects[idx + i].cols)
       return;
 
-    int top_eq    = top    == r->top;
-    int bottom_eq = bottom == r_bottom;
-    int left_eq   = left   == r->left;
-    int right_eq  = right  == r_right;
-
-    if((top_eq && bottom_eq) || (left_eq && right_eq)) {
-      // Stretch an existing rectangle horizontally or vertically
-      // Tempting to think we can just do this in-place but needs to account
-      // for being able to merge multiple at once
-      if(r->top   < top)    top    = r->top;
-      if(r_bottom > bottom) bottom = r_bottom;
-      if(r->left  < left)   left   = r->left;
-      if(r_right  > right)  right  = r_right;
-
-      delete_rect(trs, i);
-      goto restart;
+  int lines = trs->rects[idx].lines;
+  for(size_t i = prev; i < idx; i++)
+    trs->rects[i].lines += lines;
+
+  memmove(trs->rects + idx, trs->rects + end, (trs->count - end) * sizeof(trs->rects[0]));
+  trs->count -= n;
+}
+
+static int cmpint(const void *a, const void *b)
+{
+  int ia = *(const int *)a, ib = *(const int *)b;
+  return (ia > ib) - (ia < ib);
+}
+
+static int cmptop(const void *a, const void *b)
+{
+  return cmpint(&((const TickitRect *)a)->top, &((const TickitRect *)b)->top);
+}
+
+static int cmpleft(const void *a, const void *b)
+{
+  return cmpint(&((const TickitRect *)a)->left, &((const TickitRect *)b)->left);
+}
+
+/* Appends to out the banded form of the union of in[0..n), less the area of
+ * sub if given, by sweeping down through every line where any of them starts
+ * or stops
+ */
+static int sweep(TickitRectSet *out, const TickitRect in[], size_t n, const TickitRect *sub)
+{
+  int ret = 0;
+
+  TickitRect *sorted = malloc(n * sizeof(sorted[0]));
+  TickitRect *active = malloc(n * sizeof(active[0])); /* sorted by left */
+  int *lines = malloc((2 * n + 2) * sizeof(lines[0]));
+  if(!sorted || !active || !lines)
+    goto out;
+
+  memcpy(sorted, in, n * sizeof(sorted[0]));
+  qsort(sorted, n, sizeof(sorted[0]), cmptop);
+
+  size_t nlines = 0;
+  for(size_t i = 0; i < n; i++) {
+    lines[nlines++] = sorted[i].top;
+    lines[nlines++] = tickit_rect_bottom(sorted + i);
+  }
+  if(sub) {
+    lines[nlines++] = sub->top;
+    lines[nlines++] = tickit_rect_bottom(sub);
+  }
+  qsort(lines, nlines, sizeof(lines[0]), cmpint);
+
+  int sub_left  = sub ? sub->left : 0;
+  int sub_right = sub ? tickit_rect_right(sub) : 0;
+
+  size_t next = 0, nactive = 0;
+
+  for(size_t l = 0; l + 1 < nlines; l++) {
+    int top = lines[l], bottom = lines[l+1];
+    if(top == bottom)
+      continue;
+
+    /* Retire rects that have ended and admit those that now start */
+    size_t j = 0;
+    for(size_t i = 0; i < nactive; i++)
+      if(tickit_rect_bottom(active + i) > top)
+        active[j++] = active[i];
+    nactive = j;
+
+    int admitted = 0;
+    while(next < n && sorted[next].top <= top) {
+      if(tickit_rect_bottom(sorted + next) > top) {
+        active[nactive++] = sorted[next];
+        admitted = 1;
+      }
+      next++;
     }
+    if(admitted)
+      qsort(active, nactive, sizeof(active[0]), cmpleft);
 
-    if(top == r_bottom || bottom == r->top)
-      // No actual interaction, just add it. This case handles the recursion
-      // implied at the end of this loop
+    if(!nactive)
       continue;
 
-    // Non-simple interaction. Split r and rect into the 2 or 3 separate rects
-    // it now must be composed of, delete r, then recurse on those to-be-added
-    // rects instead.
-    TickitRect to_add[3];
-    int n = tickit_rect_add(to_add, r, rect); // TODO: top/left/bottom/right ?
+    int subtract = sub && top >= sub->top && top < tickit_rect_bottom(sub);
+    size_t band = out->count;
+
+    for(size_t i = 0; i < nactive; ) {
+      int left  = active[i].left;
+      int right = tickit_rect_right(active + i);
+      for(i++; i < nactive && active[i].left <= right; i++)
+        if(tickit_rect_right(active + i) > right)
+          right = tickit_rect_right(active + i);
+
+      if(subtract && left < sub_right && right > sub_left) {
+        if(left < sub_left &&
+           !append_rect(out, top, left, bottom, sub_left))
+          goto out;
+        if(right > sub_right &&
+           !append_rect(out, top, sub_right, bottom, right))
+          goto out;
+      }
+      else if(!append_rect(out, top, left, bottom, right))
+        goto out;
+    }
+
+    coalesce(out, band);
+  }
+
+  ret = 1;
+
+out:
+  free(sorted);
+  free(active);
+  free(lines);
+  return ret;
+}
 
-    delete_rect(trs, i);
+/* Recomputes the bands that overlap lines top to bottom from their own rects
+ * and the n extra ones, less the area of sub if given, then splices them back
+ * in
+ */
+static void rebuild(TickitRectSet *trs, int top, int bottom, const TickitRect extra[], size_t n, const TickitRect *sub)
+{
+  size_t lo = find_below(trs, top);
+  size_t hi = find_from(trs, bottom);
+  if(hi < lo)
+    hi = lo;
 
-    for(i = 0; i < n; i++)
-      tickit_rectset_add(trs, to_add + i);
+  size_t nin = (hi - lo) + n;
+  if(!nin)
     return;
-  }
 
-  // If we got this far then we need to add it
-  TickitRect new;
-  tickit_rect_init_bounded(&new, top, left, bottom, right);
+  TickitRectSet out = { .rects = NULL, .count = 0, .size = 0 };
+  TickitRect *in = malloc(nin * sizeof(in[0]));
+  if(!in)
+    return;
+
+  memcpy(in, trs->rects + lo, (hi - lo) * sizeof(in[0]));
+  if(n)
+    memcpy(in + (hi - lo), extra, n * sizeof(in[0]));
 
   // TODO: error handling
-  insert_rect(trs, &new);
+  if(sweep(&out, in, nin, sub) &&
+     ensure_size(trs, trs->count - (hi - lo) + out.count)) {
+    memmove(trs->rects + lo + out.count, trs->rects + hi, (trs->count - hi) * sizeof(trs->rects[0]));
+    if(out.count)
+      memcpy(trs->rects + lo, out.rects, out.count * sizeof(trs->rects[0]));
+    trs->count = trs->count - (hi - lo) + out.count;
+
+    coalesce(trs, lo + out.count);
+    coalesce(trs, lo);
+  }
+
+  free(in);
+  free(out.rects);
 }
 
-void tickit_rectset_subtract(TickitRectSet *trs, const TickitRect *rect)
+void tickit_rectset_add(TickitRectSet *trs, const TickitRect *rect)
 {
-  for(int i = 0; i < trs->count; i++) {
-    TickitRect *r = trs->rects + i;
-    if(!tickit_rect_intersects(r, rect))
-      continue;
+  tickit_rectset_add_many(trs, rect, 1);
+}
 
-    TickitRect remains[4];
-    int n = tickit_rect_subtract(remains, r, rect);
+void tickit_rectset_add_many(TickitRectSet *trs, const TickitRect rects[], size_t n)
+{
+  TickitRect *extra = malloc(n * sizeof(extra[0]));
+  if(!extra)
+    return;
+
+  size_t nextra = 0;
+  int top = 0, bottom = 0;
 
-    delete_rect(trs, i);
-    i--;
+  for(size_t i = 0; i < n; i++) {
+    if(rects[i].lines <= 0 || rects[i].cols <= 0)
+      continue;
 
-    // It doesn't matter if insert starts putting these before i; the worst
-    // that will happen is that a few rects that we inspected once just move
-    // underneath us and we have to inspect them a second time
-    int j;
-    for(j = 0; j < n; j++)
-      tickit_rectset_add(trs, remains + j);
+    if(!nextra || rects[i].top < top)
+      top = rects[i].top;
+    if(!nextra || tickit_rect_bottom(rects + i) > bottom)
+      bottom = tickit_rect_bottom(rects + i);
+
+    extra[nextra++] = rects[i];
   }
+
+  if(nextra == 1 && tickit_rectset_contains(trs, extra))
+    // Already entirely covered
+    ;
+  else if(nextra)
+    rebuild(trs, top, bottom, extra, nextra, NULL);
+
+  free(extra);
+}
+
+void tickit_rectset_subtract(TickitRectSet *trs, const TickitRect *rect)
+{
+  if(rect->lines <= 0 || rect->cols <= 0)
+    return;
+
+  if(!tickit_rectset_intersects(trs, rect))
+    return;
+
+  rebuild(trs, rect->top, tickit_rect_bottom(rect), NULL, 0, rect);
 }
 
 int tickit_rectset_intersects(const TickitRectSet *trs, const TickitRect *rect)
 {
-  for(int i = 0; i < trs->count; i++)
+  int bottom = tickit_rect_bottom(rect);
+
+  for(size_t i = find_below(trs, rect->top); i < trs->count && trs->rects[i].top < bottom; i++)
     if(tickit_rect_intersects(trs->rects + i, rect))
       return 1;
 
   return 0;
 }
 
-int tickit_rectset_contains(const TickitRectSet *trs, const TickitRect *rectptr)
+int tickit_rectset_contains(const TickitRectSet *trs, const TickitRect *rect)
 {
-  // We might want to modify it
-  TickitRect rect = *rectptr;
+  if(rect->lines <= 0 || rect->cols <= 0)
+    return 0;
 
-  for(int i = 0; i < trs->count; i++) {
-    TickitRect *r = trs->rects + i;
-    if(!tickit_rect_intersects(r, &rect))
-      continue;
+  int line   = rect->top;
+  int bottom = tickit_rect_bottom(rect);
+  int right  = tickit_rect_right(rect);
 
-    // Because rects are in order, if there's any part of rect above or to
-    // the left of here we know we didn't match it
-    if(rect.top  < r->top ||
-       rect.left < r->left)
+  // Every band from the top down must follow on from the last, and have a
+  // single span covering all of rect's columns
+  size_t i = find_below(trs, line);
+  while(line < bottom) {
+    if(i >= trs->count || trs->rects[i].top > line)
       return 0;
 
-    int r_bottom = tickit_rect_bottom(r);
-    int rect_bottom = tickit_rect_bottom(&rect);
-
-    if(rect.top < r_bottom && r_bottom < rect_bottom) {
-      int rect_right = tickit_rect_right(&rect);
-
-      TickitRect lower;
-      tickit_rect_init_bounded(&lower, r_bottom, rect.left, rect_bottom, rect_right);
-
-      if(!tickit_rectset_contains(trs, &lower))
-        return 0;
-
-      // tickit_rect_init_bounded(&rect, rect.top, rect.left, r_bottom, r_right)
-      rect.lines = r_bottom - rect.top;
-    }
+    size_t end = band_end(trs, i);
+    for(; i < end; i++)
+      if(trs->rects[i].left <= rect->left && tickit_rect_right(trs->rects + i) >= right)
+        break;
+    if(i == end)
+      return 0;
 
-    return tickit_rect_contains(r, &rect);
+    line = tickit_rect_bottom(trs->rects + i);
+    i = end;
   }
 
-  return 0;
+  return 1;
 }
@@ -0,0 +1,268 @@
+#include "tickit.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "renderbuffer-tiled.h"
+
+/* Each tile is drawn into a private RenderBuffer of its own, holding its own
+ * cells, text, pens and state stack, so tiles can be filled concurrently. Only
+ * the final blits into the real buffer touch shared state, and those happen
+ * on the calling thread in the order the tiles were given.
+ *
+ * The threads and the tile buffers both belong to a pool kept by the real
+ * buffer, so a frame drawn every few milliseconds doesn't pay for starting
+ * threads or allocating cells each time. A child process after fork() has
+ * none of the threads, so starts a pool of its own.
+ */
+
+struct TiledRender {
+  const TickitRect         *rects;
+  size_t                    n;
+
+  TickitRenderBufferTileFn *fn;
+  void                     *data;
+
+  int                       nworkers; // pool threads that may take part
+  size_t                    next;     // index of the next tile to be drawn
+};
+
+struct TiledWorker {
+  struct TickitTiledPool *pool;
+  int                     index;
+  unsigned long           seen; // generation of the last job looked at
+};
+
+struct TickitTiledPool {
+  pthread_mutex_t      lock;
+  pthread_cond_t       work; // signalled when a job starts, or on shutdown
+  pthread_cond_t       done; // signalled when the last worker leaves a job
+
+  pthread_t           *threads;
+  struct TiledWorker **workers;
+  int                  nthreads;
+
+  unsigned long        generation; // bumped for each job
+  struct TiledRender  *job;
+  int                  busy;       // workers yet to leave the current job
+  unsigned int         shutdown : 1;
+
+  TickitRenderBuffer **tiles; // kept between jobs, resized as needed
+  size_t               size_tiles;
+
+  pid_t                pid; // the process the threads belong to
+};
+
+static TickitRenderBuffer *get_tile(struct TickitTiledPool *pool, size_t i, const TickitRect *rect)
+{
+  TickitRenderBuffer *tile = pool->tiles[i];
+
+  // Resizing also resets it
+  if(tile)
+    tickit_renderbuffer_resize(tile, rect->lines, rect->cols);
+  else
+    tile = pool->tiles[i] = tickit_renderbuffer_new(rect->lines, rect->cols);
+
+  tickit_renderbuffer_translate(tile, -rect->top, -rect->left);
+
+  return tile;
+}
+
+static void run_tiles(struct TickitTiledPool *pool, struct TiledRender *tr)
+{
+  while(1) {
+    pthread_mutex_lock(&pool->lock);
+    size_t i = tr->next++;
+    pthread_mutex_unlock(&pool->lock);
+
+    if(i >= tr->n)
+      break;
+
+    // get_tile() only touches slot i, so needs no lock
+    TickitRenderBuffer *tile = get_tile(pool, i, &tr->rects[i]);
+    (*tr->fn)(tile, &tr->rects[i], tr->data);
+  }
+}
+
+static void *worker(void *arg)
+{
+  struct TiledWorker *w = arg;
+  struct TickitTiledPool *pool = w->pool;
+
+  pthread_mutex_lock(&pool->lock);
+
+  while(1) {
+    while(!pool->shutdown && pool->generation == w->seen)
+      pthread_cond_wait(&pool->work, &pool->lock);
+
+    if(pool->shutdown)
+      break;
+
+    w->seen = pool->generation;
+    struct TiledRender *tr = pool->job;
+
+    if(w->index < tr->nworkers) {
+      pthread_mutex_unlock(&pool->lock);
+      run_tiles(pool, tr);
+      pthread_mutex_lock(&pool->lock);
+    }
+
+    if(!--pool->busy)
+      pthread_cond_signal(&pool->done);
+  }
+
+  pthread_mutex_unlock(&pool->lock);
+
+  return NULL;
+}
+
+static struct TickitTiledPool *pool_new(void)
+{
+  struct TickitTiledPool *pool = malloc(sizeof(struct TickitTiledPool));
+
+  pthread_mutex_init(&pool->lock, NULL);
+  pthread_cond_init(&pool->work, NULL);
+  pthread_cond_init(&pool->done, NULL);
+
+  pool->threads  = NULL;
+  pool->workers  = NULL;
+  pool->nthreads = 0;
+
+  pool->generation = 0;
+  pool->job        = NULL;
+  pool->busy       = 0;
+  pool->shutdown   = 0;
+
+  pool->tiles      = NULL;
+  pool->size_tiles = 0;
+
+  pool->pid = getpid();
+
+  return pool;
+}
+
+// Called with the lock held, before the job's generation is bumped, so each
+// new worker joins in with it
+static void pool_grow(struct TickitTiledPool *pool, int nthreads)
+{
+  if(nthreads <= pool->nthreads)
+    return;
+
+  pool->threads = realloc(pool->threads, nthreads * sizeof(pthread_t));
+  pool->workers = realloc(pool->workers, nthreads * sizeof(struct TiledWorker *));
+
+  while(pool->nthreads < nthreads) {
+    struct TiledWorker *w = malloc(sizeof(struct TiledWorker));
+    w->pool  = pool;
+    w->index = pool->nthreads;
+    w->seen  = pool->generation;
+
+    // The calling thread works too, so it can always finish on its own even
+    // if no more threads could be started
+    if(pthread_create(&pool->threads[pool->nthreads], NULL, worker, w) != 0) {
+      free(w);
+      break;
+    }
+
+    pool->workers[pool->nthreads++] = w;
+  }
+}
+
+void tickit_tiledpool_destroy(struct TickitTiledPool *pool)
+{
+  int forked = pool->pid != getpid();
+
+  if(!forked) {
+    pthread_mutex_lock(&pool->lock);
+    pool->shutdown = 1;
+    pthread_cond_broadcast(&pool->work);
+    pthread_mutex_unlock(&pool->lock);
+  }
+
+  for(int i = 0; i < pool->nthreads; i++) {
+    if(!forked)
+      pthread_join(pool->threads[i], NULL);
+    free(pool->workers[i]);
+  }
+
+  free(pool->threads);
+  free(pool->workers);
+
+  for(size_t i = 0; i < pool->size_tiles; i++)
+    if(pool->tiles[i])
+      tickit_renderbuffer_destroy(pool->tiles[i]);
+  free(pool->tiles);
+
+  pthread_cond_destroy(&pool->done);
+  pthread_cond_destroy(&pool->work);
+  pthread_mutex_destroy(&pool->lock);
+
+  free(pool);
+}
+
+void tickit_renderbuffer_render_tiled(TickitRenderBuffer *rb, const TickitRect rects[], size_t n,
+    TickitRenderBufferTileFn *fn, void *data, int nthreads)
+{
+  if(!n)
+    return;
+
+  struct TickitTiledPool **poolp = tickit_renderbuffer_tiledpool(rb);
+  if(*poolp && (*poolp)->pid != getpid()) {
+    tickit_tiledpool_destroy(*poolp);
+    *poolp = NULL;
+  }
+  if(!*poolp)
+    *poolp = pool_new();
+  struct TickitTiledPool *pool = *poolp;
+
+  if(n > pool->size_tiles) {
+    pool->tiles = realloc(pool->tiles, n * sizeof(TickitRenderBuffer *));
+    while(pool->size_tiles < n)
+      pool->tiles[pool->size_tiles++] = NULL;
+  }
+
+  if(nthreads > 1 && (size_t)nthreads > n)
+    nthreads = (int)n;
+
+  struct TiledRender tr = {
+    .rects    = rects,
+    .n        = n,
+    .fn       = fn,
+    .data     = data,
+    .nworkers = nthreads - 1,
+    .next     = 0,
+  };
+
+  if(nthreads > 1) {
+    pthread_mutex_lock(&pool->lock);
+
+    pool_grow(pool, nthreads - 1);
+
+    pool->job  = &tr;
+    pool->busy = pool->nthreads;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->work);
+
+    pthread_mutex_unlock(&pool->lock);
+  }
+
+  run_tiles(pool, &tr);
+
+  if(nthreads > 1) {
+    pthread_mutex_lock(&pool->lock);
+    while(pool->busy)
+      pthread_cond_wait(&pool->done, &pool->lock);
+    pool->job = NULL;
+    pthread_mutex_unlock(&pool->lock);
+  }
+
+  for(size_t i = 0; i < n; i++) {
+    TickitRect all;
+    tickit_rect_init_sized(&all, 0, 0, rects[i].lines, rects[i].cols);
+
+    tickit_renderbuffer_blit(rb, pool->tiles[i], &all, rects[i].top, rects[i].left);
+    // Leave nothing referenced by the tile, such as pens, until next time
+    tickit_renderbuffer_reset(pool->tiles[i]);
+  }
+}
@@ -0,0 +1,11 @@
+#include "tickit.h"
+
+/* The worker threads behind tickit_renderbuffer_render_tiled(); each
+ * RenderBuffer starts its own the first time it is asked for more than one
+ * thread, and keeps them until it is destroyed
+ */
+struct TickitTiledPool;
+
+struct TickitTiledPool **tickit_renderbuffer_tiledpool(TickitRenderBuffer *rb);
+
+void tickit_tiledpool_destroy(struct TickitTiledPool *pool);
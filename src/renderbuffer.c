@@ -1,12 +1,10 @@
-/* We need strdup */
-#define _XOPEN_SOURCE 500
-
 #include "tickit.h"
 
 #include <stdlib.h>
 #include <string.h>
 
 #include "linechars.inc"
+#include "renderbuffer-tiled.h"
 
 /* must match .pm file */
 enum TickitRenderBufferCellState {
@@ -25,19 +23,48 @@ enum {
   WEST_SHIFT  = 6,
 };
 
-// Internal cell structure definition
+// Internal cell structure definition. Kept small, as a whole frame of these
+// is scanned on every flush
 typedef struct {
-  enum TickitRenderBufferCellState state;
+  unsigned int state : 3; // enum TickitRenderBufferCellState
+  signed int maskdepth : 29; // -1 if not masked
   int len; // or "startcol" for state == CONT
-  int maskdepth; // -1 if not masked
-  TickitPen *pen; // state -> {TEXT, ERASE, LINE, CHAR}
+  int pen; // index into rb->pens; state -> {TEXT, ERASE, LINE, CHAR}
   union {
-    struct { int idx; int offs; } text; // state == TEXT
+    struct { int start; int bytes; int lead; } text; // state == TEXT; this span's bytes in rb->textarena
     struct { int mask;          } line; // state == LINE
     struct { int codepoint;     } chr;  // state == CHAR
   } v;
 } RBCell;
 
+enum RBFrontState {
+  FRONT_UNKNOWN = 0,
+  FRONT_ERASE,
+  FRONT_GLYPH,
+  FRONT_CONT, // right-hand half of a wide glyph
+};
+
+#define FRONT_TEXTSIZE 8
+
+// What the terminal is believed to currently display in one cell. Glyphs
+// longer than FRONT_TEXTSIZE bytes are not remembered and always redrawn
+typedef struct {
+  unsigned char state;
+  unsigned char bytes; // state == FRONT_GLYPH
+  int pen;             // index into rb->pens, holding a reference
+  char text[FRONT_TEXTSIZE];
+} RBFrontCell;
+
+// Identical pens are interned, so cells share one immutable refcounted copy
+typedef struct {
+  TickitPen *pen; // NULL if this slot is free
+  int refcount;
+  unsigned int hash;
+  int next; // next slot in the same hash bucket, or on the free list
+} RBPen;
+
+#define PEN_BUCKETS 64
+
 typedef struct RBStack RBStack;
 struct RBStack {
   RBStack *prev;
@@ -51,7 +78,10 @@ struct RBStack {
 
 struct TickitRenderBuffer {
   int lines, cols; // Size
-  RBCell **cells;
+  RBCell **cells;   // per-line pointers into cellbuf
+  RBCell *cellbuf;  // all the cells, in one allocation
+  size_t size_cells;
+  unsigned char *dirty; // per line; true if drawn or masked since the last reset
 
   unsigned int vc_pos_set : 1;
   int vc_line, vc_col;
@@ -62,13 +92,29 @@ struct TickitRenderBuffer {
   int depth;
   RBStack *stack;
 
-  char **texts;
-  size_t n_texts;    // number actually valid
-  size_t size_texts; // size of allocated buffer
+  // Bump allocated storage for all the text of the current frame
+  char *textarena;
+  size_t textlen;  // actually valid
+  size_t textsize; // allocated size
 
   char *tmp;
   size_t tmplen;  // actually valid
   size_t tmpsize; // allocated size
+
+  RBPen *pens;
+  int n_pens;    // slots ever used
+  int size_pens; // allocated size
+  int free_pens; // head of the free slot list, or -1
+  int pen_buckets[PEN_BUCKETS];
+  TickitPen *mergepen; // scratch space for merge_pen()
+
+  // Retained mode - NULL if disabled
+  RBFrontCell *front;
+  unsigned int *linehash; // 2 * lines; scratch space for scroll detection
+
+  TickitRenderBufferStats stats;
+
+  struct TickitTiledPool *tiledpool; // NULL until render_tiled needs threads
 };
 
 static void free_stack(RBStack *stack)
@@ -83,19 +129,128 @@ static void free_stack(RBStack *stack)
   }
 }
 
-static void free_texts(TickitRenderBuffer *rb)
+#define TEXTARENA_MIN 1024
+
+static void reset_texts(TickitRenderBuffer *rb)
+{
+  // Prevent the arena staying too big after one unusually large frame
+  if(rb->textsize > TEXTARENA_MIN && rb->textsize > rb->textlen * 4) {
+    rb->textsize /= 2;
+    rb->textarena = realloc(rb->textarena, rb->textsize);
+  }
+
+  rb->textlen = 0;
+}
+
+static inline const char *cell_text(const TickitRenderBuffer *rb, const RBCell *cell)
+{
+  return rb->textarena + cell->v.text.start;
+}
+
+/* A TEXT span stores just the bytes of its own columns. Its text may begin
+ * with a wide glyph that straddles the start of the span; lead counts the
+ * columns of that glyph which lie before it. Returns the position of the
+ * given column within the span's bytes
+ */
+static TickitStringPos text_offset(const TickitRenderBuffer *rb, const RBCell *cell, int col)
+{
+  TickitStringPos pos, limit;
+  tickit_stringpos_limit_columns(&limit, cell->v.text.lead + col);
+  tickit_string_ncount(cell_text(rb, cell), cell->v.text.bytes, &pos, &limit);
+  return pos;
+}
+
+static int pen_identical(const TickitPen *a, const TickitPen *b)
+{
+  for(TickitPenAttr attr = 0; attr < TICKIT_N_PEN_ATTRS; attr++) {
+    int has = tickit_pen_has_attr(a, attr);
+    if(has != tickit_pen_has_attr(b, attr))
+      return 0;
+    if(has && !tickit_pen_equiv_attr(a, b, attr))
+      return 0;
+  }
+
+  return 1;
+}
+
+static unsigned int pen_hash(const TickitPen *pen)
+{
+  unsigned int hash = 0;
+
+  for(TickitPenAttr attr = 0; attr < TICKIT_N_PEN_ATTRS; attr++) {
+    int val = -2;
+    if(tickit_pen_has_attr(pen, attr))
+      switch(tickit_pen_attrtype(attr)) {
+        case TICKIT_PENTYPE_BOOL:   val = tickit_pen_get_bool_attr(pen, attr);   break;
+        case TICKIT_PENTYPE_INT:    val = tickit_pen_get_int_attr(pen, attr);    break;
+        case TICKIT_PENTYPE_COLOUR: val = tickit_pen_get_colour_attr(pen, attr); break;
+      }
+
+    hash = hash * 33 + val;
+  }
+
+  return hash;
+}
+
+// Returns the index of an interned copy of pen, with a new reference on it
+static int pen_intern(TickitRenderBuffer *rb, const TickitPen *pen)
 {
-  for(int i = 0; i < rb->n_texts; i++)
-    free(rb->texts[i]);
+  unsigned int hash = pen_hash(pen);
+  int *bucket = &rb->pen_buckets[hash % PEN_BUCKETS];
+
+  for(int idx = *bucket; idx != -1; idx = rb->pens[idx].next) {
+    RBPen *p = &rb->pens[idx];
+    if(p->hash == hash && pen_identical(p->pen, pen)) {
+      p->refcount++;
+      return idx;
+    }
+  }
 
-  // Prevent the buffer growing too big
-  if(rb->size_texts > 4 && rb->size_texts > rb->n_texts * 2) {
-    rb->size_texts /= 2;
-    free(rb->texts);
-    rb->texts = malloc(rb->size_texts * sizeof(char *));
+  int idx;
+  if(rb->free_pens != -1) {
+    idx = rb->free_pens;
+    rb->free_pens = rb->pens[idx].next;
   }
+  else {
+    if(rb->n_pens == rb->size_pens) {
+      rb->size_pens *= 2;
+      rb->pens = realloc(rb->pens, rb->size_pens * sizeof(RBPen));
+    }
+    idx = rb->n_pens++;
+  }
+
+  RBPen *p = &rb->pens[idx];
+  p->pen      = tickit_pen_clone(pen);
+  p->refcount = 1;
+  p->hash     = hash;
+  p->next     = *bucket;
+  *bucket = idx;
+
+  return idx;
+}
+
+static int pen_ref(TickitRenderBuffer *rb, int idx)
+{
+  rb->pens[idx].refcount++;
+  return idx;
+}
+
+static void pen_unref(TickitRenderBuffer *rb, int idx)
+{
+  RBPen *p = &rb->pens[idx];
+  if(--p->refcount)
+    return;
+
+  int *link = &rb->pen_buckets[p->hash % PEN_BUCKETS];
+  while(*link != idx)
+    link = &rb->pens[*link].next;
+  *link = p->next;
+
+  tickit_pen_destroy(p->pen);
+  p->pen = NULL;
 
-  rb->n_texts = 0;
+  p->next = rb->free_pens;
+  rb->free_pens = idx;
 }
 
 static int xlate_and_clip(TickitRenderBuffer *rb, int *line, int *col, int *len, int *startcol)
@@ -131,14 +286,14 @@ static int xlate_and_clip(TickitRenderBuffer *rb, int *line, int *col, int *len,
   return 1;
 }
 
-static void cont_cell(RBCell *cell, int startcol)
+static void cont_cell(TickitRenderBuffer *rb, RBCell *cell, int startcol)
 {
   switch(cell->state) {
     case TEXT:
     case ERASE:
     case LINE:
     case CHAR:
-      tickit_pen_destroy(cell->pen);
+      pen_unref(rb, cell->pen);
       break;
     case SKIP:
     case CONT:
@@ -149,7 +304,7 @@ static void cont_cell(RBCell *cell, int startcol)
   cell->state     = CONT;
   cell->maskdepth = -1;
   cell->len       = startcol;
-  cell->pen       = NULL;
+  cell->pen       = -1;
 }
 
 static RBCell *make_span(TickitRenderBuffer *rb, int line, int col, int len)
@@ -157,6 +312,9 @@ static RBCell *make_span(TickitRenderBuffer *rb, int line, int col, int len)
   int end = col + len;
   RBCell **cells = rb->cells;
 
+  rb->dirty[line] = 1;
+  rb->stats.spans++;
+
   // If the following cell is a CONT, it needs to become a new start
   if(end < rb->cols && cells[line][end].state == CONT) {
     int spanstart = cells[line][end].len;
@@ -173,14 +331,18 @@ static RBCell *make_span(TickitRenderBuffer *rb, int line, int col, int len)
       case TEXT:
         endcell->state       = TEXT;
         endcell->len         = afterlen;
-        endcell->pen         = tickit_pen_clone(spancell->pen);
-        endcell->v.text.idx  = spancell->v.text.idx;
-        endcell->v.text.offs = spancell->v.text.offs + end - spanstart;
+        endcell->pen         = pen_ref(rb, spancell->pen);
+        {
+          TickitStringPos pos = text_offset(rb, spancell, end - spanstart);
+          endcell->v.text.start = spancell->v.text.start + pos.bytes;
+          endcell->v.text.bytes = spancell->v.text.bytes - pos.bytes;
+          endcell->v.text.lead  = spancell->v.text.lead + end - spanstart - pos.columns;
+        }
         break;
       case ERASE:
         endcell->state = ERASE;
         endcell->len   = afterlen;
-        endcell->pen   = tickit_pen_clone(spancell->pen);
+        endcell->pen   = pen_ref(rb, spancell->pen);
         break;
       case LINE:
       case CHAR:
@@ -200,8 +362,10 @@ static RBCell *make_span(TickitRenderBuffer *rb, int line, int col, int len)
     int beforelen = col - beforestart;
 
     switch(spancell->state) {
-      case SKIP:
       case TEXT:
+        spancell->v.text.bytes = text_offset(rb, spancell, beforelen).bytes;
+        /* fallthrough */
+      case SKIP:
       case ERASE:
         spancell->len = beforelen;
         break;
@@ -212,21 +376,27 @@ static RBCell *make_span(TickitRenderBuffer *rb, int line, int col, int len)
     }
   }
 
-  // cont_cell() also frees any pens in the range
+  // cont_cell() also releases any pens in the range
   for(int c = col; c < end; c++)
-    cont_cell(&cells[line][c], col);
+    cont_cell(rb, &cells[line][c], col);
 
   cells[line][col].len = len;
 
   return &cells[line][col];
 }
 
-static TickitPen *merge_pen(TickitRenderBuffer *rb, TickitPen *direct_pen)
+// Returns a new reference on the interned result of merging the pens
+static int merge_pen(TickitRenderBuffer *rb, TickitPen *direct_pen)
 {
-  TickitPen *pen = tickit_pen_new();
+  rb->stats.pen_merges++;
 
-  // TODO: When libtickit itself can refcount pens, we can make this more
-  //   efficient in non-merge cases
+  if(rb->pen && !direct_pen)
+    return pen_intern(rb, rb->pen);
+  if(direct_pen && !rb->pen)
+    return pen_intern(rb, direct_pen);
+
+  TickitPen *pen = rb->mergepen;
+  tickit_pen_clear(pen);
 
   if(rb->pen)
     tickit_pen_copy(pen, rb->pen, 1);
@@ -234,7 +404,7 @@ static TickitPen *merge_pen(TickitRenderBuffer *rb, TickitPen *direct_pen)
   if(direct_pen)
     tickit_pen_copy(pen, direct_pen, 1);
 
-  return pen;
+  return pen_intern(rb, pen);
 }
 
 static void tmp_cat_utf8(TickitRenderBuffer *rb, long codepoint)
@@ -251,28 +421,106 @@ static void tmp_cat_utf8(TickitRenderBuffer *rb, long codepoint)
   /* rb->tmp remains NOT nul-terminated */
 }
 
-TickitRenderBuffer *tickit_renderbuffer_new(int lines, int cols)
+static void front_forget(TickitRenderBuffer *rb, RBFrontCell *fc)
 {
-  TickitRenderBuffer *rb = malloc(sizeof(TickitRenderBuffer));
+  if(fc->state == FRONT_ERASE || fc->state == FRONT_GLYPH)
+    pen_unref(rb, fc->pen);
+
+  fc->state = FRONT_UNKNOWN;
+}
+
+static int front_matches(RBFrontCell *fc, enum RBFrontState state, const char *text, size_t bytes, int pen)
+{
+  if(fc->state != state || fc->pen != pen)
+    return 0;
+
+  if(state == FRONT_GLYPH)
+    return fc->bytes == bytes && memcmp(fc->text, text, bytes) == 0;
+
+  return 1;
+}
+
+static void front_set(TickitRenderBuffer *rb, RBFrontCell *row, int col, int width,
+    enum RBFrontState state, const char *text, size_t bytes, int pen)
+{
+  if(!width)
+    return;
+
+  // Overwriting either half of a wide glyph leaves the other half unknown
+  if(row[col].state == FRONT_CONT && col > 0)
+    front_forget(rb, &row[col-1]);
+
+  int end = col + width;
+  if(end > rb->cols)
+    end = rb->cols;
+  if(end < rb->cols && row[end].state == FRONT_CONT)
+    front_forget(rb, &row[end]);
+
+  RBFrontCell *fc = &row[col];
+  front_forget(rb, fc);
+
+  // Glyphs too long to remember are just left unknown
+  if(state != FRONT_GLYPH || bytes <= FRONT_TEXTSIZE) {
+    fc->state = state;
+    fc->pen   = pen_ref(rb, pen);
+    if(state == FRONT_GLYPH) {
+      fc->bytes = bytes;
+      memcpy(fc->text, text, bytes);
+    }
+  }
+
+  for(int c = col + 1; c < end; c++) {
+    front_forget(rb, &row[c]);
+    row[c].state = FRONT_CONT;
+  }
+}
+
+// (Re)lays out the cell grid for the given size, keeping the existing
+// allocation if it is already big enough. All cells are left blank
+static void alloc_cells(TickitRenderBuffer *rb, int lines, int cols)
+{
+  size_t ncells = (size_t)lines * cols;
+  if(!rb->cellbuf || ncells > rb->size_cells) {
+    rb->size_cells = ncells ? ncells : 1;
+    free(rb->cellbuf);
+    rb->cellbuf = malloc(rb->size_cells * sizeof(RBCell));
+  }
+
+  if(!rb->cells || lines > rb->lines) {
+    rb->cells = realloc(rb->cells, (lines ? lines : 1) * sizeof(RBCell *));
+    rb->dirty = realloc(rb->dirty, lines ? lines : 1);
+  }
 
   rb->lines = lines;
   rb->cols  = cols;
 
-  rb->cells = malloc(rb->lines * sizeof(RBCell *));
   for(int line = 0; line < rb->lines; line++) {
-    rb->cells[line] = malloc(rb->cols * sizeof(RBCell));
+    rb->cells[line] = rb->cellbuf + (size_t)line * cols;
+    rb->dirty[line] = 0;
 
     rb->cells[line][0].state     = SKIP;
     rb->cells[line][0].maskdepth = -1;
     rb->cells[line][0].len       = rb->cols;
-    rb->cells[line][0].pen       = NULL;
+    rb->cells[line][0].pen       = -1;
 
     for(int col = 1; col < rb->cols; col++) {
       rb->cells[line][col].state     = CONT;
       rb->cells[line][col].maskdepth = -1;
       rb->cells[line][col].len       = 0;
+      rb->cells[line][col].pen       = -1;
     }
   }
+}
+
+TickitRenderBuffer *tickit_renderbuffer_new(int lines, int cols)
+{
+  TickitRenderBuffer *rb = malloc(sizeof(TickitRenderBuffer));
+
+  rb->lines = 0;
+  rb->cells = NULL;
+  rb->cellbuf = NULL;
+  rb->dirty = NULL;
+  alloc_cells(rb, lines, cols);
 
   rb->vc_pos_set = 0;
 
@@ -286,39 +534,42 @@ TickitRenderBuffer *tickit_renderbuffer_new(int lines, int cols)
   rb->stack = NULL;
   rb->depth = 0;
 
-  rb->n_texts = 0;
-  rb->size_texts = 4;
-  rb->texts = malloc(rb->size_texts * sizeof(char *));
+  rb->textlen = 0;
+  rb->textsize = TEXTARENA_MIN;
+  rb->textarena = malloc(rb->textsize);
 
   rb->tmpsize = 256; // hopefully enough but will grow if required
   rb->tmp = malloc(rb->tmpsize);
   rb->tmplen = 0;
 
+  rb->n_pens = 0;
+  rb->size_pens = 16;
+  rb->pens = malloc(rb->size_pens * sizeof(RBPen));
+  rb->free_pens = -1;
+  for(int i = 0; i < PEN_BUCKETS; i++)
+    rb->pen_buckets[i] = -1;
+  rb->mergepen = tickit_pen_new();
+
+  rb->front = NULL;
+  rb->linehash = NULL;
+
+  memset(&rb->stats, 0, sizeof(rb->stats));
+
+  rb->tiledpool = NULL;
+
   return rb;
 }
 
 void tickit_renderbuffer_destroy(TickitRenderBuffer *rb)
 {
-  for(int line = 0; line < rb->lines; line++) {
-    for(int col = 0; col < rb->cols; col++) {
-      RBCell *cell = &rb->cells[line][col];
-      switch(cell->state) {
-        case TEXT:
-        case ERASE:
-        case LINE:
-        case CHAR:
-          tickit_pen_destroy(cell->pen);
-          break;
-        case SKIP:
-        case CONT:
-          break;
-      }
-    }
-    free(rb->cells[line]);
-  }
+  tickit_renderbuffer_set_retained(rb, 0);
 
   free(rb->cells);
   rb->cells = NULL;
+  free(rb->cellbuf);
+  rb->cellbuf = NULL;
+  free(rb->dirty);
+  rb->dirty = NULL;
 
   if(rb->pen)
     tickit_pen_destroy(rb->pen);
@@ -326,14 +577,116 @@ void tickit_renderbuffer_destroy(TickitRenderBuffer *rb)
   if(rb->stack)
     free_stack(rb->stack);
 
-  free_texts(rb);
-  free(rb->texts);
+  free(rb->textarena);
 
   free(rb->tmp);
 
+  // Any pens still referenced by cells
+  for(int i = 0; i < rb->n_pens; i++)
+    if(rb->pens[i].pen)
+      tickit_pen_destroy(rb->pens[i].pen);
+  free(rb->pens);
+
+  tickit_pen_destroy(rb->mergepen);
+
+  if(rb->tiledpool)
+    tickit_tiledpool_destroy(rb->tiledpool);
+
   free(rb);
 }
 
+struct TickitTiledPool **tickit_renderbuffer_tiledpool(TickitRenderBuffer *rb)
+{
+  return &rb->tiledpool;
+}
+
+void tickit_renderbuffer_set_retained(TickitRenderBuffer *rb, int retained)
+{
+  if(!retained == !rb->front)
+    return;
+
+  if(retained) {
+    rb->front = calloc(rb->lines * rb->cols, sizeof(RBFrontCell)); // all FRONT_UNKNOWN
+    rb->linehash = malloc(2 * rb->lines * sizeof(unsigned int));
+  }
+  else {
+    tickit_renderbuffer_invalidate(rb);
+
+    free(rb->front);
+    rb->front = NULL;
+    free(rb->linehash);
+    rb->linehash = NULL;
+  }
+}
+
+int tickit_renderbuffer_is_retained(const TickitRenderBuffer *rb)
+{
+  return rb->front != NULL;
+}
+
+void tickit_renderbuffer_invalidate(TickitRenderBuffer *rb)
+{
+  if(!rb->front)
+    return;
+
+  for(int i = 0; i < rb->lines * rb->cols; i++)
+    front_forget(rb, &rb->front[i]);
+}
+
+void tickit_renderbuffer_invalidaterect(TickitRenderBuffer *rb, TickitRect *rect)
+{
+  if(!rb->front)
+    return;
+
+  TickitRect all, r;
+  tickit_rect_init_sized(&all, 0, 0, rb->lines, rb->cols);
+  if(!tickit_rect_intersect(&r, &all, rect))
+    return;
+
+  for(int line = r.top; line < tickit_rect_bottom(&r); line++) {
+    RBFrontCell *row = rb->front + line * rb->cols;
+    int left  = r.left;
+    int right = tickit_rect_right(&r);
+
+    // Don't leave half of a wide glyph behind on either edge
+    if(row[left].state == FRONT_CONT && left > 0)
+      front_forget(rb, &row[left-1]);
+    if(right < rb->cols && row[right].state == FRONT_CONT)
+      front_forget(rb, &row[right]);
+
+    for(int col = left; col < right; col++)
+      front_forget(rb, &row[col]);
+  }
+}
+
+void tickit_renderbuffer_resize(TickitRenderBuffer *rb, int lines, int cols)
+{
+  // Releases the pens held by the old cells
+  tickit_renderbuffer_reset(rb);
+
+  if(lines == rb->lines && cols == rb->cols)
+    return;
+
+  // The terminal's old contents mean nothing at the new size
+  if(rb->front) {
+    tickit_renderbuffer_invalidate(rb);
+
+    free(rb->front);
+    rb->front = calloc(lines * cols, sizeof(RBFrontCell)); // all FRONT_UNKNOWN
+    free(rb->linehash);
+    rb->linehash = malloc(2 * lines * sizeof(unsigned int));
+  }
+
+  alloc_cells(rb, lines, cols);
+
+  tickit_rect_init_sized(&rb->clip, 0, 0, rb->lines, rb->cols);
+}
+
+void tickit_renderbuffer_get_stats(const TickitRenderBuffer *rb, TickitRenderBufferStats *stats)
+{
+  *stats = rb->stats;
+}
+
 void tickit_renderbuffer_get_size(const TickitRenderBuffer *rb, int *lines, int *cols)
 {
   if(lines)
@@ -384,6 +737,7 @@ void tickit_renderbuffer_mask(TickitRenderBuffer *rb, TickitRect *mask)
       if(cell->maskdepth == -1)
         cell->maskdepth = rb->depth;
     }
+    rb->dirty[line] = 1;
   }
 }
 
@@ -440,9 +794,14 @@ void tickit_renderbuffer_setpen(TickitRenderBuffer *rb, TickitPen *pen)
 void tickit_renderbuffer_reset(TickitRenderBuffer *rb)
 {
   for(int line = 0; line < rb->lines; line++) {
-    // cont_cell also frees pen
+    // Untouched lines are still blank
+    if(!rb->dirty[line])
+      continue;
+    rb->dirty[line] = 0;
+
+    // cont_cell also releases pen
     for(int col = 0; col < rb->cols; col++)
-      cont_cell(&rb->cells[line][col], 0);
+      cont_cell(rb, &rb->cells[line][col], 0);
 
     rb->cells[line][0].state     = SKIP;
     rb->cells[line][0].maskdepth = -1;
@@ -467,7 +826,7 @@ void tickit_renderbuffer_reset(TickitRenderBuffer *rb)
     rb->depth = 0;
   }
 
-  free_texts(rb);
+  reset_texts(rb);
 }
 
 void tickit_renderbuffer_clear(TickitRenderBuffer *rb, TickitPen *pen)
@@ -532,10 +891,13 @@ void tickit_renderbuffer_restore(TickitRenderBuffer *rb)
   rb->depth--;
 
   // TODO: this could be done more efficiently by remembering the edges of masking
-  for(int line = 0; line < rb->lines; line++)
+  for(int line = 0; line < rb->lines; line++) {
+    if(!rb->dirty[line])
+      continue;
     for(int col = 0; col < rb->cols; col++)
       if(rb->cells[line][col].maskdepth > rb->depth)
         rb->cells[line][col].maskdepth = -1;
+  }
 
   free(stack);
 }
@@ -590,28 +952,26 @@ void tickit_renderbuffer_skip_to(TickitRenderBuffer *rb, int col)
   rb->vc_col = col;
 }
 
-int tickit_renderbuffer_text_at(TickitRenderBuffer *rb, int line, int col, char *text, TickitPen *pen)
+// Draws len columns of the text, starting skip columns into it, at the given
+// position. *cellpen caches the interned merge of pen; if this sets it, the
+// caller must release that reference
+static void put_text(TickitRenderBuffer *rb, int line, int col, const char *text, size_t bytes,
+    int skip, int len, int *cellpen, TickitPen *pen)
 {
-
-  TickitStringPos endpos;
-  tickit_string_count(text, &endpos, NULL);
-
-  int len = endpos.columns;
-  int ret = len;
-
   int startcol;
   if(!xlate_and_clip(rb, &line, &col, &len, &startcol))
-    return ret;
-
-  if(rb->n_texts == rb->size_texts) {
-    rb->size_texts *= 2;
-    rb->texts = realloc(rb->texts, rb->size_texts * sizeof(char *));
-  }
+    return;
 
-  rb->texts[rb->n_texts] = strdup(text);
+  startcol += skip;
 
   RBCell *linecells = rb->cells[line];
 
+  // Only the bytes of the unclipped, unmasked columns are kept
+  TickitStringPos pos, limit;
+  tickit_stringpos_zero(&pos);
+  tickit_stringpos_limit_none(&limit);
+  size_t firstbyte = -1;
+
   while(len) {
     while(len && linecells[col].maskdepth > -1) {
       col++;
@@ -629,33 +989,106 @@ int tickit_renderbuffer_text_at(TickitRenderBuffer *rb, int line, int col, char
     if(!spanlen)
       break;
 
+    if(*cellpen == -1)
+      *cellpen = merge_pen(rb, pen);
+
     RBCell *cell = make_span(rb, line, col, spanlen);
     cell->state       = TEXT;
-    cell->pen         = merge_pen(rb, pen);
-    cell->v.text.idx  = rb->n_texts;
-    cell->v.text.offs = startcol;
+    cell->pen         = pen_ref(rb, *cellpen);
+
+    limit.columns = startcol;
+    tickit_string_ncountmore(text, bytes, &pos, &limit);
+    if(firstbyte == -1)
+      firstbyte = pos.bytes;
+
+    TickitStringPos end = pos;
+    limit.columns = startcol + spanlen;
+    tickit_string_ncountmore(text, bytes, &end, &limit);
+
+    cell->v.text.start = rb->textlen + pos.bytes - firstbyte;
+    cell->v.text.bytes = end.bytes - pos.bytes;
+    cell->v.text.lead  = startcol - pos.columns;
+
+    pos = end;
 
     col      += spanlen;
     startcol += spanlen;
   }
 
-  rb->n_texts++;
+  if(firstbyte != -1) {
+    size_t keep = pos.bytes - firstbyte;
+    if(rb->textlen + keep > rb->textsize) {
+      while(rb->textlen + keep > rb->textsize)
+        rb->textsize *= 2;
+      rb->textarena = realloc(rb->textarena, rb->textsize);
+    }
 
-  return ret;
+    memcpy(rb->textarena + rb->textlen, text + firstbyte, keep);
+    rb->textlen += keep;
+    rb->stats.text_bytes += keep;
+  }
 }
 
-int tickit_renderbuffer_text(TickitRenderBuffer *rb, char *text, TickitPen *pen)
+int tickit_renderbuffer_textn_at(TickitRenderBuffer *rb, int line, int col, const char *text, size_t len, TickitPen *pen)
+{
+  TickitStringPos endpos;
+  tickit_string_ncount(text, len, &endpos, NULL);
+
+  int cellpen = -1;
+  put_text(rb, line, col, text, endpos.bytes, 0, endpos.columns, &cellpen, pen);
+  if(cellpen != -1)
+    pen_unref(rb, cellpen);
+
+  return endpos.columns;
+}
+
+int tickit_renderbuffer_textn_at_clipped(TickitRenderBuffer *rb, int line, int col, const char *text, size_t len, TickitPen *pen)
+{
+  const TickitRect *clip = &rb->clip;
+
+  int bufline = line + rb->xlate_line;
+  int edge = tickit_rect_right(clip) - (col + rb->xlate_col);
+
+  if(!clip->lines || bufline < clip->top || bufline >= tickit_rect_bottom(clip) || edge <= 0)
+    return 0;
+
+  // Measure one column past the edge, so a wide character straddling it is
+  // clipped just as it would be if the whole text were given
+  TickitStringPos endpos, limit;
+  tickit_stringpos_limit_columns(&limit, edge + 1);
+  tickit_string_ncount(text, len, &endpos, &limit);
+
+  int cellpen = -1;
+  put_text(rb, line, col, text, endpos.bytes, 0, endpos.columns, &cellpen, pen);
+  if(cellpen != -1)
+    pen_unref(rb, cellpen);
+
+  return endpos.columns < edge ? endpos.columns : edge;
+}
+
+int tickit_renderbuffer_text_at(TickitRenderBuffer *rb, int line, int col, char *text, TickitPen *pen)
+{
+  return tickit_renderbuffer_textn_at(rb, line, col, text, strlen(text), pen);
+}
+
+int tickit_renderbuffer_textn(TickitRenderBuffer *rb, const char *text, size_t len, TickitPen *pen)
 {
   if(!rb->vc_pos_set)
     return -1;
 
-  int len = tickit_renderbuffer_text_at(rb, rb->vc_line, rb->vc_col, text, pen);
-  rb->vc_col += len;
+  int cols = tickit_renderbuffer_textn_at(rb, rb->vc_line, rb->vc_col, text, len, pen);
+  rb->vc_col += cols;
 
-  return len;
+  return cols;
 }
 
-void tickit_renderbuffer_erase_at(TickitRenderBuffer *rb, int line, int col, int len, TickitPen *pen)
+int tickit_renderbuffer_text(TickitRenderBuffer *rb, char *text, TickitPen *pen)
+{
+  return tickit_renderbuffer_textn(rb, text, strlen(text), pen);
+}
+
+// As put_text(), for erasing
+static void put_erase(TickitRenderBuffer *rb, int line, int col, int len, int *cellpen, TickitPen *pen)
 {
   if(!xlate_and_clip(rb, &line, &col, &len, NULL))
     return;
@@ -678,14 +1111,25 @@ void tickit_renderbuffer_erase_at(TickitRenderBuffer *rb, int line, int col, int
     if(!spanlen)
       break;
 
+    if(*cellpen == -1)
+      *cellpen = merge_pen(rb, pen);
+
     RBCell *cell = make_span(rb, line, col, spanlen);
     cell->state = ERASE;
-    cell->pen   = merge_pen(rb, pen);
+    cell->pen   = pen_ref(rb, *cellpen);
 
     col += spanlen;
   }
 }
 
+void tickit_renderbuffer_erase_at(TickitRenderBuffer *rb, int line, int col, int len, TickitPen *pen)
+{
+  int cellpen = -1;
+  put_erase(rb, line, col, len, &cellpen, pen);
+  if(cellpen != -1)
+    pen_unref(rb, cellpen);
+}
+
 void tickit_renderbuffer_erase(TickitRenderBuffer *rb, int len, TickitPen *pen)
 {
   if(!rb->vc_pos_set)
@@ -738,7 +1182,7 @@ void tickit_renderbuffer_char(TickitRenderBuffer *rb, long codepoint, TickitPen
   rb->vc_col += 1;
 }
 
-static void linecell(TickitRenderBuffer *rb, int line, int col, int bits, TickitPen *pen)
+static void linecell(TickitRenderBuffer *rb, int line, int col, int bits, int pen)
 {
   int len = 1;
 
@@ -748,22 +1192,18 @@ static void linecell(TickitRenderBuffer *rb, int line, int col, int bits, Tickit
   if(rb->cells[line][col].maskdepth > -1)
     return;
 
-  TickitPen *cellpen = merge_pen(rb, pen);
-
   RBCell *cell = &rb->cells[line][col];
   if(cell->state != LINE) {
     make_span(rb, line, col, len);
     cell->state       = LINE;
     cell->len         = 1;
-    cell->pen         = cellpen;
+    cell->pen         = pen_ref(rb, pen);
     cell->v.line.mask = 0;
   }
-  else if(!tickit_pen_equiv(cell->pen, cellpen)) {
-    tickit_pen_destroy(cell->pen);
-    cell->pen   = cellpen;
+  else if(cell->pen != pen) {
+    pen_unref(rb, cell->pen);
+    cell->pen   = pen_ref(rb, pen);
   }
-  else
-    tickit_pen_destroy(cellpen);
 
   cell->v.line.mask |= bits;
 }
@@ -774,12 +1214,14 @@ void tickit_renderbuffer_hline_at(TickitRenderBuffer *rb, int line, int startcol
   int east = style << EAST_SHIFT;
   int west = style << WEST_SHIFT;
 
-  pen = merge_pen(rb, pen);
+  int cellpen = merge_pen(rb, pen);
 
-  linecell(rb, line, startcol, east | (caps & TICKIT_LINECAP_START ? west : 0), pen);
+  linecell(rb, line, startcol, east | (caps & TICKIT_LINECAP_START ? west : 0), cellpen);
   for(int col = startcol + 1; col <= endcol - 1; col++)
-    linecell(rb, line, col, east | west, pen);
-  linecell(rb, line, endcol, (caps & TICKIT_LINECAP_END ? east : 0) | west, pen);
+    linecell(rb, line, col, east | west, cellpen);
+  linecell(rb, line, endcol, (caps & TICKIT_LINECAP_END ? east : 0) | west, cellpen);
+
+  pen_unref(rb, cellpen);
 }
 
 void tickit_renderbuffer_vline_at(TickitRenderBuffer *rb, int startline, int endline, int col,
@@ -788,16 +1230,549 @@ void tickit_renderbuffer_vline_at(TickitRenderBuffer *rb, int startline, int end
   int north = style << NORTH_SHIFT;
   int south = style << SOUTH_SHIFT;
 
-  pen = merge_pen(rb, pen);
+  int cellpen = merge_pen(rb, pen);
 
-  linecell(rb, startline, col, south | (caps & TICKIT_LINECAP_START ? north : 0), pen);
+  linecell(rb, startline, col, south | (caps & TICKIT_LINECAP_START ? north : 0), cellpen);
   for(int line = startline + 1; line <= endline - 1; line++)
-    linecell(rb, line, col, south | north, pen);
-  linecell(rb, endline, col, (caps & TICKIT_LINECAP_END ? south : 0) | north, pen);
+    linecell(rb, line, col, south | north, cellpen);
+  linecell(rb, endline, col, (caps & TICKIT_LINECAP_END ? south : 0) | north, cellpen);
+
+  pen_unref(rb, cellpen);
 }
 
-void tickit_renderbuffer_flush_to_term(TickitRenderBuffer *rb, TickitTerm *tt)
+void tickit_renderbuffer_blit(TickitRenderBuffer *dst, TickitRenderBuffer *src, const TickitRect *src_rect,
+    int dst_line, int dst_col)
+{
+  TickitRect all, r;
+  tickit_rect_init_sized(&all, 0, 0, src->lines, src->cols);
+  if(!tickit_rect_intersect(&r, &all, src_rect))
+    return;
+
+  // Each of src's pens is merged with dst's state pen and interned just once
+  int *penmap = malloc((src->n_pens ? src->n_pens : 1) * sizeof(int));
+  for(int i = 0; i < src->n_pens; i++)
+    penmap[i] = -1;
+
+  for(int line = r.top; line < tickit_rect_bottom(&r); line++) {
+    int dline = dst_line + line - src_rect->top;
+    int right = tickit_rect_right(&r);
+
+    for(int col = r.left; col < right; /**/) {
+      const RBCell *span = &src->cells[line][col];
+      int spanstart = col;
+      if(span->state == CONT) {
+        spanstart = span->len;
+        span = &src->cells[line][spanstart];
+      }
+
+      int offset = col - spanstart;
+      int len = span->len - offset;
+      if(len > right - col)
+        len = right - col;
+
+      int dcol = dst_col + col - src_rect->left;
+      int *cellpen = span->state == SKIP ? NULL : &penmap[span->pen];
+      TickitPen *pen = cellpen ? src->pens[span->pen].pen : NULL;
+
+      switch(span->state) {
+        case SKIP:
+          break;
+        case TEXT:
+          put_text(dst, dline, dcol, cell_text(src, span), span->v.text.bytes,
+              span->v.text.lead + offset, len, cellpen, pen);
+          break;
+        case ERASE:
+          put_erase(dst, dline, dcol, len, cellpen, pen);
+          break;
+        case CHAR:
+          {
+            int l = dline, c = dcol, n = 1;
+            if(!xlate_and_clip(dst, &l, &c, &n, NULL) || dst->cells[l][c].maskdepth > -1)
+              break;
+
+            if(*cellpen == -1)
+              *cellpen = merge_pen(dst, pen);
+
+            RBCell *cell = make_span(dst, l, c, 1);
+            cell->state           = CHAR;
+            cell->pen             = pen_ref(dst, *cellpen);
+            cell->v.chr.codepoint = span->v.chr.codepoint;
+          }
+          break;
+        case LINE:
+          if(*cellpen == -1)
+            *cellpen = merge_pen(dst, pen);
+          linecell(dst, dline, dcol, span->v.line.mask, *cellpen);
+          break;
+        case CONT:
+          abort();
+      }
+
+      col += len;
+    }
+  }
+
+  for(int i = 0; i < src->n_pens; i++)
+    if(penmap[i] != -1)
+      pen_unref(dst, penmap[i]);
+  free(penmap);
+}
+
+// A run of changed cells waiting to be sent to the terminal in retained mode
+// Unchanged glyphs shorter than this many bytes are cheaper to print again
+// than any cursor motion to skip over them
+#define FRONT_REPRINT_BYTES 4
+
+struct FrontRun {
+  int active;
+  int col, cols;
+  int pen;
+  enum { RUN_TEXT, RUN_TMP, RUN_ERASE } kind;
+  const char *text; // kind == RUN_TEXT
+  size_t bytes;
+  // Trailing unchanged glyphs, only printed if more changes follow
+  int gapcols;
+  size_t gapbytes;
+};
+
+static void front_run_flush(TickitRenderBuffer *rb, TickitTerm *tt, int line, struct FrontRun *run, int *phycol)
+{
+  if(!run->active)
+    return;
+  run->active = 0;
+
+  run->cols  -= run->gapcols;
+  run->bytes -= run->gapbytes;
+
+  rb->stats.cells_flushed += run->cols;
+
+  if(*phycol != run->col)
+    tickit_term_goto(tt, line, run->col);
+
+  tickit_term_setpen(tt, rb->pens[run->pen].pen);
+
+  switch(run->kind) {
+    case RUN_TEXT:
+      tickit_term_printn(tt, run->text, run->bytes);
+      *phycol = run->col + run->cols;
+      break;
+    case RUN_TMP:
+      tickit_term_printn(tt, rb->tmp, rb->tmplen);
+      rb->tmplen = 0;
+      *phycol = run->col + run->cols;
+      break;
+    case RUN_ERASE:
+      {
+        int end = run->col + run->cols;
+        int moveend = end < rb->cols && rb->cells[line][end].state != SKIP;
+
+        tickit_term_erasech(tt, run->cols, moveend ? 1 : -1);
+        *phycol = moveend ? end : -1;
+      }
+      break;
+  }
+}
+
+static void front_run_add(TickitRenderBuffer *rb, TickitTerm *tt, int line, struct FrontRun *run, int *phycol,
+    int kind, int col, int cols, int pen, const char *text, size_t bytes)
+{
+  if(run->active && run->kind == kind && run->col + run->cols == col && run->pen == pen &&
+      (kind != RUN_TEXT || run->text + run->bytes == text)) {
+    run->cols  += cols;
+    run->bytes += bytes;
+    run->gapcols  = 0;
+    run->gapbytes = 0;
+  }
+  else {
+    front_run_flush(rb, tt, line, run, phycol);
+
+    run->active = 1;
+    run->kind   = kind;
+    run->col    = col;
+    run->cols   = cols;
+    run->pen    = pen;
+    run->text   = text;
+    run->bytes  = bytes;
+    run->gapcols  = 0;
+    run->gapbytes = 0;
+  }
+}
+
+// An unchanged glyph; either tentatively bridge it within the current text
+// run, or end the run
+static void front_run_skip(TickitRenderBuffer *rb, TickitTerm *tt, int line, struct FrontRun *run, int *phycol,
+    int col, int cols, int pen, const char *text, size_t bytes)
+{
+  if(run->active && run->kind == RUN_TEXT && run->col + run->cols == col && run->pen == pen &&
+      run->text + run->bytes == text && run->gapbytes + bytes < FRONT_REPRINT_BYTES) {
+    run->cols  += cols;
+    run->bytes += bytes;
+    run->gapcols  += cols;
+    run->gapbytes += bytes;
+  }
+  else
+    front_run_flush(rb, tt, line, run, phycol);
+}
+
+static void flush_line_retained(TickitRenderBuffer *rb, TickitTerm *tt, int line)
+{
+  RBFrontCell *row = rb->front + line * rb->cols;
+  struct FrontRun run = { .active = 0 };
+  int phycol = -1;
+
+  for(int col = 0; col < rb->cols; /**/) {
+    RBCell *cell = &rb->cells[line][col];
+
+    switch(cell->state) {
+      case SKIP:
+        front_run_flush(rb, tt, line, &run, &phycol);
+        break;
+      case TEXT:
+        {
+          TickitStringPos pos, next, limit;
+          const char *text = cell_text(rb, cell);
+          size_t textbytes = cell->v.text.bytes;
+          int pen = cell->pen;
+
+          tickit_stringpos_zero(&pos);
+          tickit_stringpos_limit_columns(&limit, cell->v.text.lead + cell->len);
+
+          int c = col;
+          while(c < col + cell->len) {
+            limit.graphemes = pos.graphemes + 1;
+            next = pos;
+            tickit_string_ncountmore(text, textbytes, &next, &limit);
+            if(next.bytes == pos.bytes)
+              break;
+
+            int width = next.columns - pos.columns;
+            const char *glyph = text + pos.bytes;
+            size_t bytes = next.bytes - pos.bytes;
+
+            if(width && front_matches(&row[c], FRONT_GLYPH, glyph, bytes, pen))
+              front_run_skip(rb, tt, line, &run, &phycol, c, width, pen, glyph, bytes);
+            else {
+              front_run_add(rb, tt, line, &run, &phycol, RUN_TEXT, c, width, pen, glyph, bytes);
+              front_set(rb, row, c, width, FRONT_GLYPH, glyph, bytes, pen);
+            }
+
+            c += width;
+            pos = next;
+          }
+
+          // Any columns not accounted for (e.g. half of a clipped wide glyph)
+          // are left in an unknown state
+          if(c < col + cell->len) {
+            front_run_flush(rb, tt, line, &run, &phycol);
+            for(; c < col + cell->len; c++)
+              front_forget(rb, &row[c]);
+          }
+        }
+        break;
+      case ERASE:
+        {
+          int pen = cell->pen;
+
+          for(int c = col; c < col + cell->len; c++) {
+            if(front_matches(&row[c], FRONT_ERASE, NULL, 0, pen)) {
+              front_run_flush(rb, tt, line, &run, &phycol);
+              continue;
+            }
+
+            front_run_add(rb, tt, line, &run, &phycol, RUN_ERASE, c, 1, pen, NULL, 0);
+            front_set(rb, row, c, 1, FRONT_ERASE, NULL, 0, pen);
+          }
+        }
+        break;
+      case LINE:
+      case CHAR:
+        {
+          long codepoint = cell->state == LINE ? linemask_to_char[cell->v.line.mask]
+                                               : cell->v.chr.codepoint;
+          char glyph[8];
+          size_t bytes = tickit_string_putchar(glyph, sizeof(glyph), codepoint);
+          int pen = cell->pen;
+
+          if(front_matches(&row[col], FRONT_GLYPH, glyph, bytes, pen)) {
+            front_run_flush(rb, tt, line, &run, &phycol);
+            break;
+          }
+
+          // Flush first if this run can't continue, so the tmp buffer only
+          // ever holds the current run
+          if(run.active && !(run.kind == RUN_TMP && run.col + run.cols == col && run.pen == pen))
+            front_run_flush(rb, tt, line, &run, &phycol);
+
+          tmp_cat_utf8(rb, codepoint);
+
+          front_run_add(rb, tt, line, &run, &phycol, RUN_TMP, col, 1, pen, NULL, bytes);
+          front_set(rb, row, col, 1, FRONT_GLYPH, glyph, bytes, pen);
+        }
+        break;
+      case CONT:
+        /* unreachable */
+        abort();
+    }
+
+    col += cell->len;
+  }
+
+  front_run_flush(rb, tt, line, &run, &phycol);
+}
+
+/* Scroll detection compares lines by a hash of their content in front buffer
+ * terms; per column the state, pen and glyph. A hash of 0 means the line
+ * cannot be matched. Collisions only cost extra output, as flushing still
+ * compares the actual cells afterwards
+ */
+static inline unsigned int hash_bytes(unsigned int h, const void *p, size_t n)
+{
+  for(const unsigned char *b = p; n; b++, n--)
+    h = (h ^ *b) * 16777619u;
+  return h;
+}
+
+static inline unsigned int hash_int(unsigned int h, int v)
+{
+  return hash_bytes(h, &v, sizeof v);
+}
+
+static inline unsigned int hash_glyph(unsigned int h, int pen, const char *text, size_t bytes)
+{
+  h = hash_int(h, FRONT_GLYPH);
+  h = hash_int(h, pen);
+  h = hash_int(h, bytes);
+  return hash_bytes(h, text, bytes);
+}
+
+static unsigned int hash_front_line(const TickitRenderBuffer *rb, int line)
+{
+  const RBFrontCell *row = rb->front + line * rb->cols;
+  unsigned int h = 2166136261u;
+
+  for(int col = 0; col < rb->cols; col++) {
+    const RBFrontCell *fc = &row[col];
+    switch(fc->state) {
+      case FRONT_UNKNOWN:
+        return 0;
+      case FRONT_ERASE:
+        h = hash_int(hash_int(h, FRONT_ERASE), fc->pen);
+        break;
+      case FRONT_GLYPH:
+        h = hash_glyph(h, fc->pen, fc->text, fc->bytes);
+        break;
+      case FRONT_CONT:
+        h = hash_int(h, FRONT_CONT);
+        break;
+    }
+  }
+
+  return h ? h : 1;
+}
+
+// The hash the front buffer line will have once this line is flushed, if it
+// is fully drawn
+static unsigned int hash_cells_line(const TickitRenderBuffer *rb, int line)
+{
+  unsigned int h = 2166136261u;
+
+  for(int col = 0; col < rb->cols; /**/) {
+    const RBCell *cell = &rb->cells[line][col];
+
+    switch(cell->state) {
+      case SKIP:
+        return 0;
+      case TEXT:
+        {
+          TickitStringPos pos, next, limit;
+          const char *text = cell_text(rb, cell);
+          size_t textbytes = cell->v.text.bytes;
+
+          tickit_stringpos_zero(&pos);
+          tickit_stringpos_limit_columns(&limit, cell->v.text.lead + cell->len);
+
+          int c = col;
+          while(c < col + cell->len) {
+            limit.graphemes = pos.graphemes + 1;
+            next = pos;
+            tickit_string_ncountmore(text, textbytes, &next, &limit);
+
+            int width = next.columns - pos.columns;
+            size_t bytes = next.bytes - pos.bytes;
+            if(!width || bytes > FRONT_TEXTSIZE)
+              return 0;
+
+            h = hash_glyph(h, cell->pen, text + pos.bytes, bytes);
+            for(int i = 1; i < width; i++)
+              h = hash_int(h, FRONT_CONT);
+
+            c += width;
+            pos = next;
+          }
+
+          if(c != col + cell->len)
+            return 0;
+        }
+        break;
+      case ERASE:
+        for(int c = 0; c < cell->len; c++)
+          h = hash_int(hash_int(h, FRONT_ERASE), cell->pen);
+        break;
+      case LINE:
+      case CHAR:
+        {
+          long codepoint = cell->state == LINE ? linemask_to_char[cell->v.line.mask]
+                                               : cell->v.chr.codepoint;
+          char glyph[8];
+          size_t bytes = tickit_string_putchar(glyph, sizeof(glyph), codepoint);
+
+          h = hash_glyph(h, cell->pen, glyph, bytes);
+        }
+        break;
+      case CONT:
+        /* unreachable */
+        abort();
+    }
+
+    col += cell->len;
+  }
+
+  return h ? h : 1;
+}
+
+// Looks for a block of fully drawn lines that the terminal already displays
+// elsewhere, and scrolls it into place rather than drawing it again
+static void front_scroll(TickitRenderBuffer *rb, TickitTerm *tt)
 {
+  int lines = rb->lines, cols = rb->cols;
+  unsigned int *newhash = rb->linehash, *oldhash = rb->linehash + lines;
+
+  int drawn = 0;
+  for(int line = 0; line < lines; line++)
+    if((newhash[line] = hash_cells_line(rb, line)))
+      drawn++;
+  if(drawn < 2)
+    return;
+
+  for(int line = 0; line < lines; line++)
+    oldhash[line] = hash_front_line(rb, line);
+
+  int bestgain = 1, bestdown = 0, besttop = 0, bestbottom = 0;
+
+  for(int down = 1 - lines; down < lines; down++) {
+    if(!down)
+      continue;
+
+    int first = down > 0 ? 0 : -down;
+    int last  = down > 0 ? lines - down : lines;
+
+    for(int top = first; top < last; /**/) {
+      int bottom = top, gain = 0;
+      while(bottom < last && newhash[bottom] && newhash[bottom] == oldhash[bottom + down]) {
+        if(newhash[bottom] != oldhash[bottom])
+          gain++;
+        bottom++;
+      }
+
+      if(gain > bestgain) {
+        // The lines exposed by the scroll must all be redrawn too
+        int exp_top = down > 0 ? bottom : top + down;
+        int exp_bottom = down > 0 ? bottom + down : top;
+        int ok = 1;
+        for(int line = exp_top; ok && line < exp_bottom; line++)
+          ok = newhash[line] != 0;
+
+        if(ok) {
+          bestgain = gain;
+          bestdown = down;
+          besttop = top;
+          bestbottom = bottom;
+        }
+      }
+
+      top = (bottom > top) ? bottom : top + 1;
+    }
+  }
+
+  if(!bestdown)
+    return;
+
+  int regiontop    = bestdown > 0 ? besttop : besttop + bestdown;
+  int regionbottom = bestdown > 0 ? bestbottom + bestdown : bestbottom;
+  int shift = bestdown > 0 ? bestdown : -bestdown;
+
+  if(!tickit_term_scrollrect(tt, regiontop, 0, regionbottom - regiontop, cols, bestdown, 0))
+    return;
+
+  RBFrontCell *top = rb->front + regiontop * cols;
+  size_t movecells = (size_t)(regionbottom - regiontop - shift) * cols;
+  size_t shiftcells = (size_t)shift * cols;
+
+  if(bestdown > 0) {
+    for(size_t i = 0; i < shiftcells; i++)
+      front_forget(rb, &top[i]);
+    memmove(top, top + shiftcells, movecells * sizeof(RBFrontCell));
+    memset(top + movecells, 0, shiftcells * sizeof(RBFrontCell)); // FRONT_UNKNOWN
+  }
+  else {
+    for(size_t i = 0; i < shiftcells; i++)
+      front_forget(rb, &top[movecells + i]);
+    memmove(top + shiftcells, top, movecells * sizeof(RBFrontCell));
+    memset(top, 0, shiftcells * sizeof(RBFrontCell)); // FRONT_UNKNOWN
+  }
+}
+
+/* If the entire terminal is to be erased with one pen, does so with a single
+ * clear, where the driver reports that will use the pen's background
+ */
+static int flush_clear(TickitRenderBuffer *rb, TickitTerm *tt)
+{
+  int lines, cols;
+  tickit_term_get_size(tt, &lines, &cols);
+  if(rb->lines != lines || rb->cols != cols || !lines)
+    return 0;
+
+  int pen = rb->cells[0][0].pen;
+  for(int line = 0; line < lines; line++) {
+    RBCell *cell = &rb->cells[line][0];
+    if(cell->state != ERASE || cell->len != cols || cell->pen != pen)
+      return 0;
+  }
+
+  TickitPen *p = rb->pens[pen].pen;
+  int bce;
+  if(!tickit_term_getctl_int(tt, TICKIT_TERMCTL_BCE, &bce))
+    return 0;
+  if(tickit_pen_get_bool_attr(p, TICKIT_PEN_REVERSE))
+    return 0;
+  if(!bce && tickit_pen_get_colour_attr(p, TICKIT_PEN_BG) != -1)
+    return 0;
+
+  tickit_term_setpen(tt, p);
+  tickit_term_clear(tt);
+  rb->stats.cells_flushed += lines * cols;
+
+  return 1;
+}
+
+/* Sends the content to the terminal, leaving the buffer's own content alone
+ * so it can be sent again. Only the front buffer is updated.
+ */
+static void flush_frame(TickitRenderBuffer *rb, TickitTerm *tt, int allow_scroll)
+{
+  if(rb->front) {
+    if(allow_scroll)
+      front_scroll(rb, tt);
+
+    for(int line = 0; line < rb->lines; line++)
+      flush_line_retained(rb, tt, line);
+
+    return;
+  }
+
+  if(flush_clear(rb, tt))
+    return;
+
   for(int line = 0; line < rb->lines; line++) {
     int phycol = -1; /* column where the terminal cursor physically is */
 
@@ -816,18 +1791,15 @@ void tickit_renderbuffer_flush_to_term(TickitRenderBuffer *rb, TickitTerm *tt)
       switch(cell->state) {
         case TEXT:
           {
-            TickitStringPos start, end, limit;
-            char *text = rb->texts[cell->v.text.idx];
-
-            tickit_stringpos_limit_columns(&limit, cell->v.text.offs);
-            tickit_string_count(text, &start, &limit);
-
-            limit.columns += cell->len;
-            end = start;
-            tickit_string_countmore(text, &end, &limit);
+            // A span holding only part of a wide glyph may have no bytes
+            if(!cell->v.text.bytes) {
+              phycol = -1;
+              break;
+            }
 
-            tickit_term_setpen(tt, cell->pen);
-            tickit_term_printn(tt, text + start.bytes, end.bytes - start.bytes);
+            tickit_term_setpen(tt, rb->pens[cell->pen].pen);
+            tickit_term_printn(tt, cell_text(rb, cell), cell->v.text.bytes);
+            rb->stats.cells_flushed += cell->len;
 
             phycol += cell->len;
           }
@@ -839,8 +1811,9 @@ void tickit_renderbuffer_flush_to_term(TickitRenderBuffer *rb, TickitTerm *tt)
             int moveend = col + cell->len < rb->cols &&
                           rb->cells[line][col + cell->len].state != SKIP;
 
-            tickit_term_setpen(tt, cell->pen);
+            tickit_term_setpen(tt, rb->pens[cell->pen].pen);
             tickit_term_erasech(tt, cell->len, moveend ? 1 : -1);
+            rb->stats.cells_flushed += cell->len;
 
             if(moveend)
               phycol += cell->len;
@@ -850,19 +1823,20 @@ void tickit_renderbuffer_flush_to_term(TickitRenderBuffer *rb, TickitTerm *tt)
           break;
         case LINE:
           {
-            TickitPen *pen = cell->pen;
+            int pen = cell->pen;
 
             do {
               tmp_cat_utf8(rb, linemask_to_char[cell->v.line.mask]);
+              rb->stats.cells_flushed++;
 
               col++;
               phycol += cell->len;
             } while(col < rb->cols &&
                     (cell = &rb->cells[line][col]) &&
                     cell->state == LINE &&
-                    tickit_pen_equiv(cell->pen, pen));
+                    cell->pen == pen);
 
-            tickit_term_setpen(tt, pen);
+            tickit_term_setpen(tt, rb->pens[pen].pen);
             tickit_term_printn(tt, rb->tmp, rb->tmplen);
             rb->tmplen = 0;
           }
@@ -871,9 +1845,10 @@ void tickit_renderbuffer_flush_to_term(TickitRenderBuffer *rb, TickitTerm *tt)
           {
             tmp_cat_utf8(rb, cell->v.chr.codepoint);
 
-            tickit_term_setpen(tt, cell->pen);
+            tickit_term_setpen(tt, rb->pens[cell->pen].pen);
             tickit_term_printn(tt, rb->tmp, rb->tmplen);
             rb->tmplen = 0;
+            rb->stats.cells_flushed += cell->len;
 
             phycol += cell->len;
           }
@@ -887,6 +1862,81 @@ void tickit_renderbuffer_flush_to_term(TickitRenderBuffer *rb, TickitTerm *tt)
       col += cell->len;
     }
   }
+}
+
+void tickit_renderbuffer_flush_to_term(TickitRenderBuffer *rb, TickitTerm *tt)
+{
+  flush_frame(rb, tt, 1);
+  tickit_renderbuffer_reset(rb);
+}
+
+void tickit_renderbuffer_flush_to_terms(TickitRenderBuffer *rb, TickitTerm *terms[], size_t n)
+{
+  // Each terminal is either the leader of a new set, or mirrors an earlier one
+  size_t *leader = malloc(n * sizeof(size_t));
+  size_t n_sets = 0;
+
+  for(size_t i = 0; i < n; i++) {
+    leader[i] = i;
+    for(size_t j = 0; j < i; j++)
+      if(leader[j] == j && tickit_term_output_equiv(terms[j], terms[i])) {
+        leader[i] = j;
+        break;
+      }
+    if(leader[i] == i)
+      n_sets++;
+  }
+
+  /* Every set must be sent the changes from the same previous state, so the
+   * front buffer is saved and put back for each. Scrolling is skipped, as not
+   * every terminal may be able to, and the front buffers must all agree.
+   */
+  RBFrontCell *saved = NULL;
+  size_t n_front = (size_t)rb->lines * rb->cols;
+  if(rb->front && n_sets > 1) {
+    saved = malloc(n_front * sizeof(RBFrontCell));
+    memcpy(saved, rb->front, n_front * sizeof(RBFrontCell));
+    for(size_t i = 0; i < n_front; i++)
+      if(saved[i].state == FRONT_ERASE || saved[i].state == FRONT_GLYPH)
+        pen_ref(rb, saved[i].pen);
+  }
+
+  TickitTerm **mirrors = malloc(n * sizeof(TickitTerm *));
+  int first = 1;
+
+  for(size_t i = 0; i < n; i++) {
+    if(leader[i] != i)
+      continue;
+
+    size_t n_mirrors = 0;
+    for(size_t j = i + 1; j < n; j++)
+      if(leader[j] == i)
+        mirrors[n_mirrors++] = terms[j];
+
+    if(saved && !first) {
+      for(size_t c = 0; c < n_front; c++) {
+        front_forget(rb, &rb->front[c]);
+        rb->front[c] = saved[c];
+        if(saved[c].state == FRONT_ERASE || saved[c].state == FRONT_GLYPH)
+          pen_ref(rb, saved[c].pen);
+      }
+    }
+    first = 0;
+
+    tickit_term_start_mirror(terms[i], mirrors, n_mirrors);
+    flush_frame(rb, terms[i], n_sets == 1);
+    tickit_term_stop_mirror(terms[i]);
+  }
+
+  if(saved) {
+    for(size_t c = 0; c < n_front; c++)
+      if(saved[c].state == FRONT_ERASE || saved[c].state == FRONT_GLYPH)
+        pen_unref(rb, saved[c].pen);
+    free(saved);
+  }
+
+  free(mirrors);
+  free(leader);
 
   tickit_renderbuffer_reset(rb);
 }
@@ -922,20 +1972,17 @@ static size_t get_span_text(TickitRenderBuffer *rb, RBCell *span, int offset, in
 
     case TEXT:
       {
-        char *text = rb->texts[span->v.text.idx];
-        TickitStringPos start, end, limit;
-
-        tickit_stringpos_limit_columns(&limit, span->v.text.offs + offset);
-        tickit_string_count(text, &start, &limit);
+        const char *text = cell_text(rb, span);
+        TickitStringPos start = text_offset(rb, span, offset);
 
-        if(one_grapheme)
+        if(one_grapheme) {
+          TickitStringPos end = start, limit;
           tickit_stringpos_limit_graphemes(&limit, start.graphemes + 1);
+          tickit_string_ncountmore(text, span->v.text.bytes, &end, &limit);
+          bytes = end.bytes - start.bytes;
+        }
         else
-          tickit_stringpos_limit_columns(&limit, span->len);
-        end = start;
-        tickit_string_countmore(text, &end, &limit);
-
-        bytes = end.bytes - start.bytes;
+          bytes = span->v.text.bytes - start.bytes;
 
         if(buffer) {
           if(len < bytes)
@@ -951,6 +1998,9 @@ static size_t get_span_text(TickitRenderBuffer *rb, RBCell *span, int offset, in
     case CHAR:
       bytes = tickit_string_putchar(buffer, len, span->v.chr.codepoint);
       break;
+
+    default:
+      return -1;
   }
 
   if(buffer && len > bytes)
@@ -1001,7 +2051,7 @@ TickitPen *tickit_renderbuffer_get_cell_pen(TickitRenderBuffer *rb, int line, in
   if(!span || span->state == SKIP)
     return NULL;
 
-  return span->pen;
+  return rb->pens[span->pen].pen;
 }
 
 size_t tickit_renderbuffer_get_span(TickitRenderBuffer *rb, int line, int startcol, struct TickitRenderBufferSpanInfo *info, char *text, size_t len)
@@ -1025,7 +2075,7 @@ size_t tickit_renderbuffer_get_span(TickitRenderBuffer *rb, int line, int startc
 
   if(info && info->pen) {
     tickit_pen_clear(info->pen);
-    tickit_pen_copy(info->pen, span->pen, 1);
+    tickit_pen_copy(info->pen, rb->pens[span->pen].pen, 1);
   }
 
   size_t retlen = get_span_text(rb, span, offset, 0, text, len);
@@ -2,8 +2,26 @@
 
 #include <stdint.h>
 
+#if defined(__SSE2__)
+# include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+# include <arm_neon.h>
+#endif
+
 #include "unicode.h"
 
+static int ambiguous_width = 1;
+
+void tickit_string_set_ambiguous_width(int width)
+{
+  ambiguous_width = (width == 2) ? 2 : 1;
+}
+
+int tickit_string_get_ambiguous_width(void)
+{
+  return ambiguous_width;
+}
+
 static int next_utf8(const char *str, size_t len, uint32_t *cp)
 {
   unsigned char b0 = (str++)[0];
@@ -84,6 +102,81 @@ size_t tickit_string_putchar(char *str, size_t len, long codepoint)
   return nbytes;
 }
 
+/* Printable ASCII (0x20 to 0x7e) advances bytes, codepoints, graphemes and
+ * columns all by one, so runs of it need not be decoded
+ */
+static inline int is_printable_ascii(unsigned char b)
+{
+  return b >= 0x20 && b < 0x7f;
+}
+
+/* Returns the length of the run of printable ASCII at the start of str, up to
+ * max bytes. A len of (size_t)-1 means NUL-terminated, which is only safe to
+ * scan a byte at a time
+ */
+static size_t ascii_run(const char *str, size_t len, size_t max)
+{
+  size_t n = 0;
+
+  if(len != (size_t)-1) {
+    if(max > len)
+      max = len;
+
+#if defined(__SSE2__)
+    const __m128i lo = _mm_set1_epi8(0x1f);
+    const __m128i hi = _mm_set1_epi8(0x7f);
+    while(max - n >= 16) {
+      // Signed compares, so bytes >= 0x80 fail the lower bound too
+      __m128i v = _mm_loadu_si128((const __m128i *)(str + n));
+      int mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpgt_epi8(v, lo), _mm_cmplt_epi8(v, hi)));
+      if(mask != 0xffff)
+        return n + __builtin_ctz(~mask);
+      n += 16;
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    const uint8x16_t lo = vdupq_n_u8(0x20);
+    const uint8x16_t hi = vdupq_n_u8(0x7e);
+    while(max - n >= 16) {
+      uint8x16_t v = vld1q_u8((const uint8_t *)(str + n));
+      if(vminvq_u8(vandq_u8(vcgeq_u8(v, lo), vcleq_u8(v, hi))) != 0xff)
+        break;
+      n += 16;
+    }
+#endif
+  }
+
+  while(n < max && is_printable_ascii(str[n]))
+    n++;
+
+  return n;
+}
+
+static inline void clamp_room(size_t *room, int limit, int here)
+{
+  if(limit == -1)
+    return;
+
+  size_t r = limit > here ? limit - here : 0;
+  if(r < *room)
+    *room = r;
+}
+
+/* How many more single-column ASCII characters the limit permits past here */
+static size_t ascii_room(const TickitStringPos *here, const TickitStringPos *limit)
+{
+  size_t room = (size_t)-1;
+  if(!limit)
+    return room;
+
+  if(limit->bytes != -1)
+    room = limit->bytes > here->bytes ? limit->bytes - here->bytes : 0;
+  clamp_room(&room, limit->codepoints, here->codepoints);
+  clamp_room(&room, limit->graphemes,  here->graphemes);
+  clamp_room(&room, limit->columns,    here->columns);
+
+  return room;
+}
+
 size_t tickit_string_count(const char *str, TickitStringPos *pos, const TickitStringPos *limit)
 {
   tickit_stringpos_zero(pos);
@@ -111,18 +204,36 @@ size_t tickit_string_ncountmore(const char *str, size_t len, TickitStringPos *po
     len -= pos->bytes;
 
   while((len == (size_t)-1) ? *str : (len > 0)) {
+    size_t run = ascii_run(str, len, ascii_room(&here, limit));
+    if(run) {
+      // Each character commits the one before it, as below
+      here.bytes += run - 1;
+      here.codepoints += run - 1;
+      here.graphemes += run - 1;
+      here.columns += run - 1;
+      *pos = here;
+
+      str += run;
+      if(len != (size_t)-1)
+        len -= run;
+
+      here.bytes += 1;
+      here.codepoints += 1;
+      here.graphemes += 1;
+      here.columns += 1;
+      continue;
+    }
+
     uint32_t cp;
     int bytes = next_utf8(str, len, &cp);
     if(bytes == -1)
       return -1;
 
-    /* Abort on C0 or C1 controls */
-    if(cp < 0x20 || (cp >= 0x80 && cp < 0xa0))
+    /* Abort on C0 or C1 controls, or DEL */
+    if(cp < 0x20 || (cp >= 0x7f && cp < 0xa0))
       return -1;
 
-    int width = mk_wcwidth(cp);
-    if(width == -1)
-      return -1;
+    int width = unicode_width(cp, ambiguous_width);
 
     int is_grapheme = (width > 0) ? 1 : 0;
     if(is_grapheme) // Commit on the previous grapheme
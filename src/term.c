@@ -21,6 +21,7 @@
 #include <sys/ioctl.h>
 #include <sys/select.h>
 #include <sys/time.h>
+#include <sys/uio.h>
 
 /* unit multipliers for working in microseconds */
 #define MSEC      1000
@@ -34,6 +35,18 @@ static TickitTermDriverProbe *driver_probes[] = {
   NULL,
 };
 
+/* Output the fd would not yet accept, in the order it was written */
+struct OutChunk {
+  struct OutChunk *next;
+  size_t off;  /* start of the unwritten bytes */
+  size_t len;  /* count of unwritten bytes */
+  size_t size; /* allocated size of data */
+  char data[];
+};
+
+#define OUTCHUNK_MIN 4096
+#define OUTQUEUE_IOV 16
+
 struct TickitTerm {
   int                   outfd;
   TickitTermOutputFunc *outfunc;
@@ -43,6 +56,11 @@ struct TickitTerm {
   TermKey              *termkey;
   struct timeval        input_timeout_at; /* absolute time */
 
+  /* A drag or wheel event held back in case more of the same follow */
+  int                   mouse_coalesce;
+  int                   has_pending_mouse;
+  TickitEvent           pending_mouse;
+
   const char *termtype;
   signed char is_utf8;  /* -1 == unknown */
 
@@ -50,6 +68,9 @@ struct TickitTerm {
   size_t outbuffer_len; /* size of outbuffer */
   size_t outbuffer_cur; /* current fill level */
 
+  struct OutChunk *outqueue, *outqueue_last;
+  size_t outqueue_len; /* total unwritten bytes in outqueue */
+
   char *tmpbuffer;
   size_t tmpbuffer_len;
 
@@ -58,12 +79,24 @@ struct TickitTerm {
   int lines;
   int cols;
 
+  /* Where the cursor is known to be, so drivers can pick cheaper motions;
+   * -1 if unknown */
+  int cursor_line;
+  int cursor_col;
+
   enum { UNSTARTED, STARTING, STARTED } state;
 
   int colors;
   TickitPen *pen;
+  TickitPen *deltapen; /* scratch space for chpen/setpen */
+
+  TickitTermStats stats;
 
-  struct TickitEventHook *hooks;
+  /* Other terminals given a copy of all output */
+  TickitTerm **mirrors;
+  size_t n_mirrors;
+
+  struct TickitHooklist hooks;
 };
 
 DEFINE_HOOKLIST_FUNCS(term,TickitTerm,TickitTermEventFn)
@@ -88,6 +121,115 @@ static TermKey *get_termkey(TickitTerm *tt)
   return tt->termkey;
 }
 
+static void outqueue_push(TickitTerm *tt, const char *str, size_t len)
+{
+  struct OutChunk *tail = tt->outqueue_last;
+
+  if(!tail || tail->off + tail->len + len > tail->size) {
+    size_t size = len > OUTCHUNK_MIN ? len : OUTCHUNK_MIN;
+    tail = malloc(sizeof(struct OutChunk) + size);
+    if(!tail)
+      /* Nowhere to keep it; lose it as if write() had failed */
+      return;
+
+    tail->next = NULL;
+    tail->off  = 0;
+    tail->len  = 0;
+    tail->size = size;
+
+    if(tt->outqueue_last)
+      tt->outqueue_last->next = tail;
+    else
+      tt->outqueue = tail;
+    tt->outqueue_last = tail;
+  }
+
+  memcpy(tail->data + tail->off + tail->len, str, len);
+  tail->len += len;
+  tt->outqueue_len += len;
+}
+
+static void outqueue_clear(TickitTerm *tt)
+{
+  while(tt->outqueue) {
+    struct OutChunk *next = tt->outqueue->next;
+    free(tt->outqueue);
+    tt->outqueue = next;
+  }
+
+  tt->outqueue_last = NULL;
+  tt->outqueue_len = 0;
+}
+
+/* Writes anything already queued and then the given bytes to outfd, using
+ * as few syscalls as possible. If the fd is non-blocking and will not accept
+ * it all, the remainder is queued for tickit_term_output_writable().
+ */
+static void write_fd(TickitTerm *tt, const char *str, size_t len)
+{
+  while(tt->outqueue || len) {
+    struct iovec iov[OUTQUEUE_IOV];
+    int iovcnt = 0;
+
+    struct OutChunk *chunk;
+    for(chunk = tt->outqueue; chunk && iovcnt < OUTQUEUE_IOV; chunk = chunk->next) {
+      iov[iovcnt].iov_base = chunk->data + chunk->off;
+      iov[iovcnt].iov_len  = chunk->len;
+      iovcnt++;
+    }
+
+    int with_str = !chunk && len && iovcnt < OUTQUEUE_IOV;
+    if(with_str) {
+      iov[iovcnt].iov_base = (char *)str;
+      iov[iovcnt].iov_len  = len;
+      iovcnt++;
+    }
+
+    ssize_t written = iovcnt > 1 ? writev(tt->outfd, iov, iovcnt)
+                                 : write(tt->outfd, iov[0].iov_base, iov[0].iov_len);
+    tt->stats.writes++;
+    if(written < 0) {
+      if(errno == EINTR)
+        continue;
+      if(errno == EAGAIN || errno == EWOULDBLOCK)
+        break;
+
+      /* The fd is broken; nothing will ever be written */
+      outqueue_clear(tt);
+      return;
+    }
+    if(written == 0)
+      break;
+
+    tt->stats.bytes += written;
+
+    size_t n = written;
+    while(n && tt->outqueue) {
+      chunk = tt->outqueue;
+      if(n < chunk->len) {
+        chunk->off += n;
+        chunk->len -= n;
+        tt->outqueue_len -= n;
+        n = 0;
+        break;
+      }
+
+      n -= chunk->len;
+      tt->outqueue_len -= chunk->len;
+      tt->outqueue = chunk->next;
+      free(chunk);
+    }
+    if(!tt->outqueue)
+      tt->outqueue_last = NULL;
+
+    str += n;
+    len -= n;
+  }
+
+  if(len)
+    outqueue_push(tt, str, len);
+}
+
 TickitTerm *tickit_term_new(void)
 {
   const char *termtype = getenv("TERM");
@@ -131,10 +273,17 @@ TickitTerm *tickit_term_new_for_driver(TickitTermDriver *ttd)
   tt->termkey = NULL;
   tt->input_timeout_at.tv_sec = -1;
 
+  tt->mouse_coalesce = 0;
+  tt->has_pending_mouse = 0;
+
   tt->outbuffer = NULL;
   tt->outbuffer_len = 0;
   tt->outbuffer_cur = 0;
 
+  tt->outqueue = NULL;
+  tt->outqueue_last = NULL;
+  tt->outqueue_len = 0;
+
   tt->tmpbuffer = NULL;
   tt->tmpbuffer_len = 0;
 
@@ -144,12 +293,21 @@ TickitTerm *tickit_term_new_for_driver(TickitTermDriver *ttd)
   tt->lines = 25;
   tt->cols  = 80;
 
-  tt->hooks = NULL;
+  tt->cursor_line = -1;
+  tt->cursor_col  = -1;
+
+  tickit_hooklist_init(&tt->hooks);
 
   /* Initially empty because we don't necessarily know the initial state
    * of the terminal
    */
   tt->pen = tickit_pen_new();
+  tt->deltapen = tickit_pen_new();
+
+  memset(&tt->stats, 0, sizeof(tt->stats));
+
+  tt->mirrors = NULL;
+  tt->n_mirrors = 0;
 
   tt->termtype = NULL;
 
@@ -169,8 +327,9 @@ TickitTerm *tickit_term_new_for_driver(TickitTermDriver *ttd)
 
 void tickit_term_free(TickitTerm *tt)
 {
-  tickit_hooklist_unbind_and_destroy(tt->hooks, tt);
+  tickit_hooklist_unbind_and_destroy(&tt->hooks, tt);
   tickit_pen_destroy(tt->pen);
+  tickit_pen_destroy(tt->deltapen);
 
   if(tt->driver) {
     if(tt->driver->vtable->stop)
@@ -185,6 +344,8 @@ void tickit_term_free(TickitTerm *tt)
   if(tt->outbuffer)
     free(tt->outbuffer);
 
+  outqueue_clear(tt);
+
   if(tt->tmpbuffer)
     free(tt->tmpbuffer);
 
@@ -232,12 +393,20 @@ void tickit_term_get_size(const TickitTerm *tt, int *lines, int *cols)
     *cols  = tt->cols;
 }
 
+static void forget_cursor(TickitTerm *tt)
+{
+  tt->cursor_line = -1;
+  tt->cursor_col  = -1;
+}
+
 void tickit_term_set_size(TickitTerm *tt, int lines, int cols)
 {
   if(tt->lines != lines || tt->cols != cols) {
     tt->lines = lines;
     tt->cols  = cols;
 
+    forget_cursor(tt);
+
     TickitEvent args = { .lines = lines, .cols = cols };
     run_events(tt, TICKIT_EV_RESIZE, &args);
   }
@@ -257,6 +426,9 @@ void tickit_term_refresh_size(TickitTerm *tt)
 
 void tickit_term_set_output_fd(TickitTerm *tt, int fd)
 {
+  /* Anything still queued was destined for the old fd */
+  outqueue_clear(tt);
+
   tt->outfd = fd;
 
   tickit_term_refresh_size(tt);
@@ -334,6 +506,21 @@ void tickit_term_set_utf8(TickitTerm *tt, int utf8)
   }
 }
 
+static void flush_pending_mouse(TickitTerm *tt);
+
+int tickit_term_get_mouse_coalesce(const TickitTerm *tt)
+{
+  return tt->mouse_coalesce;
+}
+
+void tickit_term_set_mouse_coalesce(TickitTerm *tt, int coalesce)
+{
+  tt->mouse_coalesce = !!coalesce;
+
+  if(!coalesce)
+    flush_pending_mouse(tt);
+}
+
 void tickit_term_await_started(TickitTerm *tt, const struct timeval *timeout)
 {
   if(tt->state == STARTED)
@@ -379,6 +566,47 @@ void tickit_term_await_started(TickitTerm *tt, const struct timeval *timeout)
   tt->state = STARTED;
 }
 
+static void flush_pending_mouse(TickitTerm *tt)
+{
+  if(!tt->has_pending_mouse)
+    return;
+
+  TickitEvent args = tt->pending_mouse;
+  tt->has_pending_mouse = 0;
+
+  run_events(tt, TICKIT_EV_MOUSE, &args);
+}
+
+/* When coalescing, a run of drags or of wheel steps with the same button and
+ * modifiers is delivered as just its last position, with the wheel steps
+ * counted up. Anything else first delivers what was held back, so the order
+ * of presses and releases is kept
+ */
+static void got_mouse(TickitTerm *tt, TickitEvent *args)
+{
+  if(tt->mouse_coalesce &&
+     (args->type == TICKIT_MOUSEEV_DRAG || args->type == TICKIT_MOUSEEV_WHEEL)) {
+    TickitEvent *pending = &tt->pending_mouse;
+
+    if(tt->has_pending_mouse &&
+       pending->type == args->type && pending->button == args->button && pending->mod == args->mod) {
+      int count = pending->count + args->count;
+      *pending = *args;
+      pending->count = count;
+      return;
+    }
+
+    flush_pending_mouse(tt);
+
+    tt->pending_mouse = *args;
+    tt->has_pending_mouse = 1;
+    return;
+  }
+
+  flush_pending_mouse(tt);
+  run_events(tt, TICKIT_EV_MOUSE, args);
+}
+
 static void got_key(TickitTerm *tt, TermKey *tk, TermKeyKey *key)
 {
   TickitEvent args;
@@ -387,6 +615,9 @@ static void got_key(TickitTerm *tt, TermKey *tk, TermKeyKey *key)
      (*tt->driver->vtable->gotkey)(tt->driver, tk, key))
     return;
 
+  if(key->type != TERMKEY_TYPE_MOUSE)
+    flush_pending_mouse(tt);
+
   if(key->type == TERMKEY_TYPE_MOUSE) {
     TermKeyMouseEvent ev;
     termkey_interpret_mouse(tk, key, &ev, &args.button, &args.line, &args.col);
@@ -406,8 +637,9 @@ static void got_key(TickitTerm *tt, TermKey *tk, TermKeyKey *key)
     }
 
     args.mod = key->modifiers;
+    args.count = args.type == TICKIT_MOUSEEV_WHEEL ? 1 : 0;
 
-    run_events(tt, TICKIT_EV_MOUSE, &args);
+    got_mouse(tt, &args);
   }
   else if(key->type == TERMKEY_TYPE_UNICODE && !key->modifiers) {
     /* Unmodified unicode */
@@ -420,6 +652,10 @@ static void got_key(TickitTerm *tt, TermKey *tk, TermKeyKey *key)
   else if(key->type == TERMKEY_TYPE_UNICODE ||
           key->type == TERMKEY_TYPE_FUNCTION ||
           key->type == TERMKEY_TYPE_KEYSYM) {
+    /* Don't bother formatting the key name if nothing will see it */
+    if(!tickit_hooklist_has_event(&tt->hooks, TICKIT_EV_KEY))
+      return;
+
     char buffer[64]; // TODO: should be long enough
     termkey_strfkey(tk, buffer, sizeof buffer, key, TERMKEY_FORMAT_ALTISMETA);
 
@@ -439,6 +675,8 @@ static void get_keys(TickitTerm *tt, TermKey *tk)
     got_key(tt, tk, &key);
   }
 
+  flush_pending_mouse(tt);
+
   if(res == TERMKEY_RES_AGAIN) {
     struct timeval tv;
     gettimeofday(&tv, NULL);
@@ -501,6 +739,7 @@ int tickit_term_input_check_timeout(TickitTerm *tt)
   TermKeyKey key;
   if(termkey_getkey_force(tk, &key) == TERMKEY_RES_KEY) {
     got_key(tt, tk, &key);
+    flush_pending_mouse(tt);
   }
 
   tt->input_timeout_at.tv_sec = -1;
@@ -516,38 +755,114 @@ void tickit_term_input_wait(TickitTerm *tt, const struct timeval *timeout)
   if(timeout)
     to_copy = *timeout;
 
-  fd_set readfds;
+  fd_set readfds, writefds;
+  FD_ZERO(&readfds);
+  FD_ZERO(&writefds);
+
   int fd = termkey_get_fd(tk);
   FD_SET(fd, &readfds);
-  if(select(fd + 1, &readfds, NULL, NULL, timeout ? &to_copy : NULL) == 1) {
-    termkey_advisereadable(tk);
+  int maxfd = fd;
+
+  /* While there's output the fd would not take, also wait until it will */
+  int outfd = tt->outqueue ? tt->outfd : -1;
+  if(outfd != -1) {
+    FD_SET(outfd, &writefds);
+    if(outfd > maxfd)
+      maxfd = outfd;
+  }
+
+  if(select(maxfd + 1, &readfds, outfd != -1 ? &writefds : NULL, NULL, timeout ? &to_copy : NULL) > 0) {
+    if(outfd != -1 && FD_ISSET(outfd, &writefds))
+      tickit_term_output_writable(tt);
+    if(FD_ISSET(fd, &readfds))
+      termkey_advisereadable(tk);
   }
 
   /* Might as well get any more that are ready */
   while(termkey_getkey(tk, &key) == TERMKEY_RES_KEY) {
     got_key(tt, tk, &key);
   }
+
+  flush_pending_mouse(tt);
 }
 
 void tickit_term_flush(TickitTerm *tt)
 {
-  if(tt->outbuffer_cur == 0)
+  if(tt->outbuffer_cur == 0 && !tt->outqueue)
     return;
 
-  if(tt->outfunc)
-    (*tt->outfunc)(tt, tt->outbuffer, tt->outbuffer_cur, tt->outfunc_user);
+  tt->stats.flushes++;
+
+  if(tt->outfunc) {
+    if(tt->outbuffer_cur) {
+      (*tt->outfunc)(tt, tt->outbuffer, tt->outbuffer_cur, tt->outfunc_user);
+      tt->stats.bytes += tt->outbuffer_cur;
+    }
+  }
   else if(tt->outfd != -1) {
-    write(tt->outfd, tt->outbuffer, tt->outbuffer_cur);
+    write_fd(tt, tt->outbuffer, tt->outbuffer_cur);
   }
 
   tt->outbuffer_cur = 0;
 }
 
+void tickit_term_get_stats(const TickitTerm *tt, TickitTermStats *stats)
+{
+  *stats = tt->stats;
+}
+
+int tickit_term_output_equiv(const TickitTerm *a, const TickitTerm *b)
+{
+  // Drivers without a termtype may not output bytes at all
+  return a->driver->vtable == b->driver->vtable &&
+         a->termtype && b->termtype && strcmp(a->termtype, b->termtype) == 0 &&
+         a->lines == b->lines && a->cols == b->cols &&
+         a->colors == b->colors &&
+         a->cursor_line == b->cursor_line && a->cursor_col == b->cursor_col &&
+         tickit_pen_equiv(a->pen, b->pen);
+}
+
+void tickit_term_start_mirror(TickitTerm *tt, TickitTerm *mirrors[], size_t n)
+{
+  tt->mirrors = mirrors;
+  tt->n_mirrors = n;
+}
+
+void tickit_term_stop_mirror(TickitTerm *tt)
+{
+  for(size_t i = 0; i < tt->n_mirrors; i++) {
+    TickitTerm *mirror = tt->mirrors[i];
+
+    tickit_pen_clear(mirror->pen);
+    tickit_pen_copy(mirror->pen, tt->pen, 1);
+
+    mirror->cursor_line = tt->cursor_line;
+    mirror->cursor_col  = tt->cursor_col;
+  }
+
+  tt->mirrors = NULL;
+  tt->n_mirrors = 0;
+}
+
+size_t tickit_term_output_pending(const TickitTerm *tt)
+{
+  return tt->outqueue_len;
+}
+
+void tickit_term_output_writable(TickitTerm *tt)
+{
+  if(tt->outqueue && tt->outfd != -1)
+    write_fd(tt, NULL, 0);
+}
+
 static void write_str(TickitTerm *tt, const char *str, size_t len)
 {
   if(len == 0)
     len = strlen(str);
 
+  for(size_t i = 0; i < tt->n_mirrors; i++)
+    write_str(tt->mirrors[i], str, len);
+
   if(tt->outbuffer) {
     while(len > 0) {
       size_t space = tt->outbuffer_len - tt->outbuffer_cur;
@@ -555,6 +870,7 @@ static void write_str(TickitTerm *tt, const char *str, size_t len)
         space = len;
       memcpy(tt->outbuffer + tt->outbuffer_cur, str, space);
       tt->outbuffer_cur += space;
+      str += space;
       len -= space;
       if(tt->outbuffer_cur >= tt->outbuffer_len)
         tickit_term_flush(tt);
@@ -562,9 +878,10 @@ static void write_str(TickitTerm *tt, const char *str, size_t len)
   }
   else if(tt->outfunc) {
     (*tt->outfunc)(tt, str, len, tt->outfunc_user);
+    tt->stats.bytes += len;
   }
   else if(tt->outfd != -1) {
-    write(tt->outfd, str, len);
+    write_fd(tt, str, len);
   }
 }
 /* Driver API */
@@ -573,6 +890,22 @@ void tickit_termdrv_write_str(TickitTermDriver *ttd, const char *str, size_t len
   write_str(ttd->tt, str, len);
 }
 
+void tickit_termdrv_write_chrfill(TickitTermDriver *ttd, char c, int n)
+{
+  if(n < 1)
+    return;
+
+  size_t chunk = n < 256 ? n : 256;
+  char *buf = get_tmpbuffer(ttd->tt, chunk);
+  memset(buf, c, chunk);
+
+  while(n > chunk) {
+    write_str(ttd->tt, buf, chunk);
+    n -= chunk;
+  }
+  write_str(ttd->tt, buf, n);
+}
+
 static void write_vstrf(TickitTerm *tt, const char *fmt, va_list args)
 {
   /* It's likely the output will fit in, say, 64 bytes */
@@ -599,14 +932,34 @@ void tickit_termdrv_write_strf(TickitTermDriver *ttd, const char *fmt, ...)
   va_end(args);
 }
 
+static void advance_cursor(TickitTerm *tt, const char *str, size_t len)
+{
+  if(tt->cursor_col == -1)
+    return;
+
+  TickitStringPos pos;
+  if(tickit_string_ncount(str, len, &pos, NULL) == -1) {
+    forget_cursor(tt);
+    return;
+  }
+
+  tt->cursor_col += pos.columns;
+
+  /* Reaching the right margin leaves the terminal in its pending-wrap state,
+   * where relative motions are unreliable */
+  if(tt->cursor_col >= tt->cols)
+    forget_cursor(tt);
+}
+
 void tickit_term_print(TickitTerm *tt, const char *str)
 {
-  (*tt->driver->vtable->print)(tt->driver, str, strlen(str));
+  tickit_term_printn(tt, str, strlen(str));
 }
 
 void tickit_term_printn(TickitTerm *tt, const char *str, size_t len)
 {
   (*tt->driver->vtable->print)(tt->driver, str, len);
+  advance_cursor(tt, str, len);
 }
 
 void tickit_term_printf(TickitTerm *tt, const char *fmt, ...)
@@ -626,18 +979,43 @@ void tickit_term_vprintf(TickitTerm *tt, const char *fmt, va_list args)
   char *buf = get_tmpbuffer(tt, len + 1);
   vsnprintf(buf, len + 1, fmt, args2);
   (*tt->driver->vtable->print)(tt->driver, buf, len);
+  advance_cursor(tt, buf, len);
 
   va_end(args2);
 }
 
 int tickit_term_goto(TickitTerm *tt, int line, int col)
 {
-  return (*tt->driver->vtable->goto_abs)(tt->driver, line, col);
+  if(!(*tt->driver->vtable->goto_abs)(tt->driver, line, col)) {
+    forget_cursor(tt);
+    return 0;
+  }
+
+  tt->stats.gotos++;
+
+  if(line != -1)
+    tt->cursor_line = (line < tt->lines) ? line : -1;
+  if(col != -1)
+    tt->cursor_col  = (col < tt->cols) ? col : -1;
+
+  return 1;
 }
 
 void tickit_term_move(TickitTerm *tt, int downward, int rightward)
 {
   (*tt->driver->vtable->move_rel)(tt->driver, downward, rightward);
+
+  /* Motion is clamped at the edges, so a position off the screen is unknown */
+  if(tt->cursor_line != -1) {
+    tt->cursor_line += downward;
+    if(tt->cursor_line < 0 || tt->cursor_line >= tt->lines)
+      tt->cursor_line = -1;
+  }
+  if(tt->cursor_col != -1) {
+    tt->cursor_col += rightward;
+    if(tt->cursor_col < 0 || tt->cursor_col >= tt->cols)
+      tt->cursor_col = -1;
+  }
 }
 
 int tickit_term_scrollrect(TickitTerm *tt, int top, int left, int lines, int cols, int downward, int rightward)
@@ -648,7 +1026,12 @@ int tickit_term_scrollrect(TickitTerm *tt, int top, int left, int lines, int col
     .lines = lines,
     .cols  = cols,
   };
-  return (*tt->driver->vtable->scrollrect)(tt->driver, &rect, downward, rightward);
+  forget_cursor(tt);
+  if(!(*tt->driver->vtable->scrollrect)(tt->driver, &rect, downward, rightward))
+    return 0;
+
+  tt->stats.scrollrects++;
+  return 1;
 }
 
 static int convert_colour(int index, int colours)
@@ -661,7 +1044,8 @@ static int convert_colour(int index, int colours)
 
 void tickit_term_chpen(TickitTerm *tt, const TickitPen *pen)
 {
-  TickitPen *delta = tickit_pen_new();
+  TickitPen *delta = tt->deltapen;
+  tickit_pen_clear(delta);
 
   for(TickitPenAttr attr = 0; attr < TICKIT_N_PEN_ATTRS; attr++) {
     if(!tickit_pen_has_attr(pen, attr))
@@ -683,14 +1067,16 @@ void tickit_term_chpen(TickitTerm *tt, const TickitPen *pen)
     }
   }
 
-  (*tt->driver->vtable->chpen)(tt->driver, delta, tt->pen);
+  if(tickit_pen_is_nonempty(delta))
+    tt->stats.setpens++;
 
-  tickit_pen_destroy(delta);
+  (*tt->driver->vtable->chpen)(tt->driver, delta, tt->pen);
 }
 
 void tickit_term_setpen(TickitTerm *tt, const TickitPen *pen)
 {
-  TickitPen *delta = tickit_pen_new();
+  TickitPen *delta = tt->deltapen;
+  tickit_pen_clear(delta);
 
   for(TickitPenAttr attr = 0; attr < TICKIT_N_PEN_ATTRS; attr++) {
     if(tickit_pen_has_attr(tt->pen, attr) && tickit_pen_equiv_attr(tt->pen, pen, attr))
@@ -709,9 +1095,10 @@ void tickit_term_setpen(TickitTerm *tt, const TickitPen *pen)
     }
   }
 
-  (*tt->driver->vtable->chpen)(tt->driver, delta, tt->pen);
+  if(tickit_pen_is_nonempty(delta))
+    tt->stats.setpens++;
 
-  tickit_pen_destroy(delta);
+  (*tt->driver->vtable->chpen)(tt->driver, delta, tt->pen);
 }
 
 /* Driver API */
@@ -720,14 +1107,40 @@ TickitPen *tickit_termdrv_current_pen(TickitTermDriver *ttd)
   return ttd->tt->pen;
 }
 
+/* Driver API */
+void tickit_termdrv_current_cursor(TickitTermDriver *ttd, int *line, int *col)
+{
+  *line = ttd->tt->cursor_line;
+  *col  = ttd->tt->cursor_col;
+}
+
 void tickit_term_clear(TickitTerm *tt)
 {
+  forget_cursor(tt);
   (*tt->driver->vtable->clear)(tt->driver);
 }
 
 void tickit_term_erasech(TickitTerm *tt, int count, int moveend)
 {
+  int line = tt->cursor_line, col = tt->cursor_col;
+
+  /* The driver may use the cursor position to pick a shorter sequence */
   (*tt->driver->vtable->erasech)(tt->driver, count, moveend);
+  forget_cursor(tt);
+
+  /* moveend == -1 lets the driver leave the cursor anywhere */
+  if(col == -1 || moveend == -1 || count < 1)
+    return;
+
+  if(moveend)
+    col += count;
+  else if(col + count >= tt->cols)
+    return; /* may have passed through pending-wrap */
+
+  if(col < tt->cols) {
+    tt->cursor_line = line;
+    tt->cursor_col  = col;
+  }
 }
 
 int tickit_term_getctl_int(TickitTerm *tt, TickitTermCtl ctl, int *value)
@@ -737,6 +1150,9 @@ int tickit_term_getctl_int(TickitTerm *tt, TickitTermCtl ctl, int *value)
 
 int tickit_term_setctl_int(TickitTerm *tt, TickitTermCtl ctl, int value)
 {
+  /* Switching screen may also move the cursor; no other control does */
+  if(ctl == TICKIT_TERMCTL_ALTSCREEN)
+    forget_cursor(tt);
   return (*tt->driver->vtable->setctl_int)(tt->driver, ctl, value);
 }
 
@@ -71,6 +71,28 @@ static const char *require_ti_string(unibi_term *ut, const char *termtype, enum
   abort();
 }
 
+/* Terminfo strings are compiled once when the driver is created. Those made
+ * only of literal bytes, %i, %% and %pN%d become a template of literal
+ * fragments and decimal parameter slots, which is expanded without running
+ * the unibilium interpreter. Anything else is kept for unibi_run().
+ */
+#define TI_MAXFRAGS  4  // parameter slots
+#define TI_MAXLIT   32  // literal bytes
+#define TI_MAXLEN   (TI_MAXLIT + TI_MAXFRAGS * 11)
+
+typedef struct {
+  const char *src;
+  int nfrags; // -1 if not compiled
+  struct {
+    unsigned char litlen; // literal bytes before the slot
+    signed char   param;  // parameter index, or -1 in the final fragment
+    unsigned char add;    // 1 after %i, for the first two parameters
+  } frag[TI_MAXFRAGS + 1];
+  char lit[TI_MAXLIT];
+} TIString;
+
+#define TI_NSTRINGS 32
+
 struct TIDriver {
   TickitTermDriver driver;
 
@@ -89,34 +111,39 @@ struct TIDriver {
 
   struct {
     // Positioning
-    const char *cup;  // cursor_address
-    const char *vpa;  // row_address == vertical position absolute
-    const char *hpa;  // column_address = horizontal position absolute
+    const TIString *cup;  // cursor_address
+    const TIString *vpa;  // row_address == vertical position absolute
+    const TIString *hpa;  // column_address = horizontal position absolute
 
     // Moving
-    const char *cuu; const char *cuu1; // Cursor Up
-    const char *cud; const char *cud1; // Cursor Down
-    const char *cuf; const char *cuf1; // Cursor Forward == Right
-    const char *cub; const char *cub1; // Cursor Backward == Left
+    const TIString *cuu; const TIString *cuu1; // Cursor Up
+    const TIString *cud; const TIString *cud1; // Cursor Down
+    const TIString *cuf; const TIString *cuf1; // Cursor Forward == Right
+    const TIString *cub; const TIString *cub1; // Cursor Backward == Left
 
     // Editing
-    const char *ich; const char *ich1; // Insert Character
-    const char *dch; const char *dch1; // Delete Character
-    const char *il;  const char *il1;  // Insert Line
-    const char *dl;  const char *dl1;  // Delete Line
-    const char *ech;                   // Erase Character
-    const char *ed2;                   // Erase Data 2 == Clear screen
-    const char *stbm;                  // Set Top/Bottom Margins
+    const TIString *ich; const TIString *ich1; // Insert Character
+    const TIString *dch; const TIString *dch1; // Delete Character
+    const TIString *il;  const TIString *il1;  // Insert Line
+    const TIString *dl;  const TIString *dl1;  // Delete Line
+    const TIString *ech;                       // Erase Character
+    const TIString *el;                        // Erase in Line == Clear to end of line
+    const TIString *rep;                       // Repeat character
+    const TIString *ed2;                       // Erase Data 2 == Clear screen
+    const TIString *stbm;                      // Set Top/Bottom Margins
 
     // Formatting
-    const char *sgr;    // Select Graphic Rendition
-    const char *sgr_fg; // SGR foreground colour
-    const char *sgr_bg; // SGR background colour
+    const TIString *sgr;    // Select Graphic Rendition
+    const TIString *sgr_fg; // SGR foreground colour
+    const TIString *sgr_bg; // SGR background colour
 
     // Mode setting/clearing
-    const char *sm_csr; const char *rm_csr; // Set/reset mode: Cursor visible
+    const TIString *sm_csr; const TIString *rm_csr; // Set/reset mode: Cursor visible
   } str;
 
+  TIString strings[TI_NSTRINGS]; // storage for the str pointers
+  int n_strings;
+
   const struct TermInfoExtraStrings *extra;
 };
 
@@ -125,61 +152,275 @@ static void print(TickitTermDriver *ttd, const char *str, size_t len)
   tickit_termdrv_write_str(ttd, str, len);
 }
 
-static void run_ti(TickitTermDriver *ttd, const char *str, int n_params, ...)
+static const TIString *compile_ti(struct TIDriver *td, const char *src)
+{
+  if(!src)
+    return NULL;
+
+  if(td->n_strings == TI_NSTRINGS) {
+    fprintf(stderr, "Too many TI strings\n");
+    abort();
+  }
+
+  TIString *ts = &td->strings[td->n_strings++];
+  ts->src = src;
+  ts->nfrags = -1;
+
+  int nfrags = 0, incr = 0;
+  size_t litlen = 0, fragstart = 0;
+
+  for(const char *s = src; *s; ) {
+    if(s[0] == '%' && s[1] == 'i') {
+      incr = 1;
+      s += 2;
+    }
+    else if(s[0] == '%' && s[1] == 'p' && s[2] >= '1' && s[2] <= '9' && s[3] == '%' && s[4] == 'd') {
+      if(nfrags == TI_MAXFRAGS)
+        return ts;
+
+      int param = s[2] - '1';
+      ts->frag[nfrags].litlen = litlen - fragstart;
+      ts->frag[nfrags].param  = param;
+      ts->frag[nfrags].add    = incr && param < 2;
+      nfrags++;
+
+      fragstart = litlen;
+      s += 5;
+    }
+    else if((s[0] == '%' && s[1] != '%') || (s[0] == '$' && s[1] == '<')) {
+      // Any other operation, or padding
+      return ts;
+    }
+    else {
+      if(litlen == TI_MAXLIT)
+        return ts;
+
+      ts->lit[litlen++] = s[0];
+      s += (s[0] == '%') ? 2 : 1;
+    }
+  }
+
+  ts->frag[nfrags].litlen = litlen - fragstart;
+  ts->frag[nfrags].param  = -1;
+  ts->nfrags = nfrags + 1;
+
+  return ts;
+}
+
+/* Expands a compiled string into buf, which must have space for TI_MAXLEN
+ * bytes, returning its length
+ */
+static size_t expand_ti(const TIString *ts, const int params[9], char *buf)
+{
+  const char *lit = ts->lit;
+  char *s = buf;
+
+  for(int i = 0; i < ts->nfrags; i++) {
+    memcpy(s, lit, ts->frag[i].litlen);
+    s   += ts->frag[i].litlen;
+    lit += ts->frag[i].litlen;
+
+    if(ts->frag[i].param == -1)
+      break;
+
+    unsigned int v;
+    int n = params[ts->frag[i].param] + ts->frag[i].add;
+    if(n < 0) {
+      *s++ = '-';
+      v = -(unsigned int)n;
+    }
+    else
+      v = n;
+
+    char digits[10];
+    int ndigits = 0;
+    do {
+      digits[ndigits++] = '0' + v % 10;
+      v /= 10;
+    } while(v);
+
+    while(ndigits)
+      *s++ = digits[--ndigits];
+  }
+
+  return s - buf;
+}
+
+static size_t uncompiled_ti(const TIString *ts, const int params[9], char *buf, size_t size)
+{
+  unibi_var_t vars[9];
+  for(int i = 0; i < 9; i++)
+    vars[i].i = params[i];
+
+  return unibi_run(ts->src, vars, buf, size);
+}
+
+static void run_ti(TickitTermDriver *ttd, const TIString *ts, int n_params, ...)
 {
-  unibi_var_t params[9];
+  int params[9] = { 0 };
   va_list args;
 
-  if(!str) {
+  if(!ts) {
     fprintf(stderr, "Abort on attempt to use NULL TI string\n");
     abort();
   }
 
   va_start(args, n_params);
-  for(int i = 0; i < 10 && i < n_params; i++)
-    params[i].i = va_arg(args, int);
+  for(int i = 0; i < 9 && i < n_params; i++)
+    params[i] = va_arg(args, int);
+  va_end(args);
 
-  char tmp[64];
+  char tmp[TI_MAXLEN > 64 ? TI_MAXLEN : 64];
   char *buf = tmp;
-  size_t len = unibi_run(str, params, buf, sizeof(tmp));
+  size_t len;
+
+  if(ts->nfrags != -1)
+    len = expand_ti(ts, params, buf);
+  else {
+    len = uncompiled_ti(ts, params, buf, sizeof(tmp));
 
-  if(len > sizeof(tmp)) {
-    buf = tickit_termdrv_get_tmpbuffer(ttd, len);
-    unibi_run(str, params, buf, len);
+    if(len > sizeof(tmp)) {
+      buf = tickit_termdrv_get_tmpbuffer(ttd, len);
+      uncompiled_ti(ts, params, buf, len);
+    }
   }
 
   tickit_termdrv_write_str(ttd, buf, len);
 }
 
+/* Candidate cursor motions are expanded into one of these, keeping the
+ * shortest
+ */
+struct Motion {
+  size_t len; // (size_t)-1 if none yet
+  char buf[64];
+};
+
+static void consider_ti(struct Motion *m, const char *prefix, const TIString *ts, int p1, int p2)
+{
+  if(!ts)
+    return;
+
+  size_t prefixlen = prefix ? strlen(prefix) : 0;
+
+  int params[9] = { p1, p2 };
+
+  char tmp[sizeof m->buf + TI_MAXLEN];
+  size_t len;
+  if(ts->nfrags != -1)
+    len = expand_ti(ts, params, tmp + prefixlen);
+  else
+    len = uncompiled_ti(ts, params, tmp + prefixlen, sizeof(m->buf) - prefixlen);
+  if(len > sizeof(m->buf) - prefixlen)
+    return;
+
+  len += prefixlen;
+  if(m->len != (size_t)-1 && m->len <= len)
+    return;
+
+  if(prefixlen)
+    memcpy(tmp, prefix, prefixlen);
+  memcpy(m->buf, tmp, len);
+  m->len = len;
+}
+
+static void move_col_ti(struct TIDriver *td, struct Motion *m, int from, int to)
+{
+  if(from == to) {
+    m->len = 0;
+    return;
+  }
+
+  if(to == 0) {
+    m->buf[0] = '\r';
+    m->len = 1;
+    return;
+  }
+
+  consider_ti(m, NULL, td->str.hpa, to, 0);
+  if(to == 1)
+    consider_ti(m, "\r", td->str.cuf1, 0, 0);
+  consider_ti(m, "\r", td->str.cuf, to, 0);
+
+  if(from == -1)
+    return;
+
+  if(to > from) {
+    if(to - from == 1)
+      consider_ti(m, NULL, td->str.cuf1, 0, 0);
+    consider_ti(m, NULL, td->str.cuf, to - from, 0);
+  }
+  else {
+    if(from - to == 1)
+      consider_ti(m, NULL, td->str.cub1, 0, 0);
+    consider_ti(m, NULL, td->str.cub, from - to, 0);
+  }
+}
+
+static void move_line_ti(struct TIDriver *td, struct Motion *m, int from, int to)
+{
+  if(from == to) {
+    m->len = 0;
+    return;
+  }
+
+  consider_ti(m, NULL, td->str.vpa, to, 0);
+
+  if(from == -1)
+    return;
+
+  if(to > from) {
+    // cud1 is often a linefeed, which the tty may turn into CR LF
+    if(to - from == 1 && td->str.cud1 && td->str.cud1->src[0] != '\n')
+      consider_ti(m, NULL, td->str.cud1, 0, 0);
+    consider_ti(m, NULL, td->str.cud, to - from, 0);
+  }
+  else {
+    if(from - to == 1)
+      consider_ti(m, NULL, td->str.cuu1, 0, 0);
+    consider_ti(m, NULL, td->str.cuu, from - to, 0);
+  }
+}
+
 static int goto_abs(TickitTermDriver *ttd, int line, int col)
 {
   struct TIDriver *td = (struct TIDriver*)ttd;
 
-  if(line != -1 && col != -1)
-    run_ti(ttd, td->str.cup, 2, line, col);
-  else if(line != -1) {
-    if(!td->str.vpa)
-      return 0;
+  int curline, curcol;
+  tickit_termdrv_current_cursor(ttd, &curline, &curcol);
+
+  /* Vertical motions keep the column, so these can be considered separately
+   * and then compared with a cup that sets both */
+  struct Motion vert = { .len = 0 }, horiz = { .len = 0 };
 
-    run_ti(ttd, td->str.vpa, 1, line);
+  if(line != -1) {
+    vert.len = -1;
+    move_line_ti(td, &vert, curline, line);
+  }
+  if(col != -1) {
+    horiz.len = -1;
+    move_col_ti(td, &horiz, curcol, col);
   }
-  else if(col != -1) {
-    if(col == 0) {
-      tickit_termdrv_write_str(ttd, "\r", 1);
-      return 1;
-    }
 
-    if(td->str.hpa)
-      run_ti(ttd, td->str.hpa, 1, col);
-    else if(td->str.cuf) {
-      // Emulate HPA by CR + CUF
-      tickit_termdrv_write_str(ttd, "\r", 1);
-      run_ti(ttd, td->str.cuf, 1, col);
-    }
-    else
-      return 0;
+  struct Motion cup = { .len = -1 };
+  if(line != -1 && col != -1)
+    consider_ti(&cup, NULL, td->str.cup, line, col);
+
+  // Prefer cup on a tie
+  if(cup.len != (size_t)-1 &&
+     (vert.len == (size_t)-1 || horiz.len == (size_t)-1 || cup.len <= vert.len + horiz.len)) {
+    tickit_termdrv_write_str(ttd, cup.buf, cup.len);
+    return 1;
   }
 
+  if(vert.len == (size_t)-1 || horiz.len == (size_t)-1)
+    return 0;
+
+  if(vert.len)
+    tickit_termdrv_write_str(ttd, vert.buf, vert.len);
+  if(horiz.len)
+    tickit_termdrv_write_str(ttd, horiz.buf, horiz.len);
+
   return 1;
 }
 
@@ -265,21 +506,24 @@ static void erasech(TickitTermDriver *ttd, int count, int moveend)
    * reverse-video mode. Most terminals don't do rv+ECH properly
    */
   if(td->cap.bce && !tickit_pen_get_bool_attr(tickit_termdrv_current_pen(ttd), TICKIT_PEN_REVERSE)) {
-    run_ti(ttd, td->str.ech, 1, count);
+    int line, col, cols;
+    tickit_termdrv_current_cursor(ttd, &line, &col);
+    tickit_term_get_size(ttd->tt, NULL, &cols);
+
+    if(td->str.el && moveend != 1 && col != -1 && col + count >= cols)
+      run_ti(ttd, td->str.el, 0);
+    else
+      run_ti(ttd, td->str.ech, 1, count);
 
     if(moveend == 1)
       move_rel(ttd, 0, count);
   }
   else {
-     /* TODO: consider tickit_termdrv_write_chrfill(ttd, c, n)
-     */
-    char *spaces = tickit_termdrv_get_tmpbuffer(ttd, 64);
-    memset(spaces, ' ', 64);
-    while(count > 64) {
-      tickit_termdrv_write_str(ttd, spaces, 64);
-      count -= 64;
-    }
-    tickit_termdrv_write_str(ttd, spaces, count);
+    /* A short run of spaces is no longer than its rep sequence */
+    if(td->str.rep && count > 8)
+      run_ti(ttd, td->str.rep, 2, ' ', count);
+    else
+      tickit_termdrv_write_chrfill(ttd, ' ', count);
 
     if(moveend == 0)
       move_rel(ttd, 0, -count);
@@ -344,6 +588,10 @@ static int getctl_int(TickitTermDriver *ttd, TickitTermCtl ctl, int *value)
       *value = td->cap.colours;
       return 1;
 
+    case TICKIT_TERMCTL_BCE:
+      *value = td->cap.bce;
+      return 1;
+
     default:
       return 0;
   }
@@ -455,6 +703,7 @@ static TickitTermDriver *new(const char *termtype)
   td->driver.vtable = &ti_vtable;
 
   td->ut = ut;
+  td->n_strings = 0;
 
   td->mode.mouse = 0;
   td->mode.cursorvis = 1;
@@ -463,34 +712,36 @@ static TickitTermDriver *new(const char *termtype)
   td->cap.bce = unibi_get_bool(ut, unibi_back_color_erase);
   td->cap.colours = unibi_get_num(ut, unibi_max_colors);
 
-  td->str.cup    = require_ti_string(ut, termtype, unibi_cursor_address, "cup");
-  td->str.vpa    = lookup_ti_string (ut, termtype, unibi_row_address);
-  td->str.hpa    = lookup_ti_string (ut, termtype, unibi_column_address);
-  td->str.cuu    = require_ti_string(ut, termtype, unibi_parm_up_cursor, "cuu");
-  td->str.cuu1   = lookup_ti_string (ut, termtype, unibi_cursor_up);
-  td->str.cud    = require_ti_string(ut, termtype, unibi_parm_down_cursor, "cud");
-  td->str.cud1   = lookup_ti_string (ut, termtype, unibi_cursor_down);
-  td->str.cuf    = require_ti_string(ut, termtype, unibi_parm_right_cursor, "cuf");
-  td->str.cuf1   = lookup_ti_string (ut, termtype, unibi_cursor_right);
-  td->str.cub    = require_ti_string(ut, termtype, unibi_parm_left_cursor, "cub");
-  td->str.cub1   = lookup_ti_string (ut, termtype, unibi_cursor_left);
-  td->str.ich    = require_ti_string(ut, termtype, unibi_parm_ich, "ich");
-  td->str.ich1   = lookup_ti_string (ut, termtype, unibi_insert_character);
-  td->str.dch    = require_ti_string(ut, termtype, unibi_parm_dch, "dch");
-  td->str.dch1   = lookup_ti_string (ut, termtype, unibi_delete_character);
-  td->str.il     = require_ti_string(ut, termtype, unibi_parm_insert_line, "il");
-  td->str.il1    = lookup_ti_string (ut, termtype, unibi_insert_line);
-  td->str.dl     = require_ti_string(ut, termtype, unibi_parm_delete_line, "dl");
-  td->str.dl1    = lookup_ti_string (ut, termtype, unibi_delete_line);
-  td->str.ech    = require_ti_string(ut, termtype, unibi_erase_chars, "ech");
-  td->str.ed2    = require_ti_string(ut, termtype, unibi_clear_screen, "ed2");
-  td->str.stbm   = require_ti_string(ut, termtype, unibi_change_scroll_region, "stbm");
-  td->str.sgr    = require_ti_string(ut, termtype, unibi_set_attributes, "sgr");
-  td->str.sgr_fg = require_ti_string(ut, termtype, unibi_set_a_foreground, "sgr_fg");
-  td->str.sgr_bg = require_ti_string(ut, termtype, unibi_set_a_background, "sgr_bg");
-
-  td->str.sm_csr = require_ti_string(ut, termtype, unibi_cursor_normal, "sm_csr");
-  td->str.rm_csr = require_ti_string(ut, termtype, unibi_cursor_invisible, "rm_csr");
+  td->str.cup    = compile_ti(td, require_ti_string(ut, termtype, unibi_cursor_address, "cup"));
+  td->str.vpa    = compile_ti(td, lookup_ti_string (ut, termtype, unibi_row_address));
+  td->str.hpa    = compile_ti(td, lookup_ti_string (ut, termtype, unibi_column_address));
+  td->str.cuu    = compile_ti(td, require_ti_string(ut, termtype, unibi_parm_up_cursor, "cuu"));
+  td->str.cuu1   = compile_ti(td, lookup_ti_string (ut, termtype, unibi_cursor_up));
+  td->str.cud    = compile_ti(td, require_ti_string(ut, termtype, unibi_parm_down_cursor, "cud"));
+  td->str.cud1   = compile_ti(td, lookup_ti_string (ut, termtype, unibi_cursor_down));
+  td->str.cuf    = compile_ti(td, require_ti_string(ut, termtype, unibi_parm_right_cursor, "cuf"));
+  td->str.cuf1   = compile_ti(td, lookup_ti_string (ut, termtype, unibi_cursor_right));
+  td->str.cub    = compile_ti(td, require_ti_string(ut, termtype, unibi_parm_left_cursor, "cub"));
+  td->str.cub1   = compile_ti(td, lookup_ti_string (ut, termtype, unibi_cursor_left));
+  td->str.ich    = compile_ti(td, require_ti_string(ut, termtype, unibi_parm_ich, "ich"));
+  td->str.ich1   = compile_ti(td, lookup_ti_string (ut, termtype, unibi_insert_character));
+  td->str.dch    = compile_ti(td, require_ti_string(ut, termtype, unibi_parm_dch, "dch"));
+  td->str.dch1   = compile_ti(td, lookup_ti_string (ut, termtype, unibi_delete_character));
+  td->str.il     = compile_ti(td, require_ti_string(ut, termtype, unibi_parm_insert_line, "il"));
+  td->str.il1    = compile_ti(td, lookup_ti_string (ut, termtype, unibi_insert_line));
+  td->str.dl     = compile_ti(td, require_ti_string(ut, termtype, unibi_parm_delete_line, "dl"));
+  td->str.dl1    = compile_ti(td, lookup_ti_string (ut, termtype, unibi_delete_line));
+  td->str.ech    = compile_ti(td, require_ti_string(ut, termtype, unibi_erase_chars, "ech"));
+  td->str.el     = compile_ti(td, lookup_ti_string (ut, termtype, unibi_clr_eol));
+  td->str.rep    = compile_ti(td, lookup_ti_string (ut, termtype, unibi_repeat_char));
+  td->str.ed2    = compile_ti(td, require_ti_string(ut, termtype, unibi_clear_screen, "ed2"));
+  td->str.stbm   = compile_ti(td, require_ti_string(ut, termtype, unibi_change_scroll_region, "stbm"));
+  td->str.sgr    = compile_ti(td, require_ti_string(ut, termtype, unibi_set_attributes, "sgr"));
+  td->str.sgr_fg = compile_ti(td, require_ti_string(ut, termtype, unibi_set_a_foreground, "sgr_fg"));
+  td->str.sgr_bg = compile_ti(td, require_ti_string(ut, termtype, unibi_set_a_background, "sgr_bg"));
+
+  td->str.sm_csr = compile_ti(td, require_ti_string(ut, termtype, unibi_cursor_normal, "sm_csr"));
+  td->str.rm_csr = compile_ti(td, require_ti_string(ut, termtype, unibi_cursor_invisible, "rm_csr"));
 
   const char *key_mouse = lookup_ti_string(ut, termtype, unibi_key_mouse);
   if(key_mouse && strcmp(key_mouse, "\e[M") == 0)
@@ -501,6 +752,56 @@ static TickitTermDriver *new(const char *termtype)
   return (TickitTermDriver*)td;
 }
 
+static const char *test_lookup_ti_string(unibi_term *ut, const char *name)
+{
+  for(enum unibi_string s = unibi_string_begin_ + 1; s < unibi_string_end_; s++)
+    if(strcmp(unibi_short_name_str(s), name) == 0)
+      return unibi_get_str(ut, s);
+
+  return NULL;
+}
+
+int tickit_termdrv_ti_test_expand(const char *termtype, const char *src, const int params[9],
+    char *out, size_t *outlen, char *ref, size_t *reflen, size_t size)
+{
+  unibi_term *ut = NULL;
+  int ret = -1;
+
+  if(termtype) {
+    if(!(ut = unibi_from_term(termtype)))
+      return -1;
+    if(!(src = test_lookup_ti_string(ut, src)))
+      goto out;
+  }
+
+  // Only the string table is used by compile_ti()
+  struct TIDriver td;
+  td.n_strings = 0;
+  const TIString *ts = compile_ti(&td, src);
+
+  if(ts->nfrags != -1) {
+    if(size < TI_MAXLEN)
+      goto out;
+    *outlen = expand_ti(ts, params, out);
+  }
+  else
+    *outlen = uncompiled_ti(ts, params, out, size);
+
+  unibi_var_t vars[9];
+  for(int i = 0; i < 9; i++)
+    vars[i].i = params[i];
+  *reflen = unibi_run(src, vars, ref, size);
+
+  if(*outlen <= size && *reflen <= size)
+    ret = ts->nfrags != -1;
+
+out:
+  if(ut)
+    unibi_destroy(ut);
+
+  return ret;
+}
+
 #else /* not HAVE_UNIBILIUM */
 
 static TickitTermDriver *new(const char *termtype)
@@ -508,6 +809,12 @@ static TickitTermDriver *new(const char *termtype)
   return NULL;
 }
 
+int tickit_termdrv_ti_test_expand(const char *termtype, const char *src, const int params[9],
+    char *out, size_t *outlen, char *ref, size_t *reflen, size_t size)
+{
+  return -1;
+}
+
 #endif
 
 TickitTermDriverProbe tickit_termdrv_probe_ti = {
@@ -19,11 +19,13 @@ struct XTermDriver {
     unsigned int cursorshape:2;
     unsigned int mouse:2;
     unsigned int keypad:1;
+    unsigned int syncoutput:1;
   } mode;
 
   struct {
     unsigned int cursorshape:1;
     unsigned int slrm:1;
+    unsigned int syncoutput:1;
   } cap;
 
   struct {
@@ -39,18 +41,97 @@ static void print(TickitTermDriver *ttd, const char *str, size_t len)
   tickit_termdrv_write_str(ttd, str, len);
 }
 
+/* Formats into buf the shortest sequence that moves the cursor along its line
+ * from column from (-1 if unknown) to column to, returning its length
+ */
+static size_t fmt_move_col(char *buf, int from, int to)
+{
+  char alt[16];
+  size_t len, altlen;
+
+  if(from == to)
+    return 0;
+
+  if(to == 0) {
+    buf[0] = '\r';
+    return 1;
+  }
+
+  len = sprintf(buf, "\e[%dG", to+1);                /* HPA */
+
+  altlen = 1 + (to == 1 ? sprintf(alt + 1, "\e[C") :  /* CR + CUF */
+                          sprintf(alt + 1, "\e[%dC", to));
+  alt[0] = '\r';
+  if(altlen < len)
+    memcpy(buf, alt, len = altlen);
+
+  if(from == -1)
+    return len;
+
+  if(to > from)
+    altlen = (to - from == 1) ? sprintf(alt, "\e[C") :
+                                sprintf(alt, "\e[%dC", to - from);
+  else if(from - to <= 3)
+    memset(alt, '\b', altlen = from - to);
+  else
+    altlen = sprintf(alt, "\e[%dD", from - to);
+  if(altlen < len)
+    memcpy(buf, alt, len = altlen);
+
+  return len;
+}
+
+/* As fmt_move_col() but between lines, staying in the same column */
+static size_t fmt_move_line(char *buf, int from, int to)
+{
+  char alt[16];
+  size_t len, altlen;
+
+  if(from == to)
+    return 0;
+
+  len = sprintf(buf, "\e[%dd", to+1);                /* VPA */
+
+  if(from == -1)
+    return len;
+
+  if(to > from)
+    altlen = (to - from == 1) ? sprintf(alt, "\e[B") :
+                                sprintf(alt, "\e[%dB", to - from);
+  else
+    altlen = (from - to == 1) ? sprintf(alt, "\e[A") :
+                                sprintf(alt, "\e[%dA", from - to);
+  if(altlen < len)
+    memcpy(buf, alt, len = altlen);
+
+  return len;
+}
+
 static int goto_abs(TickitTermDriver *ttd, int line, int col)
 {
-  if(line != -1 && col > 0)
-    tickit_termdrv_write_strf(ttd, "\e[%d;%dH", line+1, col+1);
-  else if(line != -1 && col == 0)
-    tickit_termdrv_write_strf(ttd, "\e[%dH", line+1);
-  else if(line != -1)
-    tickit_termdrv_write_strf(ttd, "\e[%dd", line+1);
-  else if(col > 0)
-    tickit_termdrv_write_strf(ttd, "\e[%dG", col+1);
-  else if(col != -1)
-    tickit_termdrv_write_str(ttd, "\e[G", 3);
+  int curline, curcol;
+  tickit_termdrv_current_cursor(ttd, &curline, &curcol);
+
+  /* Vertical motions keep the column, so these can be considered separately
+   * and then compared with a CUP that sets both */
+  char buf[48];
+  size_t len = 0;
+
+  if(line != -1)
+    len += fmt_move_line(buf, curline, line);
+  if(col != -1)
+    len += fmt_move_col(buf + len, curcol, col);
+
+  if(line != -1 && col != -1) {
+    char cup[32];
+    size_t cuplen = col > 0 ? snprintf(cup, sizeof cup, "\e[%d;%dH", line+1, col+1) :
+                              snprintf(cup, sizeof cup, "\e[%dH", line+1);
+    if(cuplen <= len)
+      memcpy(buf, cup, len = cuplen);
+  }
+
+  if(len)
+    tickit_termdrv_write_str(ttd, buf, len);
 
   return 1;
 }
@@ -161,7 +242,14 @@ static void erasech(TickitTermDriver *ttd, int count, int moveend)
    * properly
    */
   if(!tickit_pen_get_bool_attr(tickit_termdrv_current_pen(ttd), TICKIT_PEN_REVERSE)) {
-    if(count == 1)
+    int line, col, cols;
+    tickit_termdrv_current_cursor(ttd, &line, &col);
+    tickit_term_get_size(ttd->tt, NULL, &cols);
+
+    /* EL is shorter when the erase reaches the right margin anyway */
+    if(moveend != 1 && col != -1 && col + count >= cols)
+      tickit_termdrv_write_str(ttd, "\e[K", 3);
+    else if(count == 1)
       tickit_termdrv_write_str(ttd, "\e[X", 3);
     else
       tickit_termdrv_write_strf(ttd, "\e[%dX", count);
@@ -170,15 +258,7 @@ static void erasech(TickitTermDriver *ttd, int count, int moveend)
       move_rel(ttd, 0, count);
   }
   else {
-     /* TODO: consider tickit_termdrv_write_chrfill(ttd, c, n)
-     */
-    char *spaces = tickit_termdrv_get_tmpbuffer(ttd, 64);
-    memset(spaces, ' ', 64);
-    while(count > 64) {
-      tickit_termdrv_write_str(ttd, spaces, 64);
-      count -= 64;
-    }
-    tickit_termdrv_write_str(ttd, spaces, count);
+    tickit_termdrv_write_chrfill(ttd, ' ', count);
 
     if(moveend == 0)
       move_rel(ttd, 0, -count);
@@ -202,13 +282,63 @@ static struct SgrOnOff { int on, off; } sgr_onoff[] = {
   {  5, 25 }, /* blink */
 };
 
+/* Every parameter chpen() normally emits is below 256, so each of those is
+ * kept ready-formatted with its trailing separator
+ */
+#define SGR_PARAM10(p)  { p "0;" }, { p "1;" }, { p "2;" }, { p "3;" }, { p "4;" }, \
+                        { p "5;" }, { p "6;" }, { p "7;" }, { p "8;" }, { p "9;" }
+#define SGR_PARAM100(p) SGR_PARAM10(p "0"), SGR_PARAM10(p "1"), SGR_PARAM10(p "2"), \
+                        SGR_PARAM10(p "3"), SGR_PARAM10(p "4"), SGR_PARAM10(p "5"), \
+                        SGR_PARAM10(p "6"), SGR_PARAM10(p "7"), SGR_PARAM10(p "8"), \
+                        SGR_PARAM10(p "9")
+
+/* Not NUL-terminated; "255;" fills all four bytes */
+static const struct SgrParam { char s[4]; } sgr_params[256] = {
+  SGR_PARAM10(""),
+  SGR_PARAM10("1"), SGR_PARAM10("2"), SGR_PARAM10("3"), SGR_PARAM10("4"),
+  SGR_PARAM10("5"), SGR_PARAM10("6"), SGR_PARAM10("7"), SGR_PARAM10("8"),
+  SGR_PARAM10("9"),
+  SGR_PARAM100("1"),
+  SGR_PARAM10("20"), SGR_PARAM10("21"), SGR_PARAM10("22"), SGR_PARAM10("23"),
+  SGR_PARAM10("24"),
+  { "250;" }, { "251;" }, { "252;" }, { "253;" }, { "254;" }, { "255;" },
+};
+
+#undef SGR_PARAM10
+#undef SGR_PARAM100
+
+/* Appends a decimal SGR parameter and its trailing separator */
+static char *put_sgr_param(char *s, unsigned int v)
+{
+  if(v < 256) {
+    memcpy(s, sgr_params[v].s, 4);
+    return s + (v < 10 ? 2 : v < 100 ? 3 : 4);
+  }
+
+  char digits[10];
+  int n = 0;
+
+  do {
+    digits[n++] = '0' + v % 10;
+    v /= 10;
+  } while(v);
+
+  while(n)
+    *s++ = digits[--n];
+  /* TODO: Work out what terminals support :s */
+  *s++ = ';';
+
+  return s;
+}
+
 static void chpen(TickitTermDriver *ttd, const TickitPen *delta, const TickitPen *final)
 {
   /* There can be at most 12 SGR parameters; 3 from each of 2 colours, and
-   * 6 single attributes
+   * 6 single attributes. Each is at most 10 digits plus a separator
    */
-  int params[12];
-  int pindex = 0;
+  char buffer[3 + 12 * 11];
+  char *s = buffer + 2; /* after ESC [ */
+  int any = 0;
 
   for(TickitPenAttr attr = 0; attr < TICKIT_N_PEN_ATTRS; attr++) {
     if(!tickit_pen_has_attr(delta, attr))
@@ -217,30 +347,31 @@ static void chpen(TickitTermDriver *ttd, const TickitPen *delta, const TickitPen
     struct SgrOnOff *onoff = &sgr_onoff[attr];
 
     int val;
+    any = 1;
 
     switch(attr) {
     case TICKIT_PEN_FG:
     case TICKIT_PEN_BG:
       val = tickit_pen_get_colour_attr(delta, attr);
       if(val < 0)
-        params[pindex++] = onoff->off;
+        s = put_sgr_param(s, onoff->off);
       else if(val < 8)
-        params[pindex++] = onoff->on + val;
+        s = put_sgr_param(s, onoff->on + val);
       else if(val < 16)
-        params[pindex++] = onoff->on+60 + val-8;
+        s = put_sgr_param(s, onoff->on+60 + val-8);
       else {
-        params[pindex++] = (onoff->on+8) | 0x80000000;
-        params[pindex++] = 5 | 0x80000000;
-        params[pindex++] = val;
+        s = put_sgr_param(s, onoff->on+8);
+        *s++ = '5'; *s++ = ';';
+        s = put_sgr_param(s, val);
       }
       break;
 
     case TICKIT_PEN_ALTFONT:
       val = tickit_pen_get_int_attr(delta, attr);
       if(val < 0 || val >= 10)
-        params[pindex++] = onoff->off;
+        s = put_sgr_param(s, onoff->off);
       else
-        params[pindex++] = onoff->on + val;
+        s = put_sgr_param(s, onoff->on + val);
       break;
 
     case TICKIT_PEN_BOLD:
@@ -250,7 +381,7 @@ static void chpen(TickitTermDriver *ttd, const TickitPen *delta, const TickitPen
     case TICKIT_PEN_STRIKE:
     case TICKIT_PEN_BLINK:
       val = tickit_pen_get_bool_attr(delta, attr);
-      params[pindex++] = val ? onoff->on : onoff->off;
+      s = put_sgr_param(s, val ? onoff->on : onoff->off);
       break;
 
     case TICKIT_N_PEN_ATTRS:
@@ -258,33 +389,20 @@ static void chpen(TickitTermDriver *ttd, const TickitPen *delta, const TickitPen
     }
   }
 
-  if(pindex == 0)
+  if(!any)
     return;
 
   /* If we're going to clear all the attributes then empty SGR is neater */
   if(!tickit_pen_is_nondefault(final))
-    pindex = 0;
-
-  /* Render params[] into a CSI string */
-
-  size_t len = 3; /* ESC [ ... m */
-  for(int i = 0; i < pindex; i++)
-    len += snprintf(NULL, 0, "%d", params[i]&0x7fffffff) + 1;
-  if(pindex > 0)
-    len--; /* Last one has no final separator */
+    s = buffer + 2;
+  else
+    s--; /* Last one has no final separator */
 
-  char *buffer = tickit_termdrv_get_tmpbuffer(ttd, len + 1);
-  char *s = buffer;
+  buffer[0] = '\e';
+  buffer[1] = '[';
+  *s++ = 'm';
 
-  s += sprintf(s, "\e[");
-  for(int i = 0; i < pindex-1; i++)
-    /* TODO: Work out what terminals support :s */
-    s += sprintf(s, "%d%c", params[i]&0x7fffffff, ';');
-  if(pindex > 0)
-    s += sprintf(s, "%d", params[pindex-1]&0x7fffffff);
-  sprintf(s, "m");
-
-  tickit_termdrv_write_str(ttd, buffer, len);
+  tickit_termdrv_write_str(ttd, buffer, s - buffer);
 }
 
 static int getctl_int(TickitTermDriver *ttd, TickitTermCtl ctl, int *value)
@@ -320,6 +438,14 @@ static int getctl_int(TickitTermDriver *ttd, TickitTermCtl ctl, int *value)
       *value = 256;
       return 1;
 
+    case TICKIT_TERMCTL_SYNC_OUTPUT:
+      *value = xd->mode.syncoutput;
+      return 1;
+
+    case TICKIT_TERMCTL_BCE:
+      *value = 1;
+      return 1;
+
     default:
       return 0;
   }
@@ -398,6 +524,16 @@ static int setctl_int(TickitTermDriver *ttd, TickitTermCtl ctl, int value)
       tickit_termdrv_write_strf(ttd, value ? "\e=" : "\e>");
       return 1;
 
+    case TICKIT_TERMCTL_SYNC_OUTPUT:
+      if(!xd->mode.syncoutput == !value)
+        return 1;
+
+      /* Terminals that don't implement it would only get confused */
+      if(xd->cap.syncoutput)
+        tickit_termdrv_write_str(ttd, value ? "\e[?2026h" : "\e[?2026l", 0);
+      xd->mode.syncoutput = !!value;
+      return 1;
+
     default:
       return 0;
   }
@@ -434,6 +570,9 @@ static void start(TickitTermDriver *ttd)
   // Also query the current cursor visibility, blink status, and shape
   tickit_termdrv_write_strf(ttd, "\e[?25$p\e[?12$p\eP$q q\e\\");
 
+  // Find out if synchronized output is supported
+  tickit_termdrv_write_strf(ttd, "\e[?2026$p");
+
   /* Some terminals (e.g. xfce4-terminal) don't understand DECRQM and print
    * the raw bytes directly as output, while still claiming to be TERM=xterm
    * It doens't hurt at this point to clear the current line just in case.
@@ -470,6 +609,10 @@ static void gotkey_modereport(struct XTermDriver *xd, int initial, int mode, int
           xd->cap.slrm = 1;
         xd->initialised.slrm = 1;
         break;
+      case 2026: // Synchronized output
+        if(value == 1 || value == 2)
+          xd->cap.syncoutput = 1;
+        break;
     }
 }
 
@@ -539,6 +682,8 @@ static void stop(TickitTermDriver *ttd)
 {
   struct XTermDriver *xd = (struct XTermDriver *)ttd;
 
+  if(xd->mode.syncoutput)
+    setctl_int(ttd, TICKIT_TERMCTL_SYNC_OUTPUT, 0);
   if(xd->mode.mouse)
     setctl_int(ttd, TICKIT_TERMCTL_MOUSE, TICKIT_TERM_MOUSEMODE_OFF);
   if(!xd->mode.cursorvis)
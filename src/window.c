@@ -0,0 +1,415 @@
+#include "tickit.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+struct TickitWindow {
+  TickitWindow  *parent;
+
+  /* In z-order, front-most first */
+  TickitWindow **children;
+  size_t         n_children;
+  size_t         size_children;
+
+  TickitRect     rect; /* relative to parent */
+  unsigned int   visible : 1;
+
+  TickitPen     *pen; /* not owned */
+
+  TickitWindowExposeFn *on_expose;
+  void                 *on_expose_data;
+
+  /* occlusion[i], once built, maps what the front-most i children cover */
+  struct Occlusion **occlusion;
+  size_t             n_occlusion;
+};
+
+/* For each line of the window, the sorted disjoint [start,end) column spans
+ * covered by some set of its visible children
+ */
+struct Occlusion {
+  size_t *linestart; /* lines+1 offsets into spans */
+  int    *spans;     /* start,end pairs */
+};
+
+static void invalidate_occlusion(TickitWindow *win)
+{
+  if(!win || !win->occlusion)
+    return;
+
+  for(size_t i = 0; i < win->n_occlusion; i++)
+    if(win->occlusion[i]) {
+      free(win->occlusion[i]->linestart);
+      free(win->occlusion[i]->spans);
+      free(win->occlusion[i]);
+    }
+
+  free(win->occlusion);
+  win->occlusion = NULL;
+  win->n_occlusion = 0;
+}
+
+TickitWindow *tickit_window_new(TickitWindow *parent, int top, int left, int lines, int cols)
+{
+  TickitWindow *win = malloc(sizeof(TickitWindow));
+  if(!win)
+    return NULL;
+
+  win->parent = parent;
+
+  win->children = NULL;
+  win->n_children = 0;
+  win->size_children = 0;
+
+  tickit_rect_init_sized(&win->rect, top, left, lines, cols);
+  win->visible = 1;
+
+  win->pen = NULL;
+
+  win->on_expose = NULL;
+  win->on_expose_data = NULL;
+
+  win->occlusion = NULL;
+  win->n_occlusion = 0;
+
+  return win;
+}
+
+/* Takes win out of its parent's children, though it stays the parent */
+static void unlink_child(TickitWindow *win)
+{
+  TickitWindow *parent = win->parent;
+  if(!parent)
+    return;
+
+  for(size_t i = 0; i < parent->n_children; i++)
+    if(parent->children[i] == win) {
+      memmove(parent->children + i, parent->children + i + 1,
+          (parent->n_children - i - 1) * sizeof(parent->children[0]));
+      parent->n_children--;
+      break;
+    }
+
+  invalidate_occlusion(parent);
+}
+
+void tickit_window_destroy(TickitWindow *win)
+{
+  unlink_child(win);
+
+  for(size_t i = 0; i < win->n_children; i++)
+    win->children[i]->parent = NULL;
+  free(win->children);
+
+  invalidate_occlusion(win);
+
+  free(win);
+}
+
+TickitWindow *tickit_window_parent(const TickitWindow *win)
+{
+  return win->parent;
+}
+
+TickitWindow *tickit_window_root(const TickitWindow *win)
+{
+  while(win->parent)
+    win = win->parent;
+  return (TickitWindow *)win;
+}
+
+size_t tickit_window_children(const TickitWindow *win)
+{
+  return win->n_children;
+}
+
+size_t tickit_window_get_children(const TickitWindow *win, TickitWindow *children[], size_t n)
+{
+  if(n > win->n_children)
+    n = win->n_children;
+
+  memcpy(children, win->children, n * sizeof(children[0]));
+  return n;
+}
+
+int tickit_window_insert_child(TickitWindow *win, TickitWindow *child, int index)
+{
+  if(win->n_children + 1 > win->size_children) {
+    size_t size = win->size_children ? win->size_children * 2 : 4;
+    TickitWindow **newchildren = realloc(win->children, size * sizeof(win->children[0]));
+    if(!newchildren)
+      return 0;
+
+    win->children = newchildren;
+    win->size_children = size;
+  }
+
+  unlink_child(child);
+
+  if(index < 0 || index > win->n_children)
+    index = win->n_children;
+
+  memmove(win->children + index + 1, win->children + index,
+      (win->n_children - index) * sizeof(win->children[0]));
+  win->children[index] = child;
+  win->n_children++;
+
+  invalidate_occlusion(win);
+  child->parent = win;
+  return 1;
+}
+
+void tickit_window_remove_child(TickitWindow *win, TickitWindow *child)
+{
+  if(child->parent == win)
+    unlink_child(child);
+}
+
+void tickit_window_get_geometry(const TickitWindow *win, TickitRect *rect)
+{
+  *rect = win->rect;
+}
+
+void tickit_window_set_geometry(TickitWindow *win, const TickitRect *rect)
+{
+  win->rect = *rect;
+
+  invalidate_occlusion(win);
+  invalidate_occlusion(win->parent);
+}
+
+int tickit_window_is_visible(const TickitWindow *win)
+{
+  return win->visible;
+}
+
+void tickit_window_set_visible(TickitWindow *win, int visible)
+{
+  if(win->visible == !!visible)
+    return;
+
+  win->visible = !!visible;
+
+  invalidate_occlusion(win->parent);
+}
+
+void tickit_window_set_pen(TickitWindow *win, TickitPen *pen)
+{
+  win->pen = pen;
+}
+
+void tickit_window_set_on_expose(TickitWindow *win, TickitWindowExposeFn *fn, void *data)
+{
+  win->on_expose = fn;
+  win->on_expose_data = data;
+}
+
+static void expose_walk(TickitWindow *win, TickitRenderBuffer *rb, const TickitRect *rect)
+{
+  if(win->pen)
+    tickit_renderbuffer_setpen(rb, win->pen);
+
+  for(size_t i = 0; i < win->n_children; i++) {
+    TickitWindow *child = win->children[i];
+    if(!child->visible)
+      continue;
+
+    TickitRect childrect;
+    if(tickit_rect_intersect(&childrect, rect, &child->rect)) {
+      tickit_renderbuffer_save(rb);
+
+      tickit_renderbuffer_clip(rb, &childrect);
+      tickit_renderbuffer_translate(rb, child->rect.top, child->rect.left);
+
+      childrect.top  -= child->rect.top;
+      childrect.left -= child->rect.left;
+      expose_walk(child, rb, &childrect);
+
+      tickit_renderbuffer_restore(rb);
+    }
+
+    /* Whatever the child covers its parent, and any siblings below it, must
+     * not draw over */
+    tickit_renderbuffer_mask(rb, &child->rect);
+  }
+
+  if(win->on_expose) {
+    tickit_renderbuffer_save(rb);
+
+    (*win->on_expose)(win, rb, rect, win->on_expose_data);
+
+    tickit_renderbuffer_restore(rb);
+  }
+}
+
+void tickit_window_render_rect(TickitWindow *win, TickitRenderBuffer *rb, const TickitRect *rect)
+{
+  tickit_renderbuffer_save(rb);
+
+  TickitRect clip = *rect;
+  tickit_renderbuffer_clip(rb, &clip);
+
+  expose_walk(win, rb, rect);
+
+  tickit_renderbuffer_restore(rb);
+}
+
+static int cmpspan(const void *a, const void *b)
+{
+  const int *sa = a, *sb = b;
+  return (sa[0] > sb[0]) - (sa[0] < sb[0]);
+}
+
+static struct Occlusion *build_occlusion(const TickitWindow *win, size_t limit)
+{
+  int lines = win->rect.lines;
+
+  struct Occlusion *occ = malloc(sizeof(struct Occlusion));
+  int *line_spans = malloc((limit ? limit : 1) * 2 * sizeof(int));
+  if(!occ || !line_spans)
+    goto abort;
+
+  occ->linestart = malloc((lines + 1) * sizeof(occ->linestart[0]));
+  occ->spans = NULL;
+  if(!occ->linestart)
+    goto abort;
+
+  size_t n = 0, size = 0;
+
+  for(int line = 0; line < lines; line++) {
+    occ->linestart[line] = n;
+
+    size_t nline = 0;
+    for(size_t i = 0; i < limit; i++) {
+      const TickitWindow *child = win->children[i];
+      if(!child->visible ||
+         child->rect.top > line || tickit_rect_bottom(&child->rect) <= line)
+        continue;
+
+      line_spans[2*nline]     = child->rect.left;
+      line_spans[2*nline + 1] = tickit_rect_right(&child->rect);
+      nline++;
+    }
+
+    if(!nline)
+      continue;
+
+    qsort(line_spans, nline, 2 * sizeof(int), cmpspan);
+
+    if(n + 2 * nline > size) {
+      size_t newsize = size ? size : 16;
+      while(newsize < n + 2 * nline)
+        newsize *= 2;
+
+      int *newspans = realloc(occ->spans, newsize * sizeof(int));
+      if(!newspans)
+        goto abort;
+
+      occ->spans = newspans;
+      size = newsize;
+    }
+
+    /* Merge touching or overlapping spans */
+    size_t first = n;
+    for(size_t i = 0; i < nline; i++) {
+      int start = line_spans[2*i], end = line_spans[2*i + 1];
+      if(n > first && start <= occ->spans[n - 1]) {
+        if(end > occ->spans[n - 1])
+          occ->spans[n - 1] = end;
+      }
+      else {
+        occ->spans[n++] = start;
+        occ->spans[n++] = end;
+      }
+    }
+  }
+  occ->linestart[lines] = n;
+
+  free(line_spans);
+  return occ;
+
+abort:
+  if(occ) {
+    free(occ->linestart);
+    free(occ->spans);
+  }
+  free(occ);
+  free(line_spans);
+  return NULL;
+}
+
+static struct Occlusion *get_occlusion(TickitWindow *win, size_t limit)
+{
+  if(!win->occlusion) {
+    win->occlusion = calloc(win->n_children + 1, sizeof(win->occlusion[0]));
+    if(!win->occlusion)
+      return NULL;
+    win->n_occlusion = win->n_children + 1;
+  }
+
+  if(!win->occlusion[limit])
+    win->occlusion[limit] = build_occlusion(win, limit);
+
+  return win->occlusion[limit];
+}
+
+int tickit_window_get_span_visibility(TickitWindow *win, int line, int col, int *lenp)
+{
+  int vis = 1, len = win->rect.cols - col;
+  TickitWindow *prev = NULL;
+
+  for(; win; prev = win, win = win->parent) {
+    /* Off top, bottom or right: invisible and always going to be */
+    if(line < 0 || line >= win->rect.lines || col >= win->rect.cols) {
+      *lenp = -1;
+      return 0;
+    }
+
+    /* Off left: invisible for at least as far as it's off by */
+    if(col < 0) {
+      if(vis || -col > len)
+        len = -col;
+      vis = 0;
+    }
+    /* Within the window - visible for at most the width of the window */
+    else if(vis && len > win->rect.cols - col)
+      len = win->rect.cols - col;
+
+    /* Only the siblings in front of the window we came up through hide it */
+    size_t limit = win->n_children;
+    if(prev)
+      for(limit = 0; limit < win->n_children; limit++)
+        if(win->children[limit] == prev)
+          break;
+
+    struct Occlusion *occ = limit ? get_occlusion(win, limit) : NULL;
+    if(occ) {
+      size_t lo = occ->linestart[line] / 2, hi = occ->linestart[line + 1] / 2;
+      size_t end = hi;
+
+      /* Find the first span ending to the right of col */
+      while(lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if(occ->spans[2*mid + 1] > col)
+          hi = mid;
+        else
+          lo = mid + 1;
+      }
+
+      if(lo < end && occ->spans[2*lo] <= col) {
+        int hidden = occ->spans[2*lo + 1] - col;
+        if(vis || hidden > len)
+          len = hidden;
+        vis = 0;
+      }
+      else if(lo < end && vis && occ->spans[2*lo] - col < len)
+        len = occ->spans[2*lo] - col;
+    }
+
+    line += win->rect.top;
+    col  += win->rect.left;
+  }
+
+  *lenp = len;
+  return vis;
+}
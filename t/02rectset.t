@@ -51,6 +51,27 @@ use Tickit::Rect;
    ok( !$rectset->contains( Tickit::Rect->new( top => 6, left => 15, bottom => 9, right => 25 ) ), '$rectset no contains non-intersect' );
 }
 
+# Canonical form
+{
+   my $by_rows = Tickit::RectSet->new;
+   $by_rows->add( Tickit::Rect->new( top => $_, left => 0, lines => 1, cols => 10 ) ) for 0 .. 4;
+   $by_rows->add( Tickit::Rect->new( top => 2, left => 20, lines => 1, cols => 5 ) );
+
+   my $by_cols = Tickit::RectSet->new;
+   $by_cols->add_many( map { Tickit::Rect->new( top => 0, left => $_, lines => 5, cols => 1 ) } reverse 0 .. 9 );
+   $by_cols->add( Tickit::Rect->new( top => 2, left => 20, lines => 1, cols => 5 ) );
+
+   is_deeply( [ $by_cols->rects ], [ $by_rows->rects ],
+              'Equal regions give the same rects however they were built' );
+
+   is_deeply( [ $by_rows->rects ],
+              [ Tickit::Rect->new( top => 0, left =>  0, lines => 2, cols => 10 ),
+                Tickit::Rect->new( top => 2, left =>  0, lines => 1, cols => 10 ),
+                Tickit::Rect->new( top => 2, left => 20, lines => 1, cols =>  5 ),
+                Tickit::Rect->new( top => 3, left =>  0, lines => 2, cols => 10 ) ],
+              'Regions are split into bands' );
+}
+
 sub _newrect
 {
    local $_ = shift;
@@ -85,6 +106,11 @@ while( <DATA> ) {
       $rectset->add( $_ ) for reverse @inputrects;
 
       is_deeply( [ $rectset->rects ], \@outputrects, "Output for $name $input reversed" );
+
+      $rectset = Tickit::RectSet->new;
+      $rectset->add_many( @inputrects );
+
+      is_deeply( [ $rectset->rects ], \@outputrects, "Output for $name $input by add_many" );
    }
    if( $method eq "subtract" ) {
       my $rectset = Tickit::RectSet->new;
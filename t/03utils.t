@@ -29,6 +29,8 @@ use Tickit::Utils qw(
    string_countmore
 
    textwidth
+   ambiguous_width
+   set_ambiguous_width
    chars2cols
    cols2chars
    substrwidth
@@ -74,6 +76,8 @@ use Tickit::StringPos;
 
 is( textwidth( "" ),            0, 'textwidth empty' );
 is( textwidth( "ABC" ),         3, 'textwidth ASCII' );
+is( textwidth( "A" x 100 ),   100, 'textwidth long ASCII' );
+is( textwidth( ( "A" x 40 ) . "\x1b" ), undef, 'C0 control after long ASCII run is invalid for textwidth' );
 SKIP: {
    skip "No Unicode", 6 unless CAN_UNICODE;
 
@@ -90,6 +94,19 @@ SKIP: {
    is( textwidth( "\x7f" ), undef, 'DEL is invalid for textwidth' );
 }
 
+SKIP: {
+   skip "No Unicode", 4 unless CAN_UNICODE;
+
+   is( textwidth( "\x{1F600}" ), 2, 'Emoji presentation character counts as width 2' );
+
+   is( ambiguous_width, 1, 'ambiguous_width is 1 by default' );
+   is( textwidth( "\x{B1}\x{3B1}" ), 2, 'Ambiguous width characters count as width 1' );
+
+   set_ambiguous_width( 2 );
+   is( textwidth( "\x{B1}\x{3B1}" ), 4, 'Ambiguous width characters count as width 2 after set_ambiguous_width' );
+   set_ambiguous_width( 1 );
+}
+
 is_deeply( [ chars2cols "ABC", 0, 1, 3, 4 ],
            [ 0, 1, 3, 3 ],
            'chars2cols ASCII' );
@@ -145,10 +162,12 @@ is( scalar cols2chars( "ABC", 4 ), 3, 'scalar cols2chars past EOS' );
 is( substrwidth( "ABC", 0, 1 ), "A", 'substrwidth ASCII' );
 is( substrwidth( "ABC", 2 ),    "C", 'substrwidth ASCII trail' );
 SKIP: {
-   skip "No Unicode", 2 unless CAN_UNICODE;
+   skip "No Unicode", 3 unless CAN_UNICODE;
 
    is( substrwidth( "cafe\x{301} table", 0, 4 ), "cafe\x{301}", 'substrwidth combining within' );
    is( substrwidth( "cafe\x{301} table", 5, 5 ), "table", 'substrwidth combining after' );
+   is( substrwidth( ( "x" x 20 ) . "e\x{301}" . ( "y" x 20 ), 0, 21 ), ( "x" x 20 ) . "e\x{301}",
+      'substrwidth combining after long ASCII run' );
 }
 
 is_deeply( [ align 10, 30, 0.0 ], [  0, 10, 20 ], 'align 10 in 30 by 0.0' );
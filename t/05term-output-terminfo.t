@@ -0,0 +1,62 @@
+#!/usr/bin/perl
+
+use strict;
+use warnings;
+
+use Test::More;
+use Test::HexString;
+
+use Tickit::Term;
+
+# The terminfo driver compiles simple strings into templates; each must expand
+# to exactly what unibilium's own interpreter gives
+sub expand_is
+{
+   my ( $termtype, $src, $params, $compiled, $name ) = @_;
+
+   my ( $was_compiled, $out, $ref ) = Tickit::Term::_ti_test_expand( $termtype, $src, @$params );
+
+   is_hexstr( $out, $ref, $name );
+   is( $was_compiled, $compiled, "$name is " . ( $compiled ? "compiled" : "left for unibi_run" ) )
+      if defined $compiled;
+}
+
+plan skip_all => "Tickit is not built with unibilium"
+   unless Tickit::Term::_ti_test_expand( undef, "x" );
+
+# Strings given directly
+{
+   expand_is( undef, "\e[%p1%dX", [ 5 ], 1, 'single parameter' );
+   expand_is( undef, "\e[%p1%dX", [ -5 ], 1, 'negative parameter' );
+   expand_is( undef, "\e[%p1%d;%p2%dH", [ 3, 12345 ], 1, 'two parameters' );
+   expand_is( undef, "\e[%p2%d;%p1%dH", [ 3, 4 ], 1, 'parameters out of order' );
+   expand_is( undef, "\e[%i%p1%d;%p2%d;%p3%dx", [ 0, 9, 9 ], 1, '%i increments only the first two' );
+   expand_is( undef, "\e[%p1%d%%", [ 50 ], 1, '%% gives a literal %' );
+   expand_is( undef, "\e[?25l", [], 1, 'no parameters' );
+
+   expand_is( undef, "%p1%d;%p2%d;%p3%d;%p4%d;%p5%d", [ 1, 2, 3, 4, 5 ], 0, 'too many parameter slots' );
+   expand_is( undef, ( "x" x 40 ) . "%p1%d", [ 1 ], 0, 'too many literal bytes' );
+   expand_is( undef, "\e[%p1%dA\$<5>", [ 2 ], 0, 'padding' );
+   expand_is( undef, "\e[%?%p1%t1%e0%;m", [ 1 ], 0, 'conditional' );
+}
+
+# Strings from a real terminal entry
+SKIP: {
+   skip "No terminfo entry for xterm", 1
+      unless Tickit::Term::_ti_test_expand( "xterm", "cup", 0, 0 );
+
+   expand_is( "xterm", "cup", [ 0, 0 ], 1, 'xterm cup at origin' );
+   expand_is( "xterm", "cup", [ 24, 79 ], undef, 'xterm cup at bottom right' );
+   expand_is( "xterm", "hpa", [ 10 ], undef, 'xterm hpa' );
+   expand_is( "xterm", "vpa", [ 5 ], undef, 'xterm vpa' );
+   expand_is( "xterm", "ech", [ 20 ], undef, 'xterm ech' );
+   expand_is( "xterm", "cuu", [ 3 ], undef, 'xterm cuu' );
+   expand_is( "xterm", "cud", [ 100 ], undef, 'xterm cud' );
+   expand_is( "xterm", "cuf", [ 7 ], undef, 'xterm cuf' );
+   expand_is( "xterm", "cub", [ 1 ], undef, 'xterm cub' );
+
+   # Colour selection is conditional on the colour number
+   expand_is( "xterm", "setaf", [ $_ ], 0, "xterm setaf $_" ) for 1, 9, 196;
+}
+
+done_testing;
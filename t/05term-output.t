@@ -29,6 +29,8 @@ sub stream_is
 my $writer = bless [], "TestWriter";
 sub TestWriter::write { $stream .= $_[1] }
 
+sub BufWriter::write { ${$_[0]} .= $_[1] }
+
 my $term = Tickit::Term->new( writer => $writer );
 $term->set_size( 25, 80 );
 
@@ -42,7 +44,7 @@ stream_is( "\e[1H", '$term->goto( 0, 0 )' );
 
 $stream = "";
 $term->goto( 1, undef );
-stream_is( "\e[2d", '$term->goto( 1 )' );
+stream_is( "\e[B", '$term->goto( 1 ) moves relatively from a known position' );
 
 $stream = "";
 $term->goto( undef, 2 );
@@ -56,6 +58,24 @@ $stream = "";
 $term->move( undef, 7 );
 stream_is( "\e[7C", '$term->move( 4, undef )' );
 
+$stream = "";
+$term->goto( 5, 7 );
+stream_is( "\b\b", '$term->goto( 5, 7 ) uses backspace for short leftward motion' );
+
+$stream = "";
+$term->goto( 5, 7 );
+stream_is( "", '$term->goto( 5, 7 ) again outputs nothing' );
+
+$stream = "";
+$term->print( "ABC" );
+$term->goto( 6, 0 );
+stream_is( "ABC\e[7H", '$term->goto( 6, 0 ) after print' );
+
+$stream = "";
+$term->print( "ABC" );
+$term->goto( 6, 4 );
+stream_is( "ABC\e[C", '$term->goto( 6, 4 ) after print moves relatively' );
+
 $stream = "";
 $term->scrollrect( 3, 0, 7, 80, 3, 0 );
 stream_is( "\e[4;10r\e[4H\e[3M\e[r", '$term->scrollrect( 3,0,7,80, 3,0 )' );
@@ -91,6 +111,14 @@ $stream = "";
 $term->chpen( b => 0 );
 stream_is( "\e[m", '$term->chpen( b => 0 )' );
 
+$stream = "";
+$term->chpen( fg => 12, bg => 200, u => 1 );
+stream_is( "\e[94;48;5;200;4m", '$term->chpen( fg => 12, bg => 200, u => 1 )' );
+
+$stream = "";
+$term->chpen( fg => undef, bg => undef, u => undef );
+stream_is( "\e[m", '$term->chpen clearing all attributes' );
+
 $stream = "";
 $term->print( "Hello" );
 stream_is( "Hello", '$term->print' );
@@ -104,6 +132,10 @@ $stream = "";
 $term->clear;
 stream_is( "\e[2J", '$term->clear' );
 
+$stream = "";
+$term->goto( 1, undef );
+stream_is( "\e[2d", '$term->goto( 1 ) after clear does not assume cursor position' );
+
 $term->setpen( Tickit::Pen->new );
 $stream = "";
 $term->clear( Tickit::Pen->new( bg => 2 ) );
@@ -134,6 +166,28 @@ $stream = "";
 $term->setctl_int( mouse => 0 );
 stream_is( "\e[?1002l\e[?1006l", '$term->setctl_int( mouse => 0 )' );
 
+$stream = "";
+ok( $term->setctl_int( sync_output => 1 ), '$term->setctl_int( sync_output => 1 ) succeeds' );
+is( $term->getctl_int( 'sync_output' ), 1, '$term->getctl_int( sync_output ) after set' );
+stream_is( "", '$term->setctl_int( sync_output => 1 ) sends nothing without DECRQM support' );
+$term->setctl_int( sync_output => 0 );
+
+$term->goto( 4, 0 );
+$term->setctl_int( sync_output => 1 );
+$term->setctl_int( cursorvis => 0 );
+$stream = "";
+$term->goto( 4, 0 );
+stream_is( "", '$term->goto( 4, 0 ) after setctl_int( cursorvis ) still knows the cursor position' );
+$term->setctl_int( sync_output => 0 );
+$term->setctl_int( cursorvis => 1 );
+
+$term->setctl_int( altscreen => 1 );
+$stream = "";
+$term->goto( 4, 0 );
+stream_is( "\e[5H", '$term->goto( 4, 0 ) after setctl_int( altscreen ) does not assume cursor position' );
+$term->setctl_int( altscreen => 0 );
+$stream = "";
+
 # Reset the pen
 $term->setpen;
 stream_is( "\e[m", '$term->setpen()' );
@@ -178,6 +232,101 @@ stream_is( "\e[4m", '$term->chpen( Tickit::Pen )' );
 $term->setpen( Tickit::Pen->new( i => 1 ) );
 stream_is( "\e[24;3m", '$term->setpen( Tickit::Pen )' );
 
+# Erases pick the shortest sequence available
+{
+   $term->setpen;
+   $term->goto( 3, 70 );
+   $stream = "";
+   $term->erasech( 10, undef );
+   stream_is( "\e[K", '$term->erasech to the right margin uses EL' );
+
+   $term->setpen( rv => 1 );
+   $term->goto( 3, 0 );
+   $stream = "";
+   $term->erasech( 300, undef );
+   stream_is( " " x 300, '$term->erasech in reverse video writes spaces' );
+
+   is( $term->getctl_int( 'bce' ), 1, '$term->getctl_int( bce )' );
+
+   require Tickit::RenderBuffer;
+   my $rb = Tickit::RenderBuffer->new( lines => 25, cols => 80 );
+
+   $rb->clear( Tickit::Pen->new( bg => 4 ) );
+   $stream = "";
+   $rb->flush_to_term( $term );
+   stream_is( "\e[44;27m\e[2J", 'RenderBuffer flush of a whole-screen erase uses ED' );
+
+   $rb->erase_at( 5, 0, 80 );
+   $rb->text_at( 6, 0, "Hi" );
+   $stream = "";
+   $rb->flush_to_term( $term );
+   stream_is( "\e[6H\e[m\e[K\e[7HHi", 'RenderBuffer flush of a whole-line erase uses EL' );
+
+   $term->setpen;
+   $stream = "";
+}
+
+# Fan-out of one RenderBuffer to several terminals
+{
+   my @out = ( "" ) x 3;
+   my @terms = map {
+      my $idx = $_;
+      my $t = Tickit::Term->new( writer => bless \$out[$idx], "BufWriter" );
+      $t->set_size( 25, 80 );
+      $t->setpen;
+      $t;
+   } 0 .. 2;
+   $terms[2]->setpen( b => 1 );
+   $_ = "" for @out;
+
+   require Tickit::RenderBuffer;
+   my $rb = Tickit::RenderBuffer->new( lines => 25, cols => 80 );
+
+   $rb->text_at( 2, 4, "Hello", Tickit::Pen->new( fg => 1 ) );
+   $rb->flush_to_terms( @terms );
+
+   is_hexstr( $out[0], "\e[3;5H\e[31mHello", 'flush_to_terms output to first terminal' );
+   is_hexstr( $out[1], $out[0], 'flush_to_terms copies output to an equivalent terminal' );
+   is_hexstr( $out[2], "\e[3;5H\e[31;22mHello", 'flush_to_terms output to a terminal with a different pen' );
+
+   $_ = "" for @out;
+   $rb->text_at( 3, 0, "X" );
+   $rb->flush_to_terms( @terms );
+   is_hexstr( $out[1], $out[0], 'mirrored terminal keeps the same pen and cursor state' );
+   is_hexstr( $out[2], $out[0], 'terminals with the same state again share output' );
+
+   $rb->set_retained( 1 );
+   $rb->text_at( 0, 0, "ABC" );
+   $rb->flush_to_terms( @terms[0,1] );
+   $terms[2]->setpen( u => 1 );
+   $rb->flush_to_terms( @terms );
+
+   $_ = "" for @out;
+   $rb->text_at( 0, 0, "ABD" );
+   $rb->flush_to_terms( @terms );
+   is_hexstr( $out[0], "\bD", 'retained flush_to_terms sends only changes' );
+   is_hexstr( $out[1], $out[0], 'retained flush_to_terms copies output to an equivalent terminal' );
+   is_hexstr( $out[2], "\e[1;3H\e[mD", 'retained flush_to_terms sends the same changes to each set' );
+}
+
+# Output counters
+{
+   $stream = "";
+   my $before = $term->stats;
+
+   $term->goto( 2, 3 );
+   $term->setpen( b => 1 );
+   $term->setpen( b => 1 );
+   $term->print( "Hello" );
+
+   my $after = $term->stats;
+   my %delta = map { $_ => $after->{$_} - $before->{$_} } keys %$after;
+
+   is( $delta{gotos},   1, '$term->stats counts gotos' );
+   is( $delta{setpens}, 1, '$term->stats counts only pen changes that output' );
+   is( $delta{bytes}, length $stream, '$term->stats counts output bytes' );
+}
+
 is_oneref( $term, '$term has refcount 1 before EOF' );
 undef $term;
 
@@ -190,4 +339,34 @@ undef $term;
    is( $term->get_output_handle, $wr, '$term->get_output_handle is $wr' );
 }
 
+# Output a non-blocking handle won't yet accept is queued
+{
+   pipe( my $rd, my $wr ) or die "pipe() - $!";
+   $rd->blocking( 0 );
+   $wr->blocking( 0 );
+
+   my $term = Tickit::Term->new( output_handle => $wr );
+   $term->set_output_buffer( 4096 );
+   $term->flush;
+   sysread( $rd, my $buffer, 8192 );
+
+   is( $term->output_pending, 0, '$term->output_pending initially 0' );
+
+   # Much more than a pipe will hold
+   my $text = join "", map { sprintf "%07d\n", $_ } 1 .. 65536;
+   $term->print( $text );
+   $term->flush;
+
+   ok( $term->output_pending > 0, '$term->output_pending non-zero once pipe is full' );
+
+   my $got = "";
+   while( length $got < length $text ) {
+      sysread( $rd, $got, 65536, length $got ) or
+         $term->output_writable;
+   }
+
+   is( $term->output_pending, 0, '$term->output_pending 0 after output_writable' );
+   ok( $got eq $text, 'queued output is written in order' );
+}
+
 done_testing;
@@ -84,6 +84,41 @@ is( $term->check_timeout, undef, '$term has no timeout after timedout' );
 is( $type, "key",    '$type after push_bytes after timedout' );
 is( $str,  "Escape", '$str after push_bytes after timedout' );
 
+# Mouse coalescing
+{
+   my @mouse;
+   my $id = $term->bind_event( mouse => sub {
+      my ( undef, undef, $args ) = @_;
+      push @mouse, [ map { "$_" } @{$args}{qw( type button line col )}, $args->{count} // () ];
+   } );
+
+   ok( !$term->get_mouse_coalesce, 'Mouse coalescing initially disabled' );
+
+   my $input = "\e[<0;1;1M" .                            # press
+               "\e[<32;2;1M\e[<32;3;1M\e[<32;4;1M" .     # drags
+               "\e[<0;4;1m" .                            # release
+               "\e[<64;5;2M" x 3 . "\e[<65;5;2M";         # wheel
+
+   $term->input_push_bytes( $input );
+   is( scalar @mouse, 9, 'Every mouse event delivered without coalescing' );
+
+   $term->set_mouse_coalesce( 1 );
+   ok( $term->get_mouse_coalesce, 'Mouse coalescing enabled' );
+
+   undef @mouse;
+   $term->input_push_bytes( $input );
+   is_deeply( \@mouse,
+      [ [ press   => 1, 0, 0 ],
+        [ drag    => 1, 0, 3 ],
+        [ release => 1, 0, 3 ],
+        [ wheel   => "up",   1, 4, 3 ],
+        [ wheel   => "down", 1, 4, 1 ] ],
+      'Drags and wheel steps coalesced between presses and releases' );
+
+   $term->set_mouse_coalesce( 0 );
+   $term->unbind_event_id( $id );
+}
+
 # Legacy event handling
 {
    my ( $type, $str );
@@ -101,4 +101,30 @@ $term->erasech( 5, undef );
 is_display( [ "ABC     IJ", "ABCDEFGHIJ", "ABCDEFGHIJ" ],
             'Display after ->erasech' );
 
+$term->goto( 2, 0 );
+$term->setpen( Tickit::Pen->new( fg => 2 ) );
+$term->print( "XY" );
+$term->setpen( Tickit::Pen->new );
+drain_termlog;
+
+is_deeply( [ $term->get_display_pens( 2, 0, 3 ) ],
+           [ { fg => 2 }, { fg => 2 }, { fg => 3, bg => 6 } ],
+           '$term->get_display_pens' );
+
+# Method log limits
+{
+   my $term = Tickit::Test::MockTerm->new( lines => 3, cols => 10, log_limit => 2 );
+
+   $term->goto( 0, $_ ) for 1 .. 5;
+   is_deeply( [ $term->get_methodlog ], [ GOTO(0,4), GOTO(0,5) ],
+              'Limited method log keeps the most recent entries' );
+
+   $term->set_log_limit( 0 );
+   $term->goto( 1, 0 );
+   $term->print( "Hello" );
+   is_deeply( [ $term->get_methodlog ], [],
+              'Disabled method log stays empty' );
+   is( $term->get_display_text( 1, 0, 5 ), "Hello", 'Display still updated with log disabled' );
+}
+
 done_testing;
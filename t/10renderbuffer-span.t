@@ -241,6 +241,21 @@ is( $rb->cols,  20, '$rb->cols' );
               'RenderBuffer renders eraserect' );
 }
 
+# Counters
+{
+   my $before = $rb->stats;
+
+   $rb->text_at( 0, 0, "Hello", Tickit::Pen->new );
+   $rb->erase_at( 1, 0, 4, Tickit::Pen->new );
+   $rb->flush_to_term( $term );
+   drain_termlog;
+
+   my $after = $rb->stats;
+   is( $after->{spans}         - $before->{spans},          2, '$rb->stats counts spans' );
+   is( $after->{text_bytes}    - $before->{text_bytes},     5, '$rb->stats counts text bytes' );
+   is( $after->{cells_flushed} - $before->{cells_flushed},  9, '$rb->stats counts flushed cells' );
+}
+
 # Clear
 {
    $rb->clear( Tickit::Pen->new( bg => 3 ) );
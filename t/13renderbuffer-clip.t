@@ -109,4 +109,19 @@ my $rb = Tickit::RenderBuffer->new(
               'RenderBuffer clipping rectangle translated' );
 }
 
+# long text clipped, in void and scalar context
+{
+   my $text = join "", map { chr( ord("a") + $_ % 26 ) } 0 .. 999;
+
+   $rb->clip( Tickit::Rect->new( top => 0, left => 2, lines => 2, cols => 6 ) );
+
+   $rb->text_at( 0, 0, $text );
+   is( scalar $rb->text_at( 1, 0, $text ), 1000, '->text_at in scalar context returns full width' );
+
+   $rb->flush_to_term( $term );
+   is_termlog( [ GOTO(0,2), SETPEN(), PRINT("cdefgh"),
+                 GOTO(1,2), SETPEN(), PRINT("cdefgh") ],
+              'RenderBuffer long text clipped the same in both contexts' );
+}
+
 done_testing;
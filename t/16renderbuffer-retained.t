@@ -0,0 +1,180 @@
+#!/usr/bin/perl
+
+use strict;
+use warnings;
+use utf8;
+
+use Test::More;
+use Tickit::Test;
+
+use Tickit::RenderBuffer qw( LINE_SINGLE LINE_DOUBLE );
+
+use Tickit::Pen;
+use Tickit::Rect;
+
+my $term = mk_term;
+
+my $rb = Tickit::RenderBuffer->new(
+   lines    => 10,
+   cols     => 20,
+   retained => 1,
+);
+
+ok( $rb->is_retained, '$rb->is_retained' );
+
+my $pen = Tickit::Pen->new( fg => 1 );
+
+sub draw
+{
+   my ( $text ) = @_;
+   $rb->text_at( 0, 0, $text );
+   $rb->erase_at( 1, 0, 10 );
+   $rb->text_at( 1, 2, "abc", $pen );
+}
+
+# First flush sends everything
+{
+   draw( "Hello world" );
+   $rb->flush_to_term( $term );
+   is_termlog( [ GOTO(0,0), SETPEN(), PRINT("Hello world"),
+                 GOTO(1,0), SETPEN(), ERASECH(2,1),
+                            SETPEN(fg=>1), PRINT("abc"),
+                            SETPEN(), ERASECH(5,undef) ],
+               'Initial flush renders all content' );
+}
+
+# Identical content sends nothing
+{
+   draw( "Hello world" );
+   $rb->flush_to_term( $term );
+   is_termlog( [],
+               'Identical flush renders nothing' );
+}
+
+# Only changed cells are sent
+{
+   draw( "Hexlo World" );
+   $rb->flush_to_term( $term );
+   is_termlog( [ GOTO(0,2), SETPEN(), PRINT("xlo W") ],
+               'Changed text renders differing cells, reprinting short gaps' );
+
+   draw( "Hexlo_WorlD" );
+   $rb->flush_to_term( $term );
+   is_termlog( [ GOTO(0,5), SETPEN(), PRINT("_"),
+                 GOTO(0,10), SETPEN(), PRINT("D") ],
+               'Changed text renders only differing cells' );
+
+   $rb->text_at( 1, 2, "abc", Tickit::Pen->new( fg => 2 ) );
+   $rb->flush_to_term( $term );
+   is_termlog( [ GOTO(1,2), SETPEN(fg=>2), PRINT("abc") ],
+               'Changed pen renders cells again' );
+}
+
+# Wide characters
+{
+   $rb->text_at( 2, 0, "日本語" );
+   $rb->flush_to_term( $term );
+   drain_termlog;
+
+   $rb->text_at( 2, 1, "x" );
+   $rb->flush_to_term( $term );
+   is_termlog( [ GOTO(2,1), SETPEN(), PRINT("x") ],
+               'Overwriting half of a wide character' );
+
+   $rb->text_at( 2, 0, "日本語" );
+   $rb->flush_to_term( $term );
+   is_termlog( [ GOTO(2,0), SETPEN(), PRINT("日") ],
+               'Wide character redrawn after partial overwrite' );
+}
+
+# Lines
+{
+   $rb->hline_at( 3, 0, 5, LINE_SINGLE );
+   $rb->flush_to_term( $term );
+   drain_termlog;
+
+   $rb->hline_at( 3, 0, 5, LINE_SINGLE );
+   $rb->hline_at( 3, 3, 5, LINE_DOUBLE );
+   $rb->flush_to_term( $term );
+   is_termlog( [ GOTO(3,3), SETPEN(), PRINT("╼━╸") ],
+               'Changed line segments only' );
+}
+
+# Invalidation
+{
+   $rb->invalidate( Tickit::Rect->new( top => 0, left => 3, lines => 1, cols => 4 ) );
+   draw( "Hexlo_WorlD" );
+   $rb->flush_to_term( $term );
+   is_termlog( [ GOTO(0,3), SETPEN(), PRINT("lo_W"),
+                 GOTO(1,2), SETPEN(fg=>1), PRINT("abc") ],
+               'Invalidated rect is rendered again' );
+
+   $rb->invalidate;
+   $rb->text_at( 0, 0, "Hexlo" );
+   $rb->flush_to_term( $term );
+   is_termlog( [ GOTO(0,0), SETPEN(), PRINT("Hexlo") ],
+               'Whole buffer invalidated' );
+}
+
+# Scrolling
+{
+   my $rb = Tickit::RenderBuffer->new(
+      lines    => 5,
+      cols     => 80,
+      retained => 1,
+   );
+
+   sub draw_lines
+   {
+      my ( $first ) = @_;
+      foreach my $line ( 0 .. 4 ) {
+         $rb->erase_at( $line, 0, 80 );
+         $rb->text_at( $line, 0, "Line " . ( $first + $line ) );
+      }
+   }
+
+   draw_lines( 1 );
+   $rb->flush_to_term( $term );
+   drain_termlog;
+
+   draw_lines( 2 );
+   $rb->flush_to_term( $term );
+   is_termlog( [ SCROLLRECT(0,0,5,80, 1,0),
+                 GOTO(4,0), SETPEN(), PRINT("Line 6"), SETPEN(), ERASECH(74,undef) ],
+               'Content moved upwards is scrolled' );
+
+   draw_lines( 1 );
+   $rb->flush_to_term( $term );
+   is_termlog( [ SCROLLRECT(0,0,5,80, -1,0),
+                 GOTO(0,0), SETPEN(), PRINT("Line 1"), SETPEN(), ERASECH(74,undef) ],
+               'Content moved downwards is scrolled' );
+
+   $rb->text_at( $_, 0, "Line " . ( $_ + 2 ) ) for 0 .. 3;
+   $rb->flush_to_term( $term );
+   is_termlog( [ GOTO(0,5), SETPEN(), PRINT("2"),
+                 GOTO(1,5), SETPEN(), PRINT("3"),
+                 GOTO(2,5), SETPEN(), PRINT("4"),
+                 GOTO(3,5), SETPEN(), PRINT("5") ],
+               'Lines not fully drawn are not scrolled' );
+}
+
+# Resizing forgets the terminal content
+{
+   $rb->text_at( 0, 0, "Pending" );
+   $rb->resize( 3, 8 );
+
+   is( $rb->lines, 3, '$rb->lines after resize' );
+   is( $rb->cols,  8, '$rb->cols after resize' );
+
+   $rb->text_at( 0, 0, "Hello world" );
+   $rb->flush_to_term( $term );
+   is_termlog( [ GOTO(0,0), SETPEN(), PRINT("Hello wo") ],
+               'Flush after resize clips to the new size and ignores pending content' );
+
+   $rb->text_at( 0, 0, "Hello wo" );
+   $rb->flush_to_term( $term );
+   is_termlog( [],
+               'Buffer remains retained after resize' );
+}
+
+done_testing;
@@ -0,0 +1,102 @@
+#!/usr/bin/perl
+
+use strict;
+use warnings;
+use utf8;
+
+use Test::More;
+use Tickit::Test;
+
+use Tickit::RenderBuffer qw( LINE_SINGLE );
+
+use Tickit::Pen;
+use Tickit::Rect;
+
+my $term = mk_term;
+
+my $rb = Tickit::RenderBuffer->new(
+   lines => 10,
+   cols  => 20,
+);
+
+my $src = Tickit::RenderBuffer->new(
+   lines => 3,
+   cols  => 10,
+);
+
+my $pen = Tickit::Pen->new( fg => 1 );
+
+sub draw_src
+{
+   $src->text_at( 0, 0, "Hello world", $pen );
+   $src->erase_at( 1, 2, 4 );
+   $src->char_at( 1, 8, 0x41 );
+   $src->hline_at( 2, 0, 3, LINE_SINGLE );
+}
+
+my $all = Tickit::Rect->new( top => 0, left => 0, lines => 3, cols => 10 );
+
+# Whole buffer
+{
+   draw_src;
+   $rb->blit( $src, $all, 2, 5 );
+
+   $rb->flush_to_term( $term );
+   is_termlog( [ GOTO(2,5), SETPEN(fg=>1), PRINT("Hello worl"),
+                 GOTO(3,7), SETPEN(), ERASECH(4,0),
+                    GOTO(3,13), SETPEN(), PRINT("A"),
+                 GOTO(4,5), SETPEN(), PRINT("╶──╴") ],
+               'blit copies all kinds of cell' );
+
+   $src->flush_to_term( $term );
+   drain_termlog;
+}
+
+# Part of the source, clipped and masked in the destination
+{
+   draw_src;
+
+   $rb->clip( Tickit::Rect->new( top => 0, left => 0, lines => 10, cols => 6 ) );
+   $rb->mask( Tickit::Rect->new( top => 0, left => 4, lines => 1, cols => 2 ) );
+   $rb->blit( $src, Tickit::Rect->new( top => 0, left => 3, lines => 2, cols => 6 ), 0, 1 );
+
+   $rb->flush_to_term( $term );
+   is_termlog( [ GOTO(0,1), SETPEN(fg=>1), PRINT("lo "),
+                 GOTO(1,1), SETPEN(), ERASECH(3,undef) ],
+               'blit of a sub-rectangle respects destination clip and mask' );
+
+   $src->flush_to_term( $term );
+   drain_termlog;
+}
+
+# Translation, and merging with the destination pen
+{
+   draw_src;
+
+   $rb->translate( 1, 1 );
+   $rb->setpen( Tickit::Pen->new( fg => 2, b => 1 ) );
+   $rb->blit( $src, Tickit::Rect->new( top => 0, left => 0, lines => 2, cols => 5 ), 0, 0 );
+
+   $rb->flush_to_term( $term );
+   is_termlog( [ GOTO(1,1), SETPEN(fg=>1,b=>1), PRINT("Hello"),
+                 GOTO(2,3), SETPEN(fg=>2,b=>1), ERASECH(3,undef) ],
+               'blit is translated and merges the destination pen' );
+
+   $src->flush_to_term( $term );
+   drain_termlog;
+}
+
+# Skipped source cells leave the destination alone
+{
+   $rb->text_at( 0, 0, "1234567890" );
+   $src->text_at( 0, 2, "ab" );
+   $rb->blit( $src, $all, 0, 0 );
+
+   $rb->flush_to_term( $term );
+   is_termlog( [ GOTO(0,0), SETPEN(), PRINT("12"), SETPEN(), PRINT("ab"), SETPEN(), PRINT("567890") ],
+               'blit does not overwrite with skipped cells' );
+
+   $src->reset;
+}
+
+done_testing;
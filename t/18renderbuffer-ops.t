@@ -0,0 +1,194 @@
+#!/usr/bin/perl
+
+use strict;
+use warnings;
+use utf8;
+
+use Test::More;
+use Test::Fatal;
+use Tickit::Test;
+
+use Tickit::RenderBuffer qw( LINE_SINGLE CAP_BOTH );
+
+use Tickit::Pen;
+use Tickit::Rect;
+
+my $term = mk_term;
+
+my $rb = Tickit::RenderBuffer->new(
+   lines => 10,
+   cols  => 20,
+);
+
+my $pen = Tickit::Pen->new( fg => 1 );
+
+my @ops = (
+   [ save => ],
+   [ translate => 1, 2 ],
+   [ setpen => Tickit::Pen->new( b => 1 ) ],
+   [ text_at => 0, 0, "Hello world", $pen ],
+   [ erase_at => 1, 0, 4 ],
+   [ goto => 2, 0 ],
+   [ text => "ab" ],
+   [ skip => 2 ],
+   [ char => 0x41, $pen ],
+   [ erase_to => 8 ],
+   [ restore => ],
+   [ hline_at => 5, 0, 4, LINE_SINGLE, undef, CAP_BOTH ],
+   [ eraserect => Tickit::Rect->new( top => 6, left => 0, lines => 2, cols => 3 ) ],
+   [ goto => undef, undef ],
+);
+
+sub draw_methods
+{
+   $rb->save;
+   $rb->translate( 1, 2 );
+   $rb->setpen( Tickit::Pen->new( b => 1 ) );
+   $rb->text_at( 0, 0, "Hello world", $pen );
+   $rb->erase_at( 1, 0, 4 );
+   $rb->goto( 2, 0 );
+   $rb->text( "ab" );
+   $rb->skip( 2 );
+   $rb->char( 0x41, $pen );
+   $rb->erase_to( 8 );
+   $rb->restore;
+   $rb->hline_at( 5, 0, 4, LINE_SINGLE, undef, CAP_BOTH );
+   $rb->eraserect( Tickit::Rect->new( top => 6, left => 0, lines => 2, cols => 3 ) );
+   $rb->goto( undef, undef );
+}
+
+draw_methods;
+$rb->flush_to_term( $term );
+my $expect = [ $term->get_methodlog ];
+ok( scalar @$expect, 'method calls drew something' );
+
+# Display list gives the same output as the method calls
+{
+   $rb->apply_ops( \@ops );
+
+   ok( !defined $rb->line, 'apply_ops leaves cursor as the last goto op' );
+
+   $rb->flush_to_term( $term );
+   is_termlog( [ @$expect ], 'apply_ops output matches individual method calls' );
+}
+
+# A cached list can be replayed
+{
+   $rb->apply_ops( \@ops ) for 1 .. 2;
+
+   $rb->flush_to_term( $term );
+   is_termlog( [ @$expect ], 'apply_ops replays a cached list' );
+
+   $rb->apply_ops( [] );
+   $rb->flush_to_term( $term );
+   is_termlog( [], 'apply_ops on an empty list draws nothing' );
+}
+
+# Errors
+{
+   like( exception { $rb->apply_ops( [ [ frobnicate => 1 ] ] ) },
+         qr/^apply_ops: op 0 has unrecognised name 'frobnicate' /,
+         'unknown op fails' );
+
+   like( exception { $rb->apply_ops( [ [ save => ], [ erase_at => 1, 2 ] ] ) },
+         qr/^apply_ops: op 1 \(erase_at\) takes 3 to 4 arguments, not 2 /,
+         'wrong argument count fails' );
+
+   like( exception { $rb->apply_ops( [ "save" ] ) },
+         qr/^apply_ops: op 0 is not an ARRAY reference /,
+         'non-ARRAY op fails' );
+
+   like( exception { $rb->apply_ops( [ [ text_at => 0, 0, "x", "red" ] ] ) },
+         qr/^apply_ops: op 0 pen is not of type Tickit::Pen /,
+         'non-pen pen fails' );
+
+   like( exception { $rb->apply_ops( [ [ text => "x" ] ] ) },
+         qr/^Cannot ->text without a virtual cursor position /,
+         'text without cursor fails as the method does' );
+
+   $rb->reset;
+}
+
+# Tiled rendering draws the same cells as drawing each tile clipped in turn
+{
+   my $red  = Tickit::Pen->new( fg => 1 );
+   my $blue = Tickit::Pen->new( bg => 4, u => 1 );
+
+   sub tile_ops
+   {
+      my ( $rect ) = @_;
+      my ( $top, $left ) = ( $rect->top, $rect->left );
+
+      return [
+         [ save => ],
+         [ setpen => $blue ],
+         # Wide glyphs cross the tile's left and right edges
+         [ text_at => $top, $left - 3, "日本語のテキスト $left", $red ],
+         [ erase_at => $top + 1, $left + 2, 30 ],
+         [ mask => Tickit::Rect->new( top => $top + 2, left => $left + 1, lines => 1, cols => 2 ) ],
+         [ hline_at => $top + 2, $left - 2, $left + $rect->cols + 1, LINE_SINGLE, $red, CAP_BOTH ],
+         [ restore => ],
+         [ vline_at => $top - 1, $top + 4, $left + 5, LINE_SINGLE, undef, CAP_BOTH ],
+         [ char_at => $top + 3, $left + $rect->cols - 1, 0x2603, $red ],
+         [ goto => $top + 3, $left ],
+         [ text => "x" ],
+         # A gap of untouched cells, which must leave whatever is beneath
+         [ goto => $top + 3, $left + 3 ],
+         [ erase_to => $left + 4 ],
+      ];
+   }
+
+   sub cells
+   {
+      my ( $rb ) = @_;
+      my @cells;
+      foreach my $line ( 0 .. 11 ) {
+         foreach my $col ( 0 .. 39 ) {
+            my $cell = $rb->get_cell( $line, $col );
+            my $mask = $cell->linemask;
+            my $pen  = $cell->pen;
+            push @cells, join ":", "$line,$col",
+               $cell->char // "SKIP",
+               $mask ? join( "", map { $mask->$_ } qw( north south east west ) ) : "",
+               $pen  ? do { my %a = $pen->getattrs; join ",", map { "$_=$a{$_}" } sort keys %a } : "";
+         }
+      }
+      return \@cells;
+   }
+
+   # Two rows of tiles, plus one overlapping four of them
+   my @rects = (
+      ( map { Tickit::Rect->new( top => 0, left => $_ * 10, lines => 5, cols => 10 ) } 0 .. 3 ),
+      ( map { Tickit::Rect->new( top => 5, left => $_ * 10, lines => 6, cols => 10 ) } 0 .. 3 ),
+      Tickit::Rect->new( top => 3, left => 5, lines => 4, cols => 14 ),
+   );
+
+   my @tiles = map { [ $_, tile_ops( $_ ) ] } @rects;
+
+   foreach my $nthreads ( 1, 4, 2 ) {
+      my ( $seq, $tiled ) = map { Tickit::RenderBuffer->new( lines => 12, cols => 40 ) } 1 .. 2;
+
+      # Something underneath, to show through skipped cells
+      foreach my $rb ( $seq, $tiled ) {
+         $rb->text_at( $_, 0, "-" x 40, Tickit::Pen->new( i => 1 ) ) for 0 .. 11;
+      }
+
+      $seq->apply_ops( [ [ save => ], [ clip => $_->[0] ], @{ $_->[1] }, [ restore => ] ] ) for @tiles;
+
+      $tiled->render_tiled( $nthreads, @tiles ) for 1 .. 2;
+
+      is_deeply( cells( $tiled ), cells( $seq ),
+                 "render_tiled with $nthreads threads matches sequential drawing" );
+   }
+
+   my $tiled = Tickit::RenderBuffer->new( lines => 12, cols => 40 );
+   like( exception { $tiled->render_tiled( 2, [ $rects[0], [ [ text => "x" ] ] ] ) },
+         qr/^Cannot ->text without a virtual cursor position /,
+         'render_tiled tile without cursor fails as the method does' );
+
+   like( exception { $tiled->render_tiled( 2, [ $rects[0] ] ) },
+         qr/^Expected a \[ rect, ops \] pair for argument 2 /,
+         'render_tiled without ops fails' );
+}
+
+done_testing;
@@ -93,6 +93,25 @@ my $win = bless [], "TestWindow";
    undef @methods;
 }
 
+# Split spans
+{
+   my $pen = Tickit::Pen->new;
+
+   $rb->text_at( 0, 0, "ABCDEFGHIJ", $pen );
+   $rb->text_at( 0, 3, "xy", $pen );
+
+   $rb->flush_to_window( $win );
+   is_deeply( \@methods,
+              [
+                 [ goto => 0, 0 ],
+                 [ print => "ABC", {} ],
+                 [ print => "xy", {} ],
+                 [ print => "FGHIJ", {} ],
+              ],
+              'RenderBuffer renders split text spans to window' );
+   undef @methods;
+}
+
 # Simple lines explicit pen
 {
    my $pen = Tickit::Pen->new;
@@ -153,6 +153,19 @@ identical( $win->term, $term, '$win->term returns $term' );
    drain_termlog;
 }
 
+# Frame counters
+{
+   my $before = $win->frame_stats;
+
+   $win->expose;
+   flush_tickit;
+   drain_termlog;
+
+   my $after = $win->frame_stats;
+   is( $after->{frames} - $before->{frames}, 1, '$win->frame_stats counts frames' );
+   ok( $after->{render_time} >= $before->{render_time}, '$win->frame_stats accumulates render_time' );
+}
+
 # geometry change event
 {
    my $geom_changed = 0;
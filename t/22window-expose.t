@@ -4,6 +4,7 @@ use strict;
 use warnings;
 
 use Test::More;
+use Test::Fatal;
 
 use Tickit::Test;
 
@@ -313,6 +314,126 @@ drain_termlog;
                  SETPEN,
                  PRINT("Window C") ],
                  'Termlog for overlapping after $win_C->raise_to_front' );
+
+   $rootwin->set_retained_render( 1 );
+
+   $rootwin->expose;
+   flush_tickit;
+
+   is_termlog( [ GOTO(0,0),
+                 SETPEN,
+                 PRINT("Window C") ],
+                 'Termlog for initial retained render' );
+
+   $rootwin->expose;
+   flush_tickit;
+
+   is_termlog( [],
+               'Termlog empty for unchanged retained render' );
+
+   $win_C->set_on_expose( sub {
+      my ( $win, $rb ) = @_;
+      $rb->text_at( 0, 0, "Window c" );
+   });
+   $win_C->expose;
+   flush_tickit;
+
+   is_termlog( [ GOTO(0,7),
+                 SETPEN,
+                 PRINT("c") ],
+                 'Termlog for changed retained render' );
+
+   $rootwin->set_retained_render( 0 );
+}
+
+# Exceptions from on_expose
+{
+   my $win_A = $rootwin->make_sub( 6, 0, 1, 20 );
+   my $win_B = $rootwin->make_sub( 7, 0, 1, 20 );
+   flush_tickit;
+
+   my $fail = 1;
+   $win_A->set_on_expose( sub {
+      my ( $win, $rb ) = @_;
+      $rb->text_at( 0, 0, "Window A" );
+   });
+   $win_B->set_on_expose( sub {
+      my ( $win, $rb ) = @_;
+      die "Window B failed\n" if $fail;
+      $rb->text_at( 0, 0, "Window B" );
+   });
+   flush_tickit;
+   drain_termlog;
+
+   $fail = 1;
+   $win_A->expose;
+   $win_B->expose;
+
+   is( exception { flush_tickit }, "Window B failed\n",
+      'Exception from on_expose propagates out of flush_tickit' );
+
+   is( $term->getctl_int( 'sync_output' ), 0, 'sync_output is off again after the failed frame' );
+
+   is_termlog( [],
+               'Termlog empty for failed frame' );
+
+   $fail = 0;
+   flush_tickit;
+
+   is_termlog( [ GOTO(6,0),
+                 SETPEN,
+                 PRINT("Window A"),
+                 GOTO(7,0),
+                 SETPEN,
+                 PRINT("Window B") ],
+               'Termlog after the failed frame is drawn again' );
+
+   $win_A->close;
+   $win_B->close;
+   flush_tickit;
+   drain_termlog;
+}
+
+
+# Frame rate limiting
+{
+   my $root_count = $root_exposed;
+
+   # Gut-wrenching; the window's clock stands still long in the past, so the
+   # loop finds any timer already due, and only moves when the test moves it
+   my $now = 1000;
+   no warnings 'redefine';
+   local *Tickit::Window::time = sub { $now };
+
+   $rootwin->set_max_frame_rate( 20 );
+
+   $rootwin->expose;
+   flush_tickit;
+
+   is( $root_exposed, $root_count + 1, 'First frame is drawn immediately' );
+
+   $rootwin->expose( Tickit::Rect->new( top => 0, left => 0, lines => 1, cols => 5 ) );
+   $rootwin->expose( Tickit::Rect->new( top => 2, left => 0, lines => 1, cols => 5 ) );
+   flush_tickit;
+
+   is( $root_exposed, $root_count + 1, 'Exposure soon after a frame is deferred' );
+
+   my $loop = $rootwin->tickit->{loop};
+   is( $loop->timers, 1, 'Deferred frame waits on one timer' );
+
+   $now += 0.01;
+   $loop->run_once( 0 );
+
+   is( $root_exposed, $root_count + 1, 'Deferred frame is not drawn before it is due' );
+   is( $loop->timers, 1, 'Deferred frame still waits on one timer' );
+
+   $now += 0.05;
+   $loop->run_once( 0 );
+
+   is( $root_exposed, $root_count + 3, 'Deferred exposures are drawn together on the next frame' );
+
+   $rootwin->set_max_frame_rate( undef );
+   drain_termlog;
 }
 
 done_testing;
@@ -155,6 +155,38 @@ $rootfloat->show;
 flush_tickit;
 drain_termlog;
 
+# Cached coverage follows geometry and stacking changes
+{
+   $rootfloat->change_geometry( 10, 20, 5, 30 );
+   flush_tickit;
+   drain_termlog;
+
+   is_deeply( [ $root->_get_span_visibility( 10, 10 ) ],
+              [ 1, 10 ], '$root 10,10 visible for 10 columns after moving $rootfloat' );
+
+   $rootfloat->change_geometry( 10, 10, 5, 30 );
+   flush_tickit;
+   drain_termlog;
+
+   my $sub = $root->make_sub( 10, 0, 1, 20 );
+   flush_tickit;
+   drain_termlog;
+
+   is_deeply( [ $sub->_get_span_visibility( 0, 10 ) ],
+              [ 0, 30 ], '$sub 0,10 invisible for 30 columns below $rootfloat' );
+
+   $sub->raise;
+   flush_tickit;
+   drain_termlog;
+
+   is_deeply( [ $sub->_get_span_visibility( 0, 10 ) ],
+              [ 1, 10 ], '$sub 0,10 visible for 10 columns after $sub->raise' );
+
+   $sub->close;
+   flush_tickit;
+   drain_termlog;
+}
+
 # Scrolling with float obscurations
 {
    my @exposed_rects;
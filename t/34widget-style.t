@@ -5,6 +5,7 @@ use warnings;
 
 use Test::More;
 use Test::Fatal;
+use Scalar::Util qw( refaddr );
 
 use Tickit::Test;
 
@@ -74,6 +75,27 @@ BEGIN {
       text => "Altered world";
 }
 
+package PenWidget;
+use base qw( Tickit::Widget );
+use Tickit::Style;
+
+BEGIN {
+   style_definition base =>
+      fg => 4;
+}
+
+use constant WIDGET_PEN_FROM_STYLE => 1;
+
+sub cols  { 1 }
+sub lines { 1 }
+
+sub render_to_rb
+{
+   my $self = shift;
+   my ( $rb ) = @_;
+   $rb->text_at( 0, 0, "Hi" );
+}
+
 package main;
 
 # Code-declared default style
@@ -297,4 +319,50 @@ EOF
        'widget subclass as -copy has altered text' );
 }
 
+# resolved style is shared
+{
+   my $widget1 = StyledWidget->new;
+   my $widget2 = StyledWidget->new;
+
+   is( refaddr $widget1->get_style_pen, refaddr $widget2->get_style_pen,
+       'widgets in the same style state share a style pen' );
+
+   my $pen = $widget1->get_style_pen;
+   $widget1->set_style_tag( active => 1 );
+   isnt( refaddr $widget1->get_style_pen, refaddr $pen, 'style pen differs with style tag set' );
+   $widget1->set_style_tag( active => 0 );
+   is( refaddr $widget1->get_style_pen, refaddr $pen, 'style pen shared again after style tag cleared' );
+
+   my $late = StyledWidget->new( class => "LATE" );
+   is_deeply( { $late->get_style_pen->getattrs }, { fg => 4 }, 'style pen before loading class' );
+
+   Tickit::Style->load_style( "StyledWidget.LATE { fg: 1; }" );
+
+   is_deeply( { $late->get_style_pen->getattrs }, { fg => 1 },
+              'style pen of existing widget after loading its class' );
+}
+
+# loading a style updates existing widgets' pens and display
+{
+   my $widget = PenWidget->new;
+   $widget->set_window( $win->make_sub( 0, 0, 1, 2 ) );
+   flush_tickit;
+
+   is_display( [ [TEXT("Hi",fg=>4)] ], 'display before loading style' );
+
+   Tickit::Style->load_style( "PenWidget { fg: 1; }" );
+
+   is( $widget->pen->getattr( "fg" ), 1, 'widget pen after loading style' );
+
+   flush_tickit;
+   is_display( [ [TEXT("Hi",fg=>1)] ], 'display redrawn after loading style' );
+
+   $widget->set_style_tag( active => 1 );
+   $widget->set_style_tag( active => 0 );
+
+   is( $widget->pen->getattr( "fg" ), 1, 'widget pen unchanged after toggling a tag' );
+
+   $widget->set_window( undef );
+}
+
 done_testing;
@@ -0,0 +1,118 @@
+#!/usr/bin/perl
+
+use strict;
+use warnings;
+
+use Test::More;
+
+use Tickit::Test;
+
+use Tickit::Widget;
+
+my $rootwin = mk_window;
+my $win = $rootwin->make_sub( 2, 2, 3, 20 );
+
+my $renders = 0;
+my $text = "Hello";
+my $widget = TestWidget->new;
+
+$widget->set_window( $win );
+
+flush_tickit;
+
+is( $renders, 1, 'render_to_rb invoked once initially' );
+
+is_display( [ BLANKLINES(2),
+              [BLANK(2), TEXT("Hello")] ],
+            'Display initially' );
+
+# Exposing the window again uses the cached rendering
+{
+   $win->expose;
+   flush_tickit;
+
+   is( $renders, 1, 'render_to_rb not invoked again by expose' );
+
+   is_display( [ BLANKLINES(2),
+                 [BLANK(2), TEXT("Hello")] ],
+               'Display after expose from cache' );
+}
+
+# An overlapping float is drawn over, then uncovered, from the cache
+{
+   my $float = $rootwin->make_float( 2, 4, 1, 2 );
+   $float->set_on_expose( sub {
+      my ( $win, $rb, $rect ) = @_;
+      $rb->text_at( 0, 0, "XX" );
+   });
+   $float->expose;
+   flush_tickit;
+
+   is_display( [ BLANKLINES(2),
+                 [BLANK(2), TEXT("HeXXo")] ],
+               'Display with float over widget' );
+
+   $float->hide;
+   flush_tickit;
+
+   is( $renders, 1, 'render_to_rb not invoked again for float uncovering' );
+
+   is_display( [ BLANKLINES(2),
+                 [BLANK(2), TEXT("Hello")] ],
+               'Display after float hidden' );
+
+   $float->close;
+}
+
+# Redrawing renders afresh
+{
+   $text = "World";
+   $widget->redraw;
+   flush_tickit;
+
+   is( $renders, 2, 'render_to_rb invoked again after redraw' );
+
+   is_display( [ BLANKLINES(2),
+                 [BLANK(2), TEXT("World")] ],
+               'Display after redraw' );
+}
+
+# Pen changes redraw, and the pen still applies
+{
+   $widget->pen->chattr( fg => 2 );
+   flush_tickit;
+
+   is( $renders, 3, 'render_to_rb invoked again after pen change' );
+
+   is_display( [ BLANKLINES(2),
+                 [BLANK(2), TEXT("World",fg=>2), BLANK(15,fg=>2)] ],
+               'Display with pen after pen change' );
+}
+
+# Resizing the window renders afresh
+{
+   $win->resize( 3, 10 );
+   flush_tickit;
+
+   is( $renders, 4, 'render_to_rb invoked again after resize' );
+}
+
+done_testing;
+
+package TestWidget;
+
+use base qw( Tickit::Widget );
+use constant WIDGET_PEN_FROM_STYLE => 1;
+use constant CACHE_RENDER => 1;
+
+sub render_to_rb
+{
+   my $self = shift;
+   my ( $rb, $rect ) = @_;
+
+   $renders++;
+   $rb->text_at( 0, 0, $text );
+}
+
+sub lines { 1 }
+sub cols  { 5 }
@@ -87,6 +87,20 @@ stream_is(
    'root widget rendered'
 );
 
+# Timers fire in time order, not the order they were added
+{
+   my @fired;
+   $tickit->timer( after => 0.02, sub { push @fired, "later" } );
+   $tickit->timer( after => 0.01, sub { push @fired, "sooner" } );
+
+   # Bound by time rather than tick count; if STDIN is already at EOF each
+   # tick returns immediately
+   my $deadline = time + 2;
+   $tickit->tick while @fired < 2 and time < $deadline;
+
+   is_deeply( \@fired, [qw( sooner later )], 'timers fired in time order' );
+}
+
 is_oneref( $tickit, '$tickit has refcount 1 at EOF' );
 
 done_testing;